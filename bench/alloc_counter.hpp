@@ -0,0 +1,20 @@
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// 基准测试用的全局堆分配计数（alloc_counter.cpp 替换全局 operator new/delete）
+struct AllocStats {
+    uint64_t count;  // 分配次数
+    uint64_t bytes;  // 分配字节数
+};
+
+AllocStats alloc_snapshot();
+
+// 统计两次快照之间的分配
+inline AllocStats alloc_diff(const AllocStats& before, const AllocStats& after) {
+    return AllocStats{after.count - before.count, after.bytes - before.bytes};
+}
+
+#endif
@@ -0,0 +1,200 @@
+// 连接池大小 / 数据库延迟扫描：用 FakeDbUserService 模拟数据库，按固定速率（开环）向与服务器相同的
+// DbExecutor 投递登录/注册，对每种延迟分布和每个连接池大小输出吞吐、拒绝数和延迟分位数，用于选择 MAX_DB_CONN
+// bench_fakedb [--rate 5000] [--duration 2] [--warmup 0.5] [--pools 1,2,4,8,16,32,64]
+//              [--threads 0] [--queue 1024] [--register 10] [--connect-us 5000]
+//   --threads  DB 执行器线程数，0 为与连接池大小相同（与 main 中 db_threads = MAX_DB_CONN 一致）
+//   --register 注册请求的百分比，其余为登录
+// 输出 CSV（一行表头 + 每次运行一行），延迟从计划发送时刻算起（不受发送端落后影响），包含排队时间
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include "fake_db_user_service.hpp"
+#include "mysqlpool.hpp"
+#include "db_executor.hpp"
+#include "histogram.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Config {
+    double rate = 5000;         // 每秒投递的请求数
+    double duration_s = 2;      // 每次运行的计量时长
+    double warmup_s = 0.5;      // 计量前的预热（连接池扩容等），不计入结果
+    std::vector<int> pools = {1, 2, 4, 8, 16, 32, 64};
+    int threads = 0;
+    size_t queue = 1024;
+    int register_percent = 10;
+    double connect_us = 5000;
+};
+
+struct Profile {
+    const char* name;
+    DbLatency query;
+};
+
+std::vector<Profile> make_profiles() {
+    return {
+        {"fixed-1ms", DbLatency::fixed(1000)},
+        {"lognormal-1ms", DbLatency::lognormal(1000, 0.5)},
+        {"lognormal-1ms-wide", DbLatency::lognormal(1000, 1.0)},
+        {"spike-1ms-1%-50ms", DbLatency::spikes(1000, 0.01, 50000)},
+        {"lognormal-1ms-fail-1%", DbLatency::lognormal(1000, 0.5).with_failures(0.01)},
+        {"fixed-5ms", DbLatency::fixed(5000)},
+    };
+}
+
+struct Result {
+    uint64_t completed = 0;
+    uint64_t rejected = 0;  // 执行器已满，服务器上返回 503
+    uint64_t errors = 0;    // 数据库繁忙或模拟失败
+    LatencyHistogram latency_us;
+};
+
+void run(const Config& config, const Profile& profile, int pool_size) {
+    PoolConfig pool_config;
+    pool_config.min_conn = std::min(2, pool_size);
+    pool_config.max_conn = pool_size;
+    pool_config.validation_interval_ms = 3600 * 1000;
+    pool_config.keepalive_interval_ms = 3600 * 1000;
+    pool_config.connector = FakeDbUserService::connector(DbLatency::fixed(config.connect_us));
+    connection_pool pool;
+    if (!pool.init(pool_config)) {
+        std::fprintf(stderr, "pool init failed\n");
+        std::exit(1);
+    }
+
+    FakeDbUserService service(pool, profile.query);
+    const int threads = config.threads > 0 ? config.threads : pool_size;
+    Result result;
+    std::atomic<uint64_t> next_user{0};
+
+    const auto start = Clock::now();
+    const auto measure_from = start + std::chrono::duration_cast<Clock::duration>(
+                                          std::chrono::duration<double>(config.warmup_s));
+    const auto end = measure_from + std::chrono::duration_cast<Clock::duration>(
+                                        std::chrono::duration<double>(config.duration_s));
+    const auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / config.rate));
+    {
+        DbExecutor executor(static_cast<size_t>(threads), config.queue);
+        std::atomic<uint64_t> completed{0};
+        std::atomic<uint64_t> errors{0};
+        uint64_t rejected = 0;
+        uint64_t sent = 0;
+        for (auto scheduled = start; scheduled < end; scheduled += interval) {
+            std::this_thread::sleep_until(scheduled);
+            const bool measured = scheduled >= measure_from;
+            const bool is_register = static_cast<int>(sent++ % 100) < config.register_percent;
+            const bool posted = executor.try_post([&, scheduled, measured, is_register]() {
+                bool ok;
+                if (is_register) {
+                    registerRequest req;
+                    req.username = "fake_user_" + std::to_string(next_user.fetch_add(1));
+                    req.password = "password";
+                    ok = service.registerUser(req).success;
+                }
+                else {
+                    loginRequest req;
+                    req.username = "fake_user_0";
+                    req.password = "password";
+                    const loginResult res = service.login(req);
+                    ok = res.success || res.msg == "用户名不存在";
+                }
+                if (!measured) return;
+                result.latency_us.record(static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - scheduled).count()));
+                completed.fetch_add(1, std::memory_order_relaxed);
+                if (!ok) errors.fetch_add(1, std::memory_order_relaxed);
+            });
+            if (!posted && measured) ++rejected;
+        }
+        // 等待已投递的请求执行完（析构时 join）
+        while (executor.inflight() > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        result.completed = completed.load();
+        result.errors = errors.load();
+        result.rejected = rejected;
+    }
+
+    const PoolStats stats = pool.GetStats();
+    const LatencyHistogram& pool_wait = pool.GetWaitHistogram(false);
+    std::printf("%s,%d,%d,%.0f,%.0f,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%d\n",
+                profile.name, pool_size, threads, config.rate,
+                static_cast<double>(result.completed) / config.duration_s,
+                static_cast<unsigned long long>(result.rejected),
+                static_cast<unsigned long long>(result.errors),
+                static_cast<unsigned long long>(result.latency_us.percentile(50)),
+                static_cast<unsigned long long>(result.latency_us.percentile(99)),
+                static_cast<unsigned long long>(result.latency_us.percentile(99.9)),
+                static_cast<unsigned long long>(result.latency_us.max()),
+                static_cast<unsigned long long>(pool_wait.percentile(99)),
+                static_cast<unsigned long long>(stats.timeouts),
+                stats.total);
+    std::fflush(stdout);
+    pool.DestroyPool();
+}
+
+bool parse_pools(const std::string& value, std::vector<int>& pools) {
+    pools.clear();
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        const int size = std::atoi(item.c_str());
+        if (size <= 0) return false;
+        pools.push_back(size);
+    }
+    return !pools.empty();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Config config;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::fprintf(stderr, "missing value for %s\n", arg.c_str());
+            return 2;
+        }
+        const std::string value = argv[++i];
+        if (arg == "--rate") config.rate = std::atof(value.c_str());
+        else if (arg == "--duration") config.duration_s = std::atof(value.c_str());
+        else if (arg == "--warmup") config.warmup_s = std::atof(value.c_str());
+        else if (arg == "--threads") config.threads = std::atoi(value.c_str());
+        else if (arg == "--queue") config.queue = static_cast<size_t>(std::atol(value.c_str()));
+        else if (arg == "--register") config.register_percent = std::atoi(value.c_str());
+        else if (arg == "--connect-us") config.connect_us = std::atof(value.c_str());
+        else if (arg == "--pools") {
+            if (!parse_pools(value, config.pools)) {
+                std::fprintf(stderr, "bad pool list: %s\n", value.c_str());
+                return 2;
+            }
+        } else {
+            std::fprintf(stderr, "unknown option: %s\n", arg.c_str());
+            return 2;
+        }
+    }
+    if (config.rate <= 0 || config.duration_s <= 0) {
+        std::fprintf(stderr, "rate and duration must be positive\n");
+        return 2;
+    }
+
+    spdlog::set_level(spdlog::level::err);
+    std::printf("profile,pool,db_threads,offered_rps,completed_rps,rejected,errors,"
+                "p50_us,p99_us,p999_us,max_us,pool_wait_p99_us,pool_timeouts,connections\n");
+    for (const Profile& profile : make_profiles()) {
+        for (int pool_size : config.pools) {
+            run(config, profile, pool_size);
+        }
+    }
+    return 0;
+}
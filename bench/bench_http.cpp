@@ -0,0 +1,192 @@
+// 请求处理热路径微基准：HttpParser::parse、Router::dispatch、HttpResponser::build_response
+// 分别计时，以及三者串起来（一个请求在网络线程上的处理，不含读写套接字和文件映射）。
+// 每个阶段输出 ns/req、allocs/req 和 bytes/req（堆分配由 alloc_counter 统计）
+// bench_http [iterations]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <spdlog/spdlog.h>
+#include "http_parser.hpp"
+#include "http_responser.hpp"
+#include "router.hpp"
+#include "user_controller.hpp"
+#include "alloc_counter.hpp"
+
+namespace {
+
+// 不访问数据库的用户服务：只有一个用户，登录请求在 bench 中直接执行
+class FixedUserService : public UserService {
+public:
+    loginResult login(const loginRequest& req) override {
+        return check_password(lookupUser(req.username, req.read_primary), req.password);
+    }
+    registerResult registerUser(const registerRequest& req) override {
+        (void)req;
+        return registerResult{false, "用户已存在"};
+    }
+    userRecord lookupUser(const std::string& username, bool read_primary) override {
+        (void)read_primary;
+        userRecord record;
+        record.ok = true;
+        record.found = username == "bench_user";
+        if (record.found) record.password = "bench_password";
+        return record;
+    }
+};
+
+struct Case {
+    const char* name;
+    std::string request;
+    bool valid;  // 是否应解析成功
+};
+
+const char* BROWSER_HEADERS =
+    "Host: 127.0.0.1:8080\r\n"
+    "Connection: keep-alive\r\n"
+    "Cache-Control: max-age=0\r\n"
+    "sec-ch-ua: \"Not_A Brand\";v=\"8\", \"Chromium\";v=\"120\", \"Google Chrome\";v=\"120\"\r\n"
+    "sec-ch-ua-mobile: ?0\r\n"
+    "sec-ch-ua-platform: \"Linux\"\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,image/apng,*/*;q=0.8,"
+    "application/signed-exchange;v=b3;q=0.7\r\n"
+    "Sec-Fetch-Site: same-origin\r\n"
+    "Sec-Fetch-Mode: navigate\r\n"
+    "Sec-Fetch-User: ?1\r\n"
+    "Sec-Fetch-Dest: document\r\n"
+    "Referer: http://127.0.0.1:8080/?error=1\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Accept-Language: zh-CN,zh;q=0.9,en-US;q=0.8,en;q=0.7\r\n"
+    "Cookie: _ga=GA1.1.1234567890.1700000000; _ga_ABCDEF1234=GS1.1.1700000000.3.1.1700000123.0.0.0; "
+    "session=eyJhbGciOiJIUzI1NiIsInR5cCI6IkpXVCJ9.eyJzdWIiOiIxMjM0NTY3ODkwIiwibmFtZSI6ImJlbmNoIiwiaWF0IjoxNTE2MjM5MDIyfQ."
+    "SflKxwRJSMeKKF2QT4fwpMeJf36POk6yJV_adQssw5c; theme=dark; lang=zh-CN; "
+    "csrftoken=9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08; tz=Asia%2FShanghai\r\n";
+
+std::vector<Case> make_corpus() {
+    const std::string form_body = "user=bench_user&password=bench_password&op=login";
+    std::vector<Case> corpus;
+    corpus.push_back({"small-get", "GET / HTTP/1.1\r\nHost: 127.0.0.1:8080\r\n\r\n", true});
+    corpus.push_back({"browser-get", std::string("GET / HTTP/1.1\r\n") + BROWSER_HEADERS + "\r\n", true});
+    corpus.push_back({"browser-favicon", std::string("GET /favicon.ico HTTP/1.1\r\n") + BROWSER_HEADERS + "\r\n", true});
+    corpus.push_back({"form-post",
+                      std::string("POST /welcome HTTP/1.1\r\n") + BROWSER_HEADERS
+                          + "Content-Type: application/x-www-form-urlencoded\r\nContent-Length: "
+                          + std::to_string(form_body.size()) + "\r\n\r\n" + form_body,
+                      true});
+    corpus.push_back({"not-found", "GET /no/such/page?x=1 HTTP/1.1\r\nHost: 127.0.0.1:8080\r\n\r\n", true});
+    corpus.push_back({"bad-request-line", "GARBAGE\r\nHost: 127.0.0.1:8080\r\n\r\n", false});
+    corpus.push_back({"bad-version", "GET / HTTP/9.9\r\nHost: 127.0.0.1:8080\r\n\r\n", false});
+    corpus.push_back({"bad-header", "GET / HTTP/1.1\r\nHost localhost\r\n\r\n", false});
+    corpus.push_back({"bad-bare-lf", "GET / HTTP/1.1\r\nX-A: a\n\r\n", false});
+    corpus.push_back({"bad-length", "POST /welcome HTTP/1.1\r\nHost: 127.0.0.1:8080\r\nContent-Length: 12abc\r\n\r\n",
+                      false});
+    return corpus;
+}
+
+struct Result {
+    double ns = 0;
+    AllocStats allocs{0, 0};
+};
+
+// 对同一输入重复执行 fn，返回平均耗时和分配
+template <typename Fn>
+Result measure(int iterations, Fn fn) {
+    fn();  // 预热（线程局部缓存、输出缓冲区扩容等）
+    const AllocStats before = alloc_snapshot();
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        fn();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    Result result;
+    result.ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+    result.allocs = alloc_diff(before, alloc_snapshot());
+    return result;
+}
+
+void report(const char* name, const char* stage, size_t size, const Result& result, int iterations) {
+    std::printf("%-18s %-8s %5zu B  %9.1f ns/req  %6.3f allocs/req  %8.1f bytes/req\n", name, stage, size,
+                result.ns, static_cast<double>(result.allocs.count) / iterations,
+                static_cast<double>(result.allocs.bytes) / iterations);
+}
+
+// 解析一个请求，请求对象和解析状态与 http_conn 每个新请求开始时相同
+PARSE_STATUS parse(const std::string& buf, HttpRequest& req) {
+    req = HttpRequest();
+    CHECK_STATE state = CHECK_STATE::CHECK_STATE_REQUESTLINE;
+    size_t checked_idx = 0;
+    size_t start_line = 0;
+    return HttpParser::parse(buf, req, state, checked_idx, start_line);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 500000;
+    spdlog::set_level(spdlog::level::off);
+
+    FixedUserService service;
+    UserController controller(service);
+    const Router router(controller);
+
+    // 文件响应体不实际读取，给出一个页面大小的文件信息
+    struct stat file_stat;
+    std::memset(&file_stat, 0, sizeof(file_stat));
+    file_stat.st_size = 4096;
+    static char file_data[4096];
+
+    bool ok = true;
+    for (const Case& c : make_corpus()) {
+        HttpRequest req;
+        const bool parsed = parse(c.request, req) == PARSE_STATUS::SUCCESS;
+        if (parsed != c.valid) {
+            std::fprintf(stderr, "%s: expected parse %s\n", c.name, c.valid ? "success" : "error");
+            ok = false;
+            continue;
+        }
+
+        // 一次完整处理得到处理函数的结果，供单独测量 build_response
+        HttpResponse res;
+        const HTTP_CODE code = parsed ? router.dispatch(req, res) : HTTP_CODE::BAD_REQUEST;
+        const char* path = res.get_required_file_path().c_str();
+        std::string out;
+        out.reserve(4096);  // 与连接复用的输出缓冲区相同，不计入扩容
+
+        // 与 http_conn 相同，请求/处理结果对象在请求之间复用，每个请求开始时重新赋值
+        HttpRequest scratch_req;
+        HttpResponse scratch_res;
+        report(c.name, "parse", c.request.size(), measure(iterations, [&]() {
+            parse(c.request, scratch_req);
+        }), iterations);
+
+        if (parsed) {
+            report(c.name, "route", c.request.size(), measure(iterations, [&]() {
+                scratch_res = HttpResponse();
+                router.dispatch(req, scratch_res);
+            }), iterations);
+        }
+
+        report(c.name, "respond", c.request.size(), measure(iterations, [&]() {
+            out.clear();
+            HttpResponser responser(req, out);
+            responser.build_response(code, req, file_stat, file_data, path, res);
+        }), iterations);
+
+        report(c.name, "total", c.request.size(), measure(iterations, [&]() {
+            scratch_res = HttpResponse();
+            const HTTP_CODE ret = parse(c.request, scratch_req) == PARSE_STATUS::SUCCESS
+                                      ? router.dispatch(scratch_req, scratch_res)
+                                      : HTTP_CODE::BAD_REQUEST;
+            out.clear();
+            HttpResponser responser(scratch_req, out);
+            responser.build_response(ret, scratch_req, file_stat, file_data,
+                                     scratch_res.get_required_file_path(), scratch_res);
+        }), iterations);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,468 @@
+// 端到端压测客户端（wrk 风格）：对运行中的服务器施加负载，输出吞吐和延迟分位数
+// bench_load [--host 127.0.0.1] [--port 8080] [--workload keepalive|pipeline|churn|login|all]
+//            [--connections 64] [--threads 2] [--duration 10] [--warmup 1] [--depth 16]
+//            [--users 1000] [--json FILE] [--tag NAME]
+//   keepalive - 长连接上逐个 GET /
+//   pipeline  - 长连接上每次连续发送 depth 个 GET /，收齐后再发下一批
+//   churn     - 每个请求新建连接（Connection: close），延迟包含建立连接
+//   login     - 长连接上 POST /welcome 登录（用户名 bench_user_0 .. users-1，需预先注册）
+// --json 把每个场景的结果作为一行 JSON 追加到文件（"-" 为标准输出），便于跨版本对比
+#include "asio.hpp"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "histogram.hpp"
+
+using asio::ip::tcp;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+enum class Workload { KEEPALIVE, PIPELINE, CHURN, LOGIN };
+
+const char* workload_name(Workload workload) {
+    switch (workload) {
+        case Workload::KEEPALIVE: return "keepalive";
+        case Workload::PIPELINE: return "pipeline";
+        case Workload::CHURN: return "churn";
+        case Workload::LOGIN: return "login";
+    }
+    return "";
+}
+
+struct Config {
+    std::string host = "127.0.0.1";
+    std::string port = "8080";
+    std::vector<Workload> workloads{Workload::KEEPALIVE};
+    int connections = 64;
+    int threads = 2;
+    double duration_s = 10;
+    double warmup_s = 1;
+    int depth = 16;
+    int users = 1000;
+    std::string json;
+    std::string tag;
+};
+
+// 每个线程一份的结果，结束后由主线程合并
+struct ThreadResult {
+    LatencyHistogram latency_us;
+    uint64_t requests = 0;     // 统计窗口内（预热结束到截止）完成的请求数
+    uint64_t bytes_in = 0;     // 统计窗口内收到的字节数
+    uint64_t errors = 0;       // 连接/读写错误和无法解析的响应
+    std::array<uint64_t, 6> status{};  // 按状态码首位（1xx..5xx），0 为其他
+};
+
+struct Window {
+    Clock::time_point measure_start;  // 预热结束
+    Clock::time_point deadline;       // 之后不再发起新请求
+};
+
+// 从已接收的数据中取出一个完整响应：返回响应总长度，不完整时返回 0，格式错误时返回 -1
+long parse_response(std::string_view data, int& status) {
+    const size_t header_end = data.find("\r\n\r\n");
+    if (header_end == std::string_view::npos) return 0;
+    if (data.size() < 12 || data.compare(0, 5, "HTTP/") != 0) return -1;
+    status = std::atoi(std::string(data.substr(9, 3)).c_str());
+
+    size_t content_length = 0;
+    const std::string_view headers = data.substr(0, header_end);
+    size_t pos = headers.find("\r\n");
+    while (pos != std::string_view::npos && pos < headers.size()) {
+        const size_t next = headers.find("\r\n", pos + 2);
+        const std::string_view line = headers.substr(pos + 2, (next == std::string_view::npos ? headers.size() : next) - pos - 2);
+        constexpr std::string_view NAME = "content-length:";
+        if (line.size() > NAME.size()
+            && std::equal(NAME.begin(), NAME.end(), line.begin(),
+                          [](char a, char b) { return a == std::tolower(static_cast<unsigned char>(b)); })) {
+            content_length = static_cast<size_t>(std::strtoull(std::string(line.substr(NAME.size())).c_str(), nullptr, 10));
+        }
+        pos = next;
+    }
+    const size_t total = header_end + 4 + content_length;
+    return data.size() >= total ? static_cast<long>(total) : 0;
+}
+
+class Client : public std::enable_shared_from_this<Client> {
+public:
+    Client(asio::io_context& io_context, const tcp::resolver::results_type& endpoints, const Config& config,
+           Workload workload, const Window& window, ThreadResult& result)
+        : socket_(io_context), endpoints_(endpoints), config_(config), workload_(workload),
+          window_(window), result_(result) {
+        buffer_.resize(64 * 1024);
+    }
+
+    void start() { connect(); }
+
+private:
+    void connect() {
+        batch_start_ = Clock::now();
+        auto self = shared_from_this();
+        asio::async_connect(socket_, endpoints_, [this, self](std::error_code ec, const tcp::endpoint&) {
+            if (ec) {
+                fail();
+                return;
+            }
+            socket_.set_option(tcp::no_delay(true));
+            send();
+        });
+    }
+
+    void send() {
+        const int count = workload_ == Workload::PIPELINE ? std::max(1, config_.depth) : 1;
+        request_.clear();
+        for (int i = 0; i < count; ++i) {
+            append_request();
+        }
+        outstanding_ = count;
+        if (workload_ != Workload::CHURN) {
+            batch_start_ = Clock::now();  // churn 的延迟从建立连接开始计算
+        }
+        auto self = shared_from_this();
+        asio::async_write(socket_, asio::buffer(request_), [this, self](std::error_code ec, std::size_t) {
+            if (ec) {
+                fail();
+                return;
+            }
+            read();
+        });
+    }
+
+    void append_request() {
+        switch (workload_) {
+            case Workload::KEEPALIVE:
+            case Workload::PIPELINE:
+                request_ += "GET / HTTP/1.1\r\nHost: bench\r\nConnection: keep-alive\r\n\r\n";
+                break;
+            case Workload::CHURN:
+                request_ += "GET / HTTP/1.1\r\nHost: bench\r\nConnection: close\r\n\r\n";
+                break;
+            case Workload::LOGIN: {
+                const int user = static_cast<int>(sequence_++ % static_cast<uint64_t>(std::max(1, config_.users)));
+                const std::string body = "user=bench_user_" + std::to_string(user)
+                                         + "&password=bench_password&op=login";
+                request_ += "POST /welcome HTTP/1.1\r\nHost: bench\r\nConnection: keep-alive\r\n"
+                            "Content-Type: application/x-www-form-urlencoded\r\nContent-Length: "
+                            + std::to_string(body.size()) + "\r\n\r\n" + body;
+                break;
+            }
+        }
+    }
+
+    void read() {
+        auto self = shared_from_this();
+        socket_.async_read_some(asio::buffer(buffer_), [this, self](std::error_code ec, std::size_t length) {
+            if (ec) {
+                fail();
+                return;
+            }
+            received_.append(buffer_.data(), length);
+            on_data(length);
+        });
+    }
+
+    void on_data(size_t length) {
+        const auto now = Clock::now();
+        const bool measured = batch_start_ >= window_.measure_start;
+        // 吞吐只统计截止前完成的请求，截止后排空的在途请求不计入，否则 rps 偏高；
+        // 延迟仍记录窗口内发出的全部请求，不丢掉最慢的尾部
+        const bool counted = measured && now < window_.deadline;
+        if (counted) {
+            result_.bytes_in += length;
+        }
+        size_t consumed = 0;
+        while (outstanding_ > 0) {
+            int status = 0;
+            const long size = parse_response(std::string_view(received_).substr(consumed), status);
+            if (size < 0) {
+                fail();
+                return;
+            }
+            if (size == 0) break;
+            consumed += static_cast<size_t>(size);
+            --outstanding_;
+            if (counted) {
+                ++result_.requests;
+                ++result_.status[status >= 100 && status < 600 ? status / 100 : 0];
+            }
+            if (measured) {
+                result_.latency_us.record(static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::microseconds>(now - batch_start_).count()));
+            }
+        }
+        received_.erase(0, consumed);
+
+        if (outstanding_ > 0) {
+            read();
+            return;
+        }
+        if (now >= window_.deadline) {
+            asio::error_code ignored;
+            socket_.close(ignored);
+            return;
+        }
+        if (workload_ == Workload::CHURN) {
+            asio::error_code ignored;
+            socket_.close(ignored);
+            received_.clear();
+            connect();
+            return;
+        }
+        send();
+    }
+
+    // 连接出错：计数后重新连接（到达截止时间则结束）
+    void fail() {
+        if (Clock::now() >= window_.measure_start) {
+            ++result_.errors;
+        }
+        asio::error_code ignored;
+        socket_.close(ignored);
+        received_.clear();
+        outstanding_ = 0;
+        if (Clock::now() >= window_.deadline) return;
+        auto self = shared_from_this();
+        // 避免服务器拒绝连接时空转
+        auto timer = std::make_shared<asio::steady_timer>(socket_.get_executor(), std::chrono::milliseconds(10));
+        timer->async_wait([this, self, timer](std::error_code) { connect(); });
+    }
+
+private:
+    tcp::socket socket_;
+    const tcp::resolver::results_type& endpoints_;
+    const Config& config_;
+    const Workload workload_;
+    const Window& window_;
+    ThreadResult& result_;
+    std::string request_;
+    std::string received_;
+    std::vector<char> buffer_;
+    int outstanding_ = 0;
+    uint64_t sequence_ = 0;
+    Clock::time_point batch_start_;  // 这批请求开始发送（churn 为开始建立连接）的时间
+};
+
+// 转义 JSON 字符串中的引号、反斜杠和控制字符
+std::string json_escape(std::string_view text) {
+    std::string out;
+    for (const char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                    out += escaped;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out;
+}
+
+// 合并各线程的直方图后取分位数（与 LatencyHistogram::percentile 相同，取桶上界）
+struct Summary {
+    std::array<uint64_t, LatencyHistogram::BUCKETS> buckets{};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+
+    void add(const LatencyHistogram& hist) {
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            buckets[i] += hist.bucket(i);
+        }
+        count += hist.count();
+        sum += hist.sum();
+        max = std::max(max, hist.max());
+    }
+
+    uint64_t percentile(double p) const {
+        if (count == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(count));
+        if (rank >= count) rank = count - 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            seen += buckets[i];
+            if (seen > rank) return std::min(LatencyHistogram::bucket_upper(i), max);
+        }
+        return max;
+    }
+};
+
+bool run(const Config& config, Workload workload) {
+    asio::io_context resolve_context;
+    tcp::resolver resolver(resolve_context);
+    asio::error_code ec;
+    const tcp::resolver::results_type endpoints = resolver.resolve(config.host, config.port, ec);
+    if (ec) {
+        std::fprintf(stderr, "resolve %s:%s failed: %s\n", config.host.c_str(), config.port.c_str(),
+                     ec.message().c_str());
+        return false;
+    }
+
+    const int threads = std::max(1, config.threads);
+    Window window;
+    window.measure_start = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(config.warmup_s));
+    window.deadline = window.measure_start + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(config.duration_s));
+
+    std::vector<std::unique_ptr<ThreadResult>> results;
+    std::vector<std::unique_ptr<asio::io_context>> contexts;
+    for (int t = 0; t < threads; ++t) {
+        results.push_back(std::make_unique<ThreadResult>());
+        contexts.push_back(std::make_unique<asio::io_context>(1));
+    }
+    // 连接轮流分配到各线程，每个线程一个单线程的 io_context
+    for (int i = 0; i < std::max(1, config.connections); ++i) {
+        const int t = i % threads;
+        std::make_shared<Client>(*contexts[t], endpoints, config, workload, window, *results[t])->start();
+    }
+    std::atomic<int> running{threads};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        asio::io_context& context = *contexts[t];
+        workers.emplace_back([&context, &running]() {
+            context.run();
+            running.fetch_sub(1);
+        });
+    }
+    // 截止后等待在途请求完成，服务器无响应时最多再等 DRAIN_GRACE
+    constexpr auto DRAIN_GRACE = std::chrono::seconds(5);
+    while (running.load() > 0 && Clock::now() < window.deadline + DRAIN_GRACE) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    for (auto& context : contexts) {
+        context->stop();
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    // 请求只统计到截止时间，统计窗口恰好是 duration_s
+    const double elapsed = config.duration_s;
+
+    Summary latency;
+    uint64_t requests = 0, bytes_in = 0, errors = 0;
+    std::array<uint64_t, 6> status{};
+    for (const auto& result : results) {
+        latency.add(result->latency_us);
+        requests += result->requests;
+        bytes_in += result->bytes_in;
+        errors += result->errors;
+        for (size_t i = 0; i < status.size(); ++i) {
+            status[i] += result->status[i];
+        }
+    }
+    const double rps = elapsed > 0 ? static_cast<double>(requests) / elapsed : 0;
+    const double mean = latency.count ? static_cast<double>(latency.sum) / static_cast<double>(latency.count) : 0;
+
+    std::printf("%-10s %4d conns  %10.0f req/s  %7.1f MB/s  mean %8.1f us  p50 %7llu us  p99 %7llu us  "
+                "p999 %7llu us  max %7llu us  errors %llu  non-2xx/3xx %llu\n",
+                workload_name(workload), config.connections, rps, static_cast<double>(bytes_in) / elapsed / 1e6, mean,
+                static_cast<unsigned long long>(latency.percentile(50)),
+                static_cast<unsigned long long>(latency.percentile(99)),
+                static_cast<unsigned long long>(latency.percentile(99.9)),
+                static_cast<unsigned long long>(latency.max), static_cast<unsigned long long>(errors),
+                static_cast<unsigned long long>(requests - status[2] - status[3]));
+
+    if (!config.json.empty()) {
+        FILE* out = config.json == "-" ? stdout : std::fopen(config.json.c_str(), "a");
+        if (!out) {
+            std::fprintf(stderr, "cannot open %s\n", config.json.c_str());
+            return false;
+        }
+        std::fprintf(out,
+                     "{\"tag\":\"%s\",\"workload\":\"%s\",\"connections\":%d,\"threads\":%d,\"depth\":%d,"
+                     "\"duration_s\":%.3f,\"requests\":%llu,\"rps\":%.1f,\"bytes_in\":%llu,\"errors\":%llu,"
+                     "\"status\":{\"1xx\":%llu,\"2xx\":%llu,\"3xx\":%llu,\"4xx\":%llu,\"5xx\":%llu,\"other\":%llu},"
+                     "\"latency_us\":{\"mean\":%.1f,\"p50\":%llu,\"p99\":%llu,\"p999\":%llu,\"max\":%llu}}\n",
+                     json_escape(config.tag).c_str(), workload_name(workload), config.connections, threads,
+                     workload == Workload::PIPELINE ? config.depth : 1, elapsed,
+                     static_cast<unsigned long long>(requests), rps, static_cast<unsigned long long>(bytes_in),
+                     static_cast<unsigned long long>(errors),
+                     static_cast<unsigned long long>(status[1]), static_cast<unsigned long long>(status[2]),
+                     static_cast<unsigned long long>(status[3]), static_cast<unsigned long long>(status[4]),
+                     static_cast<unsigned long long>(status[5]), static_cast<unsigned long long>(status[0]), mean,
+                     static_cast<unsigned long long>(latency.percentile(50)),
+                     static_cast<unsigned long long>(latency.percentile(99)),
+                     static_cast<unsigned long long>(latency.percentile(99.9)),
+                     static_cast<unsigned long long>(latency.max));
+        if (out != stdout) std::fclose(out);
+    }
+    return true;
+}
+
+bool parse_workloads(const std::string& value, std::vector<Workload>& workloads) {
+    workloads.clear();
+    if (value == "all") {
+        workloads = {Workload::KEEPALIVE, Workload::PIPELINE, Workload::CHURN, Workload::LOGIN};
+        return true;
+    }
+    size_t start = 0;
+    while (start <= value.size()) {
+        const size_t comma = std::min(value.find(',', start), value.size());
+        const std::string name = value.substr(start, comma - start);
+        bool found = false;
+        for (Workload workload : {Workload::KEEPALIVE, Workload::PIPELINE, Workload::CHURN, Workload::LOGIN}) {
+            if (name == workload_name(workload)) {
+                workloads.push_back(workload);
+                found = true;
+            }
+        }
+        if (!found) return false;
+        start = comma + 1;
+    }
+    return !workloads.empty();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Config config;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::fprintf(stderr, "missing value for %s\n", arg.c_str());
+            return 2;
+        }
+        const std::string value = argv[++i];
+        if (arg == "--host") config.host = value;
+        else if (arg == "--port") config.port = value;
+        else if (arg == "--connections") config.connections = std::atoi(value.c_str());
+        else if (arg == "--threads") config.threads = std::atoi(value.c_str());
+        else if (arg == "--duration") config.duration_s = std::atof(value.c_str());
+        else if (arg == "--warmup") config.warmup_s = std::atof(value.c_str());
+        else if (arg == "--depth") config.depth = std::atoi(value.c_str());
+        else if (arg == "--users") config.users = std::atoi(value.c_str());
+        else if (arg == "--json") config.json = value;
+        else if (arg == "--tag") config.tag = value;
+        else if (arg == "--workload") {
+            if (!parse_workloads(value, config.workloads)) {
+                std::fprintf(stderr, "unknown workload: %s\n", value.c_str());
+                return 2;
+            }
+        } else {
+            std::fprintf(stderr, "unknown option: %s\n", arg.c_str());
+            return 2;
+        }
+    }
+
+    for (Workload workload : config.workloads) {
+        if (!run(config, workload)) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,86 @@
+// 登录延迟基准：每次登录都预处理语句（原实现） vs 使用连接上缓存的预处理语句
+// 需要可访问的 MySQL：bench_login [host] [user] [password] [database] [iterations]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "mysqlpool.hpp"
+#include "user_service.hpp"
+#include "histogram.hpp"
+
+// 原实现：mysql_stmt_init + prepare + execute + close，每次两次往返
+static bool login_uncached(MYSQL* conn, const loginRequest& req) {
+    MYSQL_STMT* stmt = mysql_stmt_init(conn);
+    if (!stmt) return false;
+
+    const char* sql = "SELECT password FROM user WHERE username = ?";
+    bool ok = mysql_stmt_prepare(stmt, sql, strlen(sql)) == 0;
+
+    MYSQL_BIND param_bind;
+    memset(&param_bind, 0, sizeof(param_bind));
+    param_bind.buffer_type = MYSQL_TYPE_STRING;
+    param_bind.buffer = (char*)req.username.c_str();
+    param_bind.buffer_length = req.username.size();
+    ok = ok && mysql_stmt_bind_param(stmt, &param_bind) == 0;
+    ok = ok && mysql_stmt_execute(stmt) == 0;
+    ok = ok && mysql_stmt_store_result(stmt) == 0;
+
+    if (ok) {
+        MYSQL_BIND result_bind;
+        char passwd_buf[256];
+        unsigned long passwd_len = 0;
+        memset(&result_bind, 0, sizeof(result_bind));
+        result_bind.buffer_type = MYSQL_TYPE_STRING;
+        result_bind.buffer = passwd_buf;
+        result_bind.buffer_length = sizeof(passwd_buf);
+        result_bind.length = &passwd_len;
+        mysql_stmt_bind_result(stmt, &result_bind);
+        mysql_stmt_fetch(stmt);
+    }
+    mysql_stmt_close(stmt);
+    return ok;
+}
+
+template <typename Fn>
+static void run(const char* name, int iterations, Fn fn) {
+    LatencyHistogram latency_us;
+    int failures = 0;
+    for (int i = 0; i < iterations; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        if (!fn()) ++failures;
+        latency_us.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count()));
+    }
+    std::printf("%-24s mean %7.1f us  p50 %6llu us  p99 %6llu us  failures %d/%d\n",
+                name, static_cast<double>(latency_us.sum()) / iterations,
+                static_cast<unsigned long long>(latency_us.percentile(50)),
+                static_cast<unsigned long long>(latency_us.percentile(99)), failures, iterations);
+}
+
+int main(int argc, char** argv) {
+    const std::string host = argc > 1 ? argv[1] : "127.0.0.1";
+    const std::string user = argc > 2 ? argv[2] : "root";
+    const std::string password = argc > 3 ? argv[3] : "123456";
+    const std::string database = argc > 4 ? argv[4] : "test";
+    const int iterations = argc > 5 ? std::atoi(argv[5]) : 5000;
+
+    spdlog::set_level(spdlog::level::warn);
+    connection_pool* pool = connection_pool::GetInstance();
+    if (!pool->init(host, user, password, database, 3306, 1, 0)) {
+        return 1;
+    }
+
+    const loginRequest req{"bench_user", "bench_password"};
+    run("prepare per login", iterations, [&]() {
+        connPtr conn = pool->GetConnection();
+        return conn && login_uncached(conn->get(), req);
+    });
+
+    UserServiceMain service;
+    run("cached statement", iterations, [&]() {
+        // 用户不存在时 msg 为"用户名不存在"，仍然是一次完整的查询
+        return !service.login(req).msg.empty();
+    });
+    return 0;
+}
@@ -0,0 +1,120 @@
+// HttpParser 微基准：每个请求的耗时和堆分配次数（分别测试各扫描内核）
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <spdlog/spdlog.h>
+#include "http_parser.hpp"
+#include "http_scan.hpp"
+#include "alloc_counter.hpp"
+
+static const char* TYPICAL_GET =
+    "GET /favicon.ico HTTP/1.1\r\n"
+    "Host: 127.0.0.1:8080\r\n"
+    "Connection: keep-alive\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0 Safari/537.36\r\n"
+    "Accept: image/avif,image/webp,image/apng,image/svg+xml,image/*,*/*;q=0.8\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+    "Referer: http://127.0.0.1:8080/\r\n"
+    "\r\n";
+
+// 带 4 KB Cookie 的请求
+static std::string big_cookie_get() {
+    std::string cookie;
+    for (int i = 0; cookie.size() < 4096; ++i) {
+        cookie += "session_" + std::to_string(i) + "=8f3a9c0e7b1d4f62a5e8c3b9d0f1a2e4; ";
+    }
+    std::string req = TYPICAL_GET;
+    req.insert(req.size() - 2, "Cookie: " + cookie + "\r\n");
+    return req;
+}
+
+// 把请求按字节逐次追加到缓冲区解析（模拟一个请求分多次读到），结果必须与一次读完相同；
+// 覆盖请求行/请求头的 "\r\n" 恰好被拆在两次读取之间的情况
+static bool check_split_reads(const char* name, const std::string& buf) {
+    HttpRequest whole;
+    CHECK_STATE state = CHECK_STATE::CHECK_STATE_REQUESTLINE;
+    size_t checked_idx = 0;
+    size_t start_line = 0;
+    if (HttpParser::parse(buf, whole, state, checked_idx, start_line) != PARSE_STATUS::SUCCESS) {
+        std::fprintf(stderr, "%s: parse failed\n", name);
+        return false;
+    }
+
+    HttpRequest req;
+    state = CHECK_STATE::CHECK_STATE_REQUESTLINE;
+    checked_idx = 0;
+    start_line = 0;
+    for (size_t len = 1; len <= buf.size(); ++len) {
+        const PARSE_STATUS status = HttpParser::parse(std::string_view(buf).substr(0, len), req, state,
+                                                      checked_idx, start_line);
+        const bool last = len == buf.size();
+        if (status != (last ? PARSE_STATUS::SUCCESS : PARSE_STATUS::INCOMPLETE)) {
+            std::fprintf(stderr, "%s: split read at %zu/%zu returned %s\n", name, len, buf.size(),
+                         status == PARSE_STATUS::SUCCESS ? "success" : status == PARSE_STATUS::ERROR ? "error" : "incomplete");
+            return false;
+        }
+    }
+    if (req.get_header_count() != whole.get_header_count() || req.get_content() != whole.get_content()
+        || req.get_url() != whole.get_url()) {
+        std::fprintf(stderr, "%s: split read parsed differently\n", name);
+        return false;
+    }
+    return true;
+}
+
+static bool run(const char* name, const std::string& buf, int iterations) {
+    HttpRequest req;
+    size_t parsed = 0;
+
+    const AllocStats before = alloc_snapshot();
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        req = HttpRequest();
+        CHECK_STATE state = CHECK_STATE::CHECK_STATE_REQUESTLINE;
+        size_t checked_idx = 0;
+        size_t start_line = 0;
+        if (HttpParser::parse(buf, req, state, checked_idx, start_line) == PARSE_STATUS::SUCCESS) {
+            parsed += start_line;
+        }
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const AllocStats allocs = alloc_diff(before, alloc_snapshot());
+
+    if (parsed != buf.size() * static_cast<size_t>(iterations)) {
+        std::fprintf(stderr, "%s: parse failed\n", name);
+        return false;
+    }
+
+    const double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    std::printf("%-8s %-12s %6zu B  %9.1f ns/req  %6.3f allocs/req  %7.1f bytes/req\n",
+                http_scan::kernel_name(http_scan::active_kernel()), name, buf.size(),
+                ns / iterations,
+                static_cast<double>(allocs.count) / iterations,
+                static_cast<double>(allocs.bytes) / iterations);
+    return allocs.count == 0;
+}
+
+int main(int argc, char** argv) {
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    spdlog::set_level(spdlog::level::off);
+
+    const std::string small = TYPICAL_GET;
+    const std::string cookie = big_cookie_get();
+
+    const std::string post = "POST /welcome HTTP/1.1\r\nHost: a\r\nContent-Length: 9\r\n\r\nuser=a&b=";
+
+    bool ok = true;
+    for (http_scan::Kernel kernel : {http_scan::Kernel::SCALAR, http_scan::Kernel::SSE42, http_scan::Kernel::AVX2}) {
+        if (!http_scan::set_kernel(kernel)) {
+            std::printf("%-8s not supported by this CPU\n", http_scan::kernel_name(kernel));
+            continue;
+        }
+        ok = check_split_reads("typical-get", small) && ok;
+        ok = check_split_reads("form-post", post) && ok;
+        ok = run("typical-get", small, iterations) && ok;
+        ok = run("cookie-4k", cookie, iterations / 10) && ok;
+    }
+    return ok ? 0 : 1;
+}
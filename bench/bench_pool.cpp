@@ -0,0 +1,105 @@
+// 连接池竞争基准：1~64 个线程反复获取/归还连接
+// 对比原实现（单把锁 + std::list + std::function 删除器）与槽位 + 线程本地缓存的实现
+// 连接通过 PoolConfig::connector 用未连接的 MYSQL 句柄代替，不需要 MySQL 服务器
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "mysqlpool.hpp"
+#include "alloc_counter.hpp"
+
+// 原实现的获取/归还路径
+class LegacyPool {
+public:
+    using Ptr = std::unique_ptr<MYSQL, std::function<void(MYSQL*)>>;
+
+    explicit LegacyPool(int size) {
+        for (int i = 0; i < size; ++i) {
+            conns_.emplace_back(mysql_init(nullptr), [](MYSQL* conn) { mysql_close(conn); });
+            ++free_;
+        }
+    }
+
+    Ptr get() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this]() { return free_ > 0; });
+        Ptr conn = std::move(conns_.front());
+        conns_.pop_front();
+        MYSQL* raw = conn.release();
+        --free_;
+        return Ptr(raw, [this](MYSQL* c) { release(c); });
+    }
+
+private:
+    void release(MYSQL* conn) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        conns_.emplace_back(conn, [](MYSQL* c) { mysql_close(c); });
+        ++free_;
+        cond_.notify_one();
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::list<Ptr> conns_;
+    int free_ = 0;
+};
+
+template <typename Acquire>
+static void run(const char* name, int threads, int iterations, Acquire acquire) {
+    std::vector<std::thread> workers;
+    const AllocStats before = alloc_snapshot();
+    const auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&]() {
+            for (int i = 0; i < iterations; ++i) {
+                auto conn = acquire();
+                if (!conn) std::abort();
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const AllocStats allocs = alloc_diff(before, alloc_snapshot());
+
+    const double ops = static_cast<double>(threads) * iterations;
+    const double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    std::printf("%-8s threads=%-3d %10.0f ops/s %8.1f ns/op %6.2f allocs/op\n",
+                name, threads, ops / (ns / 1e9), ns / ops,
+                static_cast<double>(allocs.count - static_cast<uint64_t>(threads)) / ops);
+}
+
+int main(int argc, char** argv) {
+    const int pool_size = argc > 1 ? std::atoi(argv[1]) : 16;
+    const int total_ops = argc > 2 ? std::atoi(argv[2]) : 2000000;
+
+    spdlog::set_level(spdlog::level::warn);
+    PoolConfig config;
+    config.min_conn = pool_size;
+    config.max_conn = pool_size;
+    config.acquire_timeout_ms = 60000;
+    config.validation_interval_ms = 3600 * 1000;
+    config.keepalive_interval_ms = 3600 * 1000;
+    config.connector = []() { return mysql_init(nullptr); };
+    connection_pool* pool = connection_pool::GetInstance();
+    if (!pool->init(config)) {
+        return 1;
+    }
+    LegacyPool legacy(pool_size);
+
+    std::printf("pool size %d, %d acquire/release per run\n", pool_size, total_ops);
+    for (int threads : {1, 2, 4, 8, 16, 32, 64}) {
+        const int iterations = total_ops / threads;
+        run("legacy", threads, iterations, [&]() { return legacy.get(); });
+        run("slots", threads, iterations, [&]() { return pool->GetConnection(); });
+    }
+    pool->DestroyPool();
+    return 0;
+}
@@ -0,0 +1,99 @@
+// 注册吞吐基准：逐条 INSERT（每条一次提交） vs 组提交，在不同并发数和等待窗口下的注册数/秒与延迟
+// 需要可访问的 MySQL：bench_register [host] [user] [password] [database] [seconds]
+// 插入的用户名以 bench_reg_ 开头，结束时删除
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include "db_cluster.hpp"
+#include "histogram.hpp"
+#include "register_batcher.hpp"
+#include "user_service.hpp"
+
+struct Result {
+    double per_second;
+    uint64_t failures;
+    uint64_t p50_us;
+    uint64_t p99_us;
+};
+
+static Result run(UserService& service, int threads, double seconds, int run_id) {
+    LatencyHistogram latency;
+    std::atomic<uint64_t> done{0};
+    std::atomic<uint64_t> failures{0};
+    std::atomic<bool> stop{false};
+
+    std::vector<std::thread> workers;
+    const auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            for (uint64_t i = 0; !stop.load(std::memory_order_relaxed); ++i) {
+                const registerRequest req{"bench_reg_" + std::to_string(run_id) + "_" + std::to_string(t) + "_"
+                                              + std::to_string(i),
+                                          "bench_password"};
+                const auto begin = std::chrono::steady_clock::now();
+                const registerResult res = service.registerUser(req);
+                latency.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - begin).count()));
+                if (!res.success) ++failures;
+                ++done;
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return Result{static_cast<double>(done.load()) / elapsed, failures.load(),
+                  latency.percentile(50), latency.percentile(99)};
+}
+
+int main(int argc, char** argv) {
+    const std::string host = argc > 1 ? argv[1] : "127.0.0.1";
+    const std::string user = argc > 2 ? argv[2] : "root";
+    const std::string password = argc > 3 ? argv[3] : "123456";
+    const std::string database = argc > 4 ? argv[4] : "test";
+    const double seconds = argc > 5 ? std::atof(argv[5]) : 3.0;
+
+    const std::vector<int> thread_counts = {1, 4, 16, 64};
+    const std::vector<int> windows_us = {0, 500, 2000, 5000};  // 0 为逐条提交
+
+    spdlog::set_level(spdlog::level::warn);
+    PoolConfig config;
+    config.url = host;
+    config.user = user;
+    config.password = password;
+    config.database = database;
+    config.min_conn = 4;
+    config.max_conn = 8;
+    if (!DbCluster::GetInstance()->init(config, {})) {
+        return 1;
+    }
+
+    UserServiceMain service;
+    std::printf("%-10s %8s %12s %9s %9s %9s\n", "window", "threads", "reg/s", "p50(us)", "p99(us)", "failed");
+    int run_id = 0;
+    for (int window : windows_us) {
+        for (int threads : thread_counts) {
+            // 每次运行新建批处理器，window 为 0 时关闭批处理（max_rows = 1）
+            RegisterBatcher batcher(service, RegisterBatchOptions{window > 0 ? 64u : 1u, window, 2});
+            const Result r = run(batcher, threads, seconds, run_id++);
+            std::printf("%-10s %8d %12.0f %9lu %9lu %9lu\n",
+                        window > 0 ? (std::to_string(window) + "us").c_str() : "off", threads, r.per_second,
+                        static_cast<unsigned long>(r.p50_us), static_cast<unsigned long>(r.p99_us),
+                        static_cast<unsigned long>(r.failures));
+        }
+    }
+
+    connPtr conn = DbCluster::GetInstance()->GetPrimary();
+    if (conn) {
+        const char cleanup[] = "DELETE FROM user WHERE username LIKE 'bench\\_reg\\_%'";
+        mysql_real_query(conn->get(), cleanup, sizeof(cleanup) - 1);
+    }
+    return 0;
+}
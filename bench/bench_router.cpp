@@ -0,0 +1,108 @@
+// 路由微基准：约 1000 条路由下，基数树路由与原 unordered_map + std::function 路由的分发开销对比
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "router.hpp"
+#include "alloc_counter.hpp"
+
+// 原实现：复制 URL，截掉查询串，精确哈希查找
+class MapRouter {
+public:
+    using Handler = std::function<HTTP_CODE(HttpRequest&, HttpResponse&)>;
+
+    void register_route(const std::string& path, Handler handler) {
+        routes[path] = std::move(handler);
+    }
+
+    HTTP_CODE dispatch(HttpRequest& req, HttpResponse& res) {
+        std::string url(req.get_url());
+        size_t pos = url.find('?');
+        if (pos != std::string::npos) {
+            url = url.substr(0, pos);
+        }
+        auto it = routes.find(url);
+        if (it != routes.end()) {
+            return it->second(req, res);
+        }
+        return HTTP_CODE::NO_RESOURCE;
+    }
+
+private:
+    std::unordered_map<std::string, Handler> routes;
+};
+
+static size_t g_hits = 0;
+
+static HTTP_CODE count_hit(void*, HttpRequest&, HttpResponse&) {
+    ++g_hits;
+    return HTTP_CODE::GET_REQUEST;
+}
+
+template <typename Dispatch>
+static void run(const char* name, const std::vector<std::string>& urls, int iterations, Dispatch dispatch) {
+    HttpResponse res;
+    HttpRequest req;
+    req.set_method(HttpRequest::METHOD::GET);
+    g_hits = 0;
+
+    const AllocStats before = alloc_snapshot();
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        req.set_url(urls[static_cast<size_t>(i) % urls.size()]);
+        dispatch(req, res);
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const AllocStats allocs = alloc_diff(before, alloc_snapshot());
+
+    const double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    std::printf("%-28s %8.1f ns/dispatch  %6.3f allocs/dispatch  hits=%zu/%d\n",
+                name, ns / iterations, static_cast<double>(allocs.count) / iterations, g_hits, iterations);
+}
+
+int main(int argc, char** argv) {
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 2000000;
+    const int route_count = 1000;
+
+    // 模拟 REST 接口：20 个服务，每个 50 个资源
+    std::vector<std::string> paths;
+    for (int i = 0; i < route_count; ++i) {
+        paths.push_back("/api/v1/service" + std::to_string(i % 20) + "/resource" + std::to_string(i) + "/items");
+    }
+
+    Router radix;
+    MapRouter map;
+    for (const std::string& path : paths) {
+        radix.register_route(HttpRequest::METHOD::GET, path, RouteHandler{count_hit, nullptr});
+        map.register_route(path, [](HttpRequest& req, HttpResponse& res) { return count_hit(nullptr, req, res); });
+    }
+    radix.register_route(HttpRequest::METHOD::GET, "/api/v1/users/:id/orders/:order", RouteHandler{count_hit, nullptr});
+    radix.register_route(HttpRequest::METHOD::GET, "/static/*path", RouteHandler{count_hit, nullptr});
+
+    // 随机顺序访问，部分带查询串
+    std::vector<std::string> urls;
+    std::mt19937 rng(42);
+    for (int i = 0; i < 4096; ++i) {
+        std::string url = paths[rng() % paths.size()];
+        if (i % 4 == 0) url += "?page=" + std::to_string(i);
+        urls.push_back(url);
+    }
+    std::vector<std::string> param_urls;
+    for (int i = 0; i < 4096; ++i) {
+        param_urls.push_back(i % 2 ? "/api/v1/users/" + std::to_string(i) + "/orders/" + std::to_string(i * 7)
+                                   : "/static/css/site" + std::to_string(i) + ".css");
+    }
+
+    std::printf("routes: %d static + 2 parameterized\n", route_count);
+    run("unordered_map (static)", urls, iterations,
+        [&](HttpRequest& req, HttpResponse& res) { return map.dispatch(req, res); });
+    run("radix tree (static)", urls, iterations,
+        [&](HttpRequest& req, HttpResponse& res) { return radix.dispatch(req, res); });
+    run("radix tree (:param/*wild)", param_urls, iterations,
+        [&](HttpRequest& req, HttpResponse& res) { return radix.dispatch(req, res); });
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include "auth_cache.hpp"
+#include <algorithm>
+#include <ctime>
+#include <functional>
+
+CachingUserService::CachingUserService(UserService& inner, const AuthCacheOptions& options)
+    : m_inner(inner),
+      m_options(options),
+      m_shard_capacity(std::max<size_t>(1, options.capacity / SHARD_COUNT)) {}
+
+int64_t CachingUserService::now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+CachingUserService::Shard& CachingUserService::shard_for(const std::string& username) {
+    return m_shards[std::hash<std::string>{}(username) % SHARD_COUNT];
+}
+
+loginResult CachingUserService::login(const loginRequest& req) {
+    return check_password(lookupUser(req.username, req.read_primary), req.password);
+}
+
+registerResult CachingUserService::registerUser(const registerRequest& req) {
+    registerResult res = m_inner.registerUser(req);
+    // 成功时清除"不存在"的条目；"用户已存在"说明缓存的结果可能过时，同样清除
+    invalidate(req.username);
+    return res;
+}
+
+userRecord CachingUserService::lookupUser(const std::string& username, bool read_primary) {
+    Shard& shard = shard_for(username);
+    const int64_t now = now_ms();
+    uint64_t version;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(username);
+        if (it != shard.entries.end()) {
+            Entry& entry = it->second;
+            if (entry.expires_ms > now && (entry.found || !read_primary)) {
+                shard.lru.splice(shard.lru.begin(), shard.lru, entry.lru);
+                ++(entry.found ? shard.hits : shard.negative_hits);
+                userRecord record;
+                record.ok = true;
+                record.found = entry.found;
+                record.password = entry.password;
+                return record;
+            }
+        }
+        ++shard.misses;
+        version = shard.version;
+    }
+
+    // 查询期间不持有分片锁
+    userRecord record = m_inner.lookupUser(username, read_primary);
+    if (record.ok) {
+        store(shard, username, record, version, now);
+    }
+    return record;
+}
+
+bool CachingUserService::scanUsernames(const std::function<void(std::string_view)>& fn) {
+    return m_inner.scanUsernames(fn);
+}
+
+void CachingUserService::store(Shard& shard, const std::string& username, const userRecord& record,
+                               uint64_t version, int64_t now) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    // 查询期间发生过失效，结果可能是注册之前的，不写入
+    if (shard.version != version) {
+        return;
+    }
+
+    const int64_t expires = now + (record.found ? m_options.ttl_ms : m_options.negative_ttl_ms);
+    auto it = shard.entries.find(username);
+    if (it != shard.entries.end()) {
+        it->second.found = record.found;
+        it->second.password = record.password;
+        it->second.expires_ms = expires;
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru);
+        return;
+    }
+
+    while (shard.entries.size() >= m_shard_capacity) {
+        shard.entries.erase(shard.lru.back());
+        shard.lru.pop_back();
+        ++shard.evictions;
+    }
+    shard.lru.push_front(username);
+    shard.entries.emplace(username, Entry{record.found, record.password, expires, shard.lru.begin()});
+}
+
+void CachingUserService::invalidate(const std::string& username) {
+    Shard& shard = shard_for(username);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    ++shard.version;
+    ++shard.invalidations;
+    auto it = shard.entries.find(username);
+    if (it != shard.entries.end()) {
+        shard.lru.erase(it->second.lru);
+        shard.entries.erase(it);
+    }
+}
+
+AuthCacheStats CachingUserService::GetStats() {
+    AuthCacheStats stats{};
+    for (Shard& shard : m_shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        stats.hits += shard.hits;
+        stats.negative_hits += shard.negative_hits;
+        stats.misses += shard.misses;
+        stats.evictions += shard.evictions;
+        stats.invalidations += shard.invalidations;
+        stats.size += shard.entries.size();
+    }
+    return stats;
+}
@@ -0,0 +1,82 @@
+#ifndef AUTH_CACHE_H
+#define AUTH_CACHE_H
+
+#include <array>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "user_service.hpp"
+
+// 认证缓存参数
+struct AuthCacheOptions {
+    size_t capacity = 10000;      // 缓存的用户数上限（平均分到各分片）
+    int ttl_ms = 60000;           // 已存在用户的凭据缓存时间
+    int negative_ttl_ms = 2000;   // 不存在的用户名缓存时间（较短，注册后尽快可见）
+};
+
+// 认证缓存统计快照
+struct AuthCacheStats {
+    uint64_t hits;            // 命中已存在用户
+    uint64_t negative_hits;   // 命中不存在的用户名
+    uint64_t misses;          // 未命中或已过期，查询下层服务
+    uint64_t evictions;       // 容量不足淘汰的条目
+    uint64_t invalidations;   // 注册导致的失效
+    size_t size;              // 当前条目数
+};
+
+// 装饰 UserService 的认证缓存：按用户名缓存凭据（含"用户不存在"的否定结果），
+// 登录命中时不访问数据库。
+//   - 按用户名哈希分成 SHARD_COUNT 个分片，每个分片一把锁 + LRU，不同用户的请求基本不竞争；
+//   - 注册时使对应用户名的条目失效；失效前已开始的查询结果不再写入缓存（分片版本号校验）；
+//   - read_primary 的请求（刚注册过）不使用否定结果，直接查询下层服务
+class CachingUserService : public UserService {
+public:
+    CachingUserService(UserService& inner, const AuthCacheOptions& options);
+
+    loginResult login(const loginRequest& req) override;
+    registerResult registerUser(const registerRequest& req) override;
+    userRecord lookupUser(const std::string& username, bool read_primary) override;
+    bool scanUsernames(const std::function<void(std::string_view)>& fn) override;
+
+    void invalidate(const std::string& username);
+    AuthCacheStats GetStats();
+
+private:
+    static constexpr size_t SHARD_COUNT = 16;
+
+    struct Entry {
+        bool found;
+        std::string password;
+        int64_t expires_ms;
+        std::list<std::string>::iterator lru;  // 在分片 LRU 链表中的位置
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+        std::list<std::string> lru;  // 表头为最近使用
+        uint64_t version = 0;        // 每次失效加一
+        // 统计在分片锁内更新，不额外争用共享计数器
+        uint64_t hits = 0;
+        uint64_t negative_hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t invalidations = 0;
+    };
+
+    Shard& shard_for(const std::string& username);
+    void store(Shard& shard, const std::string& username, const userRecord& record,
+               uint64_t version, int64_t now);
+
+    static int64_t now_ms();
+
+private:
+    UserService& m_inner;
+    AuthCacheOptions m_options;
+    size_t m_shard_capacity;
+    std::array<Shard, SHARD_COUNT> m_shards;
+};
+
+#endif
@@ -0,0 +1,100 @@
+#include "bloom_user_service.hpp"
+#include <chrono>
+#include "spdlog/spdlog.h"
+
+BloomUserService::BloomUserService(UserService& inner, const BloomOptions& options)
+    : m_inner(inner), m_filter(options.expected_users, options.false_positive_rate) {}
+
+BloomUserService::~BloomUserService() {
+    if (m_loader.joinable()) {
+        m_loader.join();
+    }
+}
+
+void BloomUserService::start_loading() {
+    if (!m_loader.joinable()) {
+        m_loader = std::thread([this]() { load(); });
+    }
+}
+
+void BloomUserService::load() {
+    const auto start = std::chrono::steady_clock::now();
+    // 扫描期间注册的用户名同样会加入，扫描结束后过滤器即完整
+    if (!m_inner.scanUsernames([this](std::string_view username) { m_filter.add(username); })) {
+        spdlog::warn("Username bloom filter disabled: scanning users failed");
+        return;
+    }
+    m_ready.store(true, std::memory_order_release);
+
+    const BloomStats stats = GetStats();
+    spdlog::info("Username bloom filter ready after {} ms: {} users, {} KiB, k={}, estimated fp rate {:.4f}%",
+                 std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count(),
+                 stats.items, stats.memory_bytes / 1024, stats.hashes, stats.estimated_fp_rate * 100);
+}
+
+loginResult BloomUserService::login(const loginRequest& req) {
+    return check_password(lookupUser(req.username, req.read_primary), req.password);
+}
+
+userRecord BloomUserService::lookupUser(const std::string& username, bool read_primary) {
+    // 过滤器只反映本进程看到的用户，判定不存在时仍查询下层服务，不直接回答"用户名不存在"
+    const bool ready = m_ready.load(std::memory_order_acquire);
+    const bool maybe = !ready || m_filter.maybe_contains(username);
+    userRecord record = m_inner.lookupUser(username, read_primary);
+    if (!ready || !record.ok) {
+        return record;
+    }
+    if (maybe) {
+        if (!record.found) {
+            m_false_positives.fetch_add(1, std::memory_order_relaxed);
+        }
+    } else {
+        m_definite_negatives.fetch_add(1, std::memory_order_relaxed);
+        if (record.found) {
+            // 其他实例或手工插入的用户：补入过滤器，之后注册时不会再被当作一定不存在
+            m_missed.fetch_add(1, std::memory_order_relaxed);
+            m_filter.add(username);
+        }
+    }
+    return record;
+}
+
+registerResult BloomUserService::registerUser(const registerRequest& req) {
+    // 可能已存在：先读一次（命中缓存或从库），确认存在则不必让主库执行 INSERT 再报 1062；
+    // 一定不存在时直接插入
+    if (m_ready.load(std::memory_order_acquire) && m_filter.maybe_contains(req.username)) {
+        const userRecord existing = m_inner.lookupUser(req.username, false);
+        if (existing.ok && existing.found) {
+            registerResult res;
+            res.success = false;
+            res.msg = "用户已存在";
+            return res;
+        }
+        if (existing.ok) {
+            m_false_positives.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    registerResult res = m_inner.registerUser(req);
+    if (res.success || res.msg == "用户已存在") {
+        m_filter.add(req.username);
+    }
+    return res;
+}
+
+bool BloomUserService::scanUsernames(const std::function<void(std::string_view)>& fn) {
+    return m_inner.scanUsernames(fn);
+}
+
+BloomStats BloomUserService::GetStats() const {
+    BloomStats stats;
+    stats.ready = m_ready.load(std::memory_order_acquire);
+    stats.memory_bytes = m_filter.memory_bytes();
+    stats.hashes = m_filter.hash_count();
+    stats.items = m_filter.item_count();
+    stats.estimated_fp_rate = m_filter.estimated_false_positive_rate();
+    stats.definite_negatives = m_definite_negatives.load(std::memory_order_relaxed);
+    stats.false_positives = m_false_positives.load(std::memory_order_relaxed);
+    stats.missed = m_missed.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,63 @@
+#ifndef BLOOM_USER_SERVICE_H
+#define BLOOM_USER_SERVICE_H
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include "bloom_filter.hpp"
+#include "user_service.hpp"
+
+// 用户名 Bloom 过滤器参数
+struct BloomOptions {
+    size_t expected_users = 1000000;   // 预期用户数，超出后误判率上升
+    double false_positive_rate = 0.01; // 预期用户数下的目标误判率
+};
+
+// 用户名 Bloom 过滤器统计快照
+struct BloomStats {
+    bool ready;                  // 启动扫描已完成，过滤器生效
+    size_t memory_bytes;         // 位数组占用
+    unsigned hashes;             // 哈希函数个数
+    uint64_t items;              // 已加入的用户名数
+    double estimated_fp_rate;    // 按当前用户数估算的误判率
+    uint64_t definite_negatives; // 判定"一定不存在"的查询
+    uint64_t false_positives;    // 判定"可能存在"但实际不存在的查询
+    uint64_t missed;             // 判定"一定不存在"但实际存在（本进程之外插入）的查询
+};
+
+// 装饰 UserService 的用户名 Bloom 过滤器：
+//   - 启动时在后台从主库流式扫描全部用户名建立过滤器，完成前所有请求直接交给下层服务；
+//   - 注册时用户名可能存在则先查询（走缓存/从库），确认已存在就不再向主库发起 INSERT，
+//     一定不存在时直接插入；
+//   - 注册成功后加入过滤器。
+// 过滤器只记录本进程看到的注册，其他实例或手工插入的用户不在其中，因此登录查询不以过滤器的
+// 否定结果作答，仍交给下层服务，查到的用户补入过滤器。默认关闭（expected_users 为 0）
+class BloomUserService : public UserService {
+public:
+    BloomUserService(UserService& inner, const BloomOptions& options);
+    ~BloomUserService() override;
+
+    // 启动后台扫描线程
+    void start_loading();
+
+    loginResult login(const loginRequest& req) override;
+    registerResult registerUser(const registerRequest& req) override;
+    userRecord lookupUser(const std::string& username, bool read_primary) override;
+    bool scanUsernames(const std::function<void(std::string_view)>& fn) override;
+
+    BloomStats GetStats() const;
+
+private:
+    void load();
+
+private:
+    UserService& m_inner;
+    BloomFilter m_filter;
+    std::atomic<bool> m_ready{false};
+    std::atomic<uint64_t> m_definite_negatives{0};
+    std::atomic<uint64_t> m_false_positives{0};
+    std::atomic<uint64_t> m_missed{0};
+    std::thread m_loader;
+};
+
+#endif
@@ -0,0 +1,115 @@
+#include "fake_db_user_service.hpp"
+#include <chrono>
+#include <random>
+#include <thread>
+#include "../mysql/mysqlpool.hpp"
+
+namespace {
+
+std::mt19937_64& thread_rng() {
+    thread_local std::mt19937_64 rng(std::random_device{}()
+                                     ^ std::hash<std::thread::id>()(std::this_thread::get_id()));
+    return rng;
+}
+
+// 按分布耗时，返回本次是否失败
+bool simulate(const DbLatency& latency) {
+    std::mt19937_64& rng = thread_rng();
+    const uint64_t us = latency.sample_us(rng);
+    if (us > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(us));
+    }
+    return !latency.sample_failure(rng);
+}
+
+MemoryUserOptions memory_options() {
+    MemoryUserOptions options;
+    options.path.clear();  // 不持久化
+    return options;
+}
+
+}  // namespace
+
+FakeDbUserService::FakeDbUserService(connection_pool& pool, const DbLatency& query)
+    : m_pool(pool), m_query(query), m_users(memory_options()) {
+    m_users.load();
+}
+
+std::function<MYSQL*()> FakeDbUserService::connector(const DbLatency& connect) {
+    return [connect]() -> MYSQL* {
+        if (!simulate(connect)) {
+            return nullptr;
+        }
+        return mysql_init(nullptr);
+    };
+}
+
+FakeDbUserService::QueryStatus FakeDbUserService::query() {
+    connPtr conn = m_pool.GetConnection();
+    if (!conn) {
+        m_busy.fetch_add(1, std::memory_order_relaxed);
+        return QueryStatus::BUSY;
+    }
+    m_queries.fetch_add(1, std::memory_order_relaxed);
+    if (!simulate(m_query)) {
+        m_failures.fetch_add(1, std::memory_order_relaxed);
+        return QueryStatus::FAILED;
+    }
+    return QueryStatus::OK;
+}
+
+loginResult FakeDbUserService::login(const loginRequest& req) {
+    return check_password(lookupUser(req.username, req.read_primary), req.password);
+}
+
+userRecord FakeDbUserService::lookupUser(const std::string& username, bool read_primary) {
+    switch (query()) {
+    case QueryStatus::BUSY: {
+        userRecord res;
+        res.msg = "数据库繁忙";
+        return res;
+    }
+    case QueryStatus::FAILED: {
+        userRecord res;
+        res.msg = "查询执行失败";
+        return res;
+    }
+    default:
+        return m_users.lookupUser(username, read_primary);
+    }
+}
+
+registerResult FakeDbUserService::registerUser(const registerRequest& req) {
+    switch (query()) {
+    case QueryStatus::BUSY:
+        return registerResult{false, "数据库繁忙"};
+    case QueryStatus::FAILED:
+        return registerResult{false, "注册失败"};
+    default:
+        return m_users.registerUser(req);
+    }
+}
+
+std::vector<registerResult> FakeDbUserService::registerBatch(const std::vector<const registerRequest*>& reqs) {
+    if (reqs.size() <= 1) {
+        return UserService::registerBatch(reqs);
+    }
+    const QueryStatus status = query();
+    if (status != QueryStatus::OK) {
+        const char* msg = status == QueryStatus::BUSY ? "数据库繁忙" : "注册失败";
+        return std::vector<registerResult>(reqs.size(), registerResult{false, msg});
+    }
+    return m_users.registerBatch(reqs);
+}
+
+bool FakeDbUserService::scanUsernames(const std::function<void(std::string_view)>& fn) {
+    return m_users.scanUsernames(fn);
+}
+
+FakeDbStats FakeDbUserService::GetStats() const {
+    FakeDbStats stats;
+    stats.queries = m_queries.load(std::memory_order_relaxed);
+    stats.failures = m_failures.load(std::memory_order_relaxed);
+    stats.busy = m_busy.load(std::memory_order_relaxed);
+    return stats;
+}
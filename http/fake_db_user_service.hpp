@@ -0,0 +1,63 @@
+#ifndef FAKE_DB_USER_SERVICE_H
+#define FAKE_DB_USER_SERVICE_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mysql/mysql.h>
+#include "user_service.hpp"
+#include "memory_user_service.hpp"
+#include "db_latency.hpp"
+
+class connection_pool;
+
+// 假数据库统计快照
+struct FakeDbStats {
+    uint64_t queries;   // 拿到连接并执行的查询数
+    uint64_t failures;  // 其中按失败率模拟失败的次数
+    uint64_t busy;      // 获取连接超时（返回“数据库繁忙”）的次数
+};
+
+// 模拟 MySQL 延迟的 UserService，用于在没有数据库的环境中测试连接池和 DB 执行器在数据库变慢时的表现：
+//   - 每次查询像 UserServiceMain 一样从连接池借一个连接，按 query 分布采样的时间持有后归还；
+//   - 连接由 connector() 返回的函数“建立”（未连接的 MYSQL 句柄），按 connect 分布耗时和失败，
+//     连接池的扩容、等待、超时、重连都走真实代码；
+//   - 用户数据保存在不持久化的 MemoryUserService 中，查询成功后才读写。
+// 批量注册与 UserServiceMain 一样只借一个连接，整批计一次查询耗时
+class FakeDbUserService : public UserService {
+public:
+    FakeDbUserService(connection_pool& pool, const DbLatency& query);
+
+    FakeDbUserService(const FakeDbUserService&) = delete;
+    FakeDbUserService& operator=(const FakeDbUserService&) = delete;
+
+    // 供 PoolConfig::connector 使用的建立连接函数。
+    // 连接池借出长时间空闲的连接前会 ping，未连接的句柄 ping 必然失败并触发重连，
+    // 即每次校验都计一次建立连接的耗时；不需要时把 validation/keepalive 间隔调大
+    static std::function<MYSQL*()> connector(const DbLatency& connect);
+
+    loginResult login(const loginRequest& req) override;
+    registerResult registerUser(const registerRequest& req) override;
+    std::vector<registerResult> registerBatch(const std::vector<const registerRequest*>& reqs) override;
+    userRecord lookupUser(const std::string& username, bool read_primary) override;
+    bool scanUsernames(const std::function<void(std::string_view)>& fn) override;
+
+    FakeDbStats GetStats() const;
+
+private:
+    enum class QueryStatus { OK, BUSY, FAILED };
+
+    // 借一个连接并按分布持有，模拟一次数据库往返
+    QueryStatus query();
+
+private:
+    connection_pool& m_pool;
+    DbLatency m_query;
+    MemoryUserService m_users;
+
+    std::atomic<uint64_t> m_queries{0};
+    std::atomic<uint64_t> m_failures{0};
+    std::atomic<uint64_t> m_busy{0};
+};
+
+#endif
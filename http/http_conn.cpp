@@ -1,12 +1,10 @@
 #include "http_conn.hpp"
 #include "spdlog/spdlog.h"
 #include "router.hpp" 
-int http_conn::m_user_count = 0;
 
 void http_conn::init(tcp::socket* socket_, const tcp::endpoint& endpoint, const std::string& root, Router& router) {
     socket = socket_;
     m_endpoint = endpoint;
-    m_user_count++;
     doc_root = root;
     m_router = &router;
     init();
@@ -14,36 +12,64 @@ void http_conn::init(tcp::socket* socket_, const tcp::endpoint& endpoint, const
 
 void http_conn::init() {
     read_buf.clear();
-    write_buf.clear();
+    clear_pending();
     requested_file_path.clear();
     request = HttpRequest(); // 重置HttpRequest对象
+    response = HttpResponse();
+    blocking_handler = nullptr;
+    connection_state = ConnectionState();
 
     check_state = CHECK_STATE::CHECK_STATE_REQUESTLINE;
     file_address = nullptr;
-    bytes_to_send = 0;
-    bytes_have_send = 0;
+    file_fd = -1;
+    cached_file.reset();
 
     read_idx = 0;
     checked_idx = 0;
     start_line = 0;
-    write_idx = 0;
+    parse_ns = 0;
+}
+
+void http_conn::next_request() {
+    // 解析成功后 start_line 已指向下一个请求的起始位置
+    requested_file_path.clear();
+    request = HttpRequest();
+    response = HttpResponse();
+    blocking_handler = nullptr;
+    check_state = CHECK_STATE::CHECK_STATE_REQUESTLINE;
+    file_address = nullptr;
+    file_fd = -1;
+    cached_file.reset();
+    checked_idx = start_line;
+    parse_ns = 0;
+}
+
+void http_conn::compact_read_buf() {
+    if (start_line == 0) return;
+    read_buf.erase(0, start_line);
+    checked_idx -= start_line;
+    start_line = 0;
+    read_idx = read_buf.size();
 }
 
 void http_conn::close_conn(bool real_close) {
     if (real_close && socket != nullptr) {
-        spdlog::info("Close client socket");
+        SPDLOG_DEBUG("Close client socket");
         std::error_code ec;
         socket->close(ec);
         if (ec) {
             spdlog::error("Socket close error: {}", ec.message());
         }
         socket = nullptr;
-        m_user_count--;
     }
+    clear_pending();
 }
 
 HTTP_CODE http_conn::process_read() {
-    PARSE_STATUS parse_status = HttpParser::parse(read_buf, request, check_state, checked_idx, start_line);
+    const auto parse_begin = std::chrono::steady_clock::now();
+    PARSE_STATUS parse_status = HttpParser::parse(read_buf, request, check_state, checked_idx, start_line, max_body);
+    parse_ns += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - parse_begin).count());
 
     if (parse_status == PARSE_STATUS::INCOMPLETE) {
         return HTTP_CODE::NO_REQUEST;
@@ -51,22 +77,44 @@ HTTP_CODE http_conn::process_read() {
     else if (parse_status == PARSE_STATUS::SUCCESS) {
         return do_request();
     } 
+    else if (parse_status == PARSE_STATUS::TOO_LARGE) {
+        return HTTP_CODE::PAYLOAD_TOO_LARGE;
+    }
     else {
         return HTTP_CODE::BAD_REQUEST;
     }
 }
 
 HTTP_CODE http_conn::do_request() {
-    HttpResponse res;
-    
-    HTTP_CODE dispatch_result = m_router->dispatch(request, res);
+    HTTP_CODE status = HTTP_CODE::NO_RESOURCE;
+    request.set_connection_state(&connection_state);
+    const RouteHandler* handler = m_router->resolve(request, status);
+    if (!handler) {
+        return status;
+    }
+
+    // 阻塞的处理函数不在网络线程上执行
+    if (handler->blocking) {
+        blocking_handler = handler;
+        return HTTP_CODE::BLOCKING_REQUEST;
+    }
+    return complete_request((*handler)(request, response));
+}
+
+HTTP_CODE http_conn::run_blocking_handler() {
+    const RouteHandler* handler = blocking_handler;
+    blocking_handler = nullptr;
+    return (*handler)(request, response);
+}
 
+HTTP_CODE http_conn::complete_request(HTTP_CODE dispatch_result) {
     switch (dispatch_result) {
         case HTTP_CODE::FILE_REQUEST:
-            requested_file_path = res.get_required_file_path();
+            requested_file_path = response.get_required_file_path();
             break;
         case HTTP_CODE::REDIRECT:
-            request.set_url(res.get_redirect_url()); // 保存重定向URL
+            redirect_url = response.get_redirect_url();
+            request.set_url(redirect_url); // 保存重定向URL
             break;
         default:
             return dispatch_result;
@@ -74,6 +122,24 @@ HTTP_CODE http_conn::do_request() {
 
     if (dispatch_result == HTTP_CODE::FILE_REQUEST) {
         std::string full_path = doc_root + requested_file_path;
+
+        // 静态缓存命中：直接使用缓存的响应头和文件内容
+        StaticFileCache* cache = StaticFileCache::GetInstance();
+        if (cache->enabled()) {
+            int error_status = 0;
+            cached_file = cache->get(full_path, requested_file_path, error_status);
+            if (cached_file) {
+                return dispatch_result;
+            }
+            // 否定条目命中：与下面 stat 的结果一致，不再 stat
+            switch (error_status) {
+                case 404: return HTTP_CODE::NO_RESOURCE;
+                case 403: return HTTP_CODE::FORBIDDEN_REQUEST;
+                case 400: return HTTP_CODE::BAD_REQUEST;
+                default: break;
+            }
+        }
+
         if (stat(full_path.c_str(), &file_stat) < 0) {
             return HTTP_CODE::NO_RESOURCE;
         }
@@ -89,6 +155,12 @@ HTTP_CODE http_conn::do_request() {
             return HTTP_CODE::INTERNAL_ERROR;
         }
 
+        // sendfile 模式保留文件描述符，由内核直接从页缓存发送
+        if (use_sendfile && file_stat.st_size > 0) {
+            file_fd = fd;
+            return dispatch_result;
+        }
+
         file_address = static_cast<char*>(mmap(0, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0));
         close(fd);
         if (file_address == MAP_FAILED) {
@@ -100,32 +172,111 @@ HTTP_CODE http_conn::do_request() {
     return dispatch_result;
 }
 
-void http_conn::unmap() {
-    if (file_address) {
-        munmap(file_address, file_stat.st_size);
-        file_address = nullptr;
+void http_conn::clear_pending() {
+    for (const PendingResponse& res : pending) {
+        if (res.file_address) {
+            munmap(res.file_address, res.file_size);
+        }
+        if (res.file_fd >= 0) {
+            close(res.file_fd);
+        }
     }
+    pending.clear();
+    write_buf.clear();
+    write_buffers.clear();
+    send_cursor = 0;
+    sendfile_response = nullptr;
 }
 
 bool http_conn::process_write(HTTP_CODE ret) {
-    HttpResponser responser(request);
-    responser.build_response(ret, request, file_stat, file_address, requested_file_path);
-
-    // 从responser获取响应数据，设置发送缓冲区
-    const std::string& response_headers = responser.get_write_buf();
-    this->write_buf = response_headers;
-    iv[0].iov_base = const_cast<char*>(write_buf.c_str());
-    iv[0].iov_len = write_buf.size();
-    iv_count = 1;
-    bytes_to_send = write_buf.size();
-    
-    // 如果有文件响应，添加到发送向量
+    // 响应头直接追加到写缓冲区，按请求顺序排队
+    const size_t header_offset = write_buf.size();
+
+    if (ret == HTTP_CODE::FILE_REQUEST && cached_file) {
+        HttpResponser::append_status_line(write_buf, 200);
+        HttpResponser::append_date(write_buf);
+        write_buf.append(cached_file->header(request.is_keep_alive()));
+        last_status = 200;
+        PendingResponse res{header_offset, write_buf.size() - header_offset, nullptr, -1, 0,
+                            cached_file->body.size(), cached_file};
+        pending.push_back(std::move(res));
+        cached_file.reset();
+        return true;
+    }
+
+    HttpResponser responser(request, write_buf);
+    responser.build_response(ret, request, file_stat, file_address, requested_file_path, response);
+    last_status = responser.get_status();
+
+    PendingResponse res{header_offset, write_buf.size() - header_offset, nullptr, -1, 0, 0, nullptr};
+
     if (responser.has_file()) {
-        iv[1].iov_base = const_cast<char*>(responser.get_file_address());
-        iv[1].iov_len = responser.get_file_size();
-        iv_count = 2;
-        bytes_to_send += responser.get_file_size();
+        res.file_address = const_cast<char*>(responser.get_file_address());
+        res.file_size = responser.get_file_size();
+        res.file_fd = file_fd;
+    } 
+    else {
+        // 响应未使用打开的文件（如空文件），立即释放
+        if (file_address) {
+            munmap(file_address, file_stat.st_size);
+        }
+        if (file_fd >= 0) {
+            close(file_fd);
+        }
+    }
+    file_address = nullptr;
+    file_fd = -1;
+
+    pending.push_back(res);
+    return true;
+}
+
+const std::vector<asio::const_buffer>& http_conn::get_write_buffers() {
+    write_buffers.clear();
+    sendfile_response = nullptr;
+    if (send_cursor >= pending.size()) {
+        return write_buffers;
+    }
+
+    // 相邻的响应头在 write_buf 中连续存放，合并为一个缓冲区
+    size_t header_begin = pending[send_cursor].header_offset;
+    size_t header_end = header_begin;
+    while (send_cursor < pending.size()) {
+        PendingResponse& res = pending[send_cursor++];
+        header_end = res.header_offset + res.header_len;
+        if (res.file_address || res.file_fd >= 0 || res.cached) {
+            write_buffers.push_back(asio::buffer(write_buf.data() + header_begin, header_end - header_begin));
+            header_begin = header_end;
+            if (res.file_fd >= 0) {
+                sendfile_response = &res;
+                break;
+            }
+            if (res.cached) {
+                write_buffers.push_back(asio::buffer(res.cached->body));
+            } else {
+                write_buffers.push_back(asio::buffer(res.file_address, res.file_size));
+            }
+        }
+    }
+    if (header_end > header_begin) {
+        write_buffers.push_back(asio::buffer(write_buf.data() + header_begin, header_end - header_begin));
+    }
+    return write_buffers;
+}
+
+bool http_conn::fallback_to_mmap(asio::const_buffer& body) {
+    PendingResponse* res = sendfile_response;
+    if (!res || res->file_fd < 0) return false;
+
+    void* addr = mmap(0, res->file_size, PROT_READ, MAP_PRIVATE, res->file_fd, 0);
+    close(res->file_fd);
+    res->file_fd = -1;
+    if (addr == MAP_FAILED) {
+        return false;
     }
+    res->file_address = static_cast<char*>(addr);
 
+    const size_t offset = static_cast<size_t>(res->file_offset);
+    body = asio::buffer(res->file_address + offset, res->file_size - offset);
     return true;
 }
\ No newline at end of file
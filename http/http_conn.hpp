@@ -3,15 +3,18 @@
 
 #include <sys/mman.h>
 #include <string>
+#include <vector>
 #include <asio.hpp>
 #include <spdlog/spdlog.h>
 #include "http_parser.hpp"
 #include "http_responser.hpp"
+#include "static_cache.hpp"
 
 using asio::ip::tcp;
 
 class Router;
 class HttpRequest;
+struct RouteHandler;
 
 // HTTP处理结果
 enum class HTTP_CODE {
@@ -23,10 +26,30 @@ enum class HTTP_CODE {
     FILE_REQUEST,         // 文件请求（成功）
     INTERNAL_ERROR,       // 服务器内部错误
     CLOSED_CONNECTION,    // 连接关闭
-    REDIRECT              // 重定向
+    REDIRECT,             // 重定向
+    METHOD_NOT_ALLOWED,   // 路径存在但不支持该请求方法
+    BLOCKING_REQUEST,     // 处理函数会阻塞，需交给 DB 执行器执行
+    SERVICE_UNAVAILABLE,  // 服务繁忙（DB 执行器已满）
+    PAYLOAD_TOO_LARGE,    // 请求体超过上限
+    CONTENT_REQUEST       // 响应体由处理函数生成（HttpResponse 的状态码/内容类型/响应体）
 };
 
 class http_conn {
+public:
+    // 等待发送的响应（响应头保存在 write_buf 的 [header_offset, header_offset + header_len)）
+    struct PendingResponse {
+        size_t header_offset;
+        size_t header_len;
+        char* file_address;   // 映射的文件（无则为 nullptr）
+        int file_fd;          // sendfile 模式下打开的文件（无则为 -1）
+        off_t file_offset;    // sendfile 已发送偏移
+        size_t file_size;
+        CachedFilePtr cached; // 命中静态缓存时的缓存条目（响应体直接取自缓存）
+    };
+
+    // 读取阶段，用于选择超时：没有未处理的数据为空闲，否则按解析状态区分请求头/请求体
+    enum class ReadPhase { IDLE, HEADER, BODY };
+
 public:
     http_conn() = default;
     http_conn(tcp::socket* socket_, const tcp::endpoint& endpoint, const std::string& root)
@@ -41,34 +64,61 @@ public:
     HTTP_CODE process_read();
     bool process_write(HTTP_CODE ret);
 
+    // process_read 返回 BLOCKING_REQUEST 后：在 DB 线程执行处理函数，
+    // 再回到连接所在线程用 complete_request 完成文件/重定向处理。
+    // 两者之间连接不再读写请求数据
+    HTTP_CODE run_blocking_handler();
+    HTTP_CODE complete_request(HTTP_CODE ret);
+
     const tcp::endpoint* get_endpoint() const { return &m_endpoint; }
-    void unmap();
 
     void append_read_data(const char* data, size_t length) {
         read_buf.append(data, length);
         read_idx = read_buf.size();
     }
 
-    const std::string& get_write_buffers() const { return write_buf; }
-    bool has_attachment() const { 
-        return (file_address != nullptr) && (file_stat.st_size > 0); 
+    // 当前请求处理完毕，缓冲区中剩余的流水线数据留待下一次解析
+    void next_request();
+    // 丢弃已处理的请求数据，把剩余数据移动到缓冲区头部
+    void compact_read_buf();
+
+    ReadPhase read_phase() const {
+        if (check_state == CHECK_STATE::CHECK_STATE_CONTENT) return ReadPhase::BODY;
+        return read_buf.size() > start_line ? ReadPhase::HEADER : ReadPhase::IDLE;
     }
-    const char* get_attachment_data() const { return file_address; }
-    size_t get_attachment_size() const { return file_stat.st_size; }
-    
+
+    // 文件响应体使用 sendfile 发送（否则 mmap 后随响应头聚合写出）
+    void set_sendfile(bool enable) { use_sendfile = enable; }
+    // 请求体（Content-Length）上限，超过时返回 413
+    void set_max_body(size_t bytes) { max_body = bytes; }
+
+    // 按请求顺序组装尚未发送的响应（响应头 + 可选的响应体），
+    // 遇到 sendfile 响应时只包含其响应头，响应体由 get_sendfile_response() 取出单独发送
+    const std::vector<asio::const_buffer>& get_write_buffers();
+    PendingResponse* get_sendfile_response() { return sendfile_response; }
+    // sendfile 不可用时把当前 sendfile 响应体改为 mmap 发送，返回响应体缓冲区
+    bool fallback_to_mmap(asio::const_buffer& body);
+    bool has_unsent_response() const { return send_cursor < pending.size(); }
+    bool has_pending_response() const { return !pending.empty(); }
+    size_t pending_count() const { return pending.size(); }
+    // 已排队的响应发送完毕后释放资源
+    void clear_pending();
+
     bool is_keep_alive() const { return request.is_keep_alive(); }
     void reset_connection() { init(); }
-    const std::string& get_url() const { return request.get_url(); }
+    std::string_view get_url() const { return request.get_url(); }
     bool is_cgi() const { return request.is_cgi(); }
-    const std::string& get_request_content() const { return request.get_content(); }
+    std::string_view get_request_content() const { return request.get_content(); }
     void set_requested_file(const std::string& path) { requested_file_path = path; }
-    void set_url(const std::string& new_url) { request.set_url(new_url); }
+    void set_url(std::string_view new_url) { request.set_url(new_url); }
     HttpRequest::METHOD get_method() const { return request.get_method(); }
     const HttpRequest& get_request() const { return request; }
-    const std::string& get_version() const { return request.get_version(); }
+    std::string_view get_version() const { return request.get_version(); }
 
-public:
-    static int m_user_count;
+    // 当前请求的解析耗时（纳秒，多次增量解析累加），next_request 时清零
+    uint64_t get_parse_ns() const { return parse_ns; }
+    // 最近一次 process_write 生成的响应状态码
+    int get_last_status() const { return last_status; }
 
 private:
     HTTP_CODE do_request(); 
@@ -77,23 +127,32 @@ private:
     tcp::socket* socket;
     tcp::endpoint m_endpoint;
     std::string read_buf;     // 读缓冲区
-    std::string write_buf;    // 写缓冲区
+    std::string write_buf;    // 写缓冲区（依次存放所有排队响应的响应头）
+    std::vector<PendingResponse> pending;          // 排队中的响应
+    std::vector<asio::const_buffer> write_buffers; // 聚合写向量
+    size_t send_cursor = 0;                        // 下一个未发送的响应
+    PendingResponse* sendfile_response = nullptr;  // 等待 sendfile 发送响应体的响应
+    bool use_sendfile = false;                     // 文件发送方式
+    size_t max_body = HttpParser::DEFAULT_MAX_CONTENT_LENGTH;  // 请求体上限
     
     HttpRequest request;      // 请求对象
+    HttpResponse response;    // 处理函数的输出（文件路径/重定向地址）
+    ConnectionState connection_state;  // 连接内各请求共享的状态
     Router* m_router;         // 路由对象
+    const RouteHandler* blocking_handler = nullptr;  // 等待在 DB 执行器上运行的处理函数
     
     CHECK_STATE check_state;  // 解析状态
     std::string requested_file_path;  // 请求文件路径
-    char* file_address;       // 文件映射地址
+    std::string redirect_url;         // 重定向地址（请求的 URL 视图改为指向它）
+    char* file_address = nullptr;  // 文件映射地址
+    int file_fd = -1;              // sendfile 模式下打开的文件
+    CachedFilePtr cached_file;     // 命中的静态缓存条目
     struct stat file_stat;    // 文件状态
-    struct iovec iv[2];       // 分散写向量
-    int iv_count;             // 向量数量
     size_t read_idx = 0;      // 读缓冲区索引
     size_t checked_idx = 0;   // 已解析索引
     size_t start_line = 0;    // 解析行起始索引
-    size_t write_idx = 0;     // 写缓冲区索引
-    size_t bytes_to_send = 0; // 待发送字节数
-    size_t bytes_have_send = 0; // 已发送字节数 
+    uint64_t parse_ns = 0;    // 当前请求的解析耗时
+    int last_status = 0;      // 最近排队的响应的状态码
     std::string doc_root;     // 文档根目录
 };
 
@@ -1,84 +1,117 @@
 #include "http_parser.hpp"
+#include "http_scan.hpp"
 #include <spdlog/spdlog.h>
-#include <string.h>
+#include <charconv>
+#include <strings.h>
 
-std::string trim(const std::string& s) {
-    if (s.empty()) return "";
-    const std::string whitespace = " \t\r\n";
+static std::string_view trim(std::string_view s) {
+    const std::string_view whitespace = " \t\r\n";
     size_t start = s.find_first_not_of(whitespace);
+    if (start == std::string_view::npos) return {};
     size_t end = s.find_last_not_of(whitespace);
-    return (start == std::string::npos) ? "" : s.substr(start, end - start + 1);
+    return s.substr(start, end - start + 1);
 }
 
-LINE_STATUS HttpParser::parse_line(const std::string& buf, size_t& checked_idx) {
-    for (; checked_idx < buf.size(); ++checked_idx) {
-        char temp = buf[checked_idx];
-        if (temp == '\r') {
-            if ((checked_idx + 1) >= buf.size()) return LINE_STATUS::OPEN;
-            else if (buf[checked_idx + 1] == '\n') {
-                checked_idx += 2;
-                return LINE_STATUS::OK;
-            }
-            return LINE_STATUS::BAD;
+static bool iequals(std::string_view a, std::string_view b) {
+    return a.size() == b.size() && strncasecmp(a.data(), b.data(), a.size()) == 0;
+}
+
+std::string_view HttpRequest::find_header(std::string_view key) const {
+    for (size_t i = 0; i < header_count; ++i) {
+        if (iequals(headers[i].key, key)) {
+            return headers[i].value;
         }
     }
-    return LINE_STATUS::OPEN;
+    return {};
 }
 
-std::string HttpParser::get_line(const std::string& buf, size_t start_line, size_t end_line) {
-    return buf.substr(start_line, end_line - start_line);
+// 在 s 中查找字节 c（SIMD 内核），找不到返回 npos
+static size_t scan(std::string_view s, size_t from, char c) {
+    const char* end = s.data() + s.size();
+    const char* p = http_scan::find_byte(s.data() + from, end, c);
+    return p == end ? std::string_view::npos : static_cast<size_t>(p - s.data());
+}
+
+LINE_STATUS HttpParser::parse_line(std::string_view buf, size_t& checked_idx) {
+    size_t cr = scan(buf, checked_idx, '\r');
+    // 行尾必须是 "\r\n"：'\r' 之前（或尚未收到 '\r' 时已收到的部分）出现单独的 '\n' 即为错误
+    if (scan(buf.substr(0, cr), checked_idx, '\n') != std::string_view::npos) {
+        return LINE_STATUS::BAD;
+    }
+    if (cr == std::string_view::npos) {
+        checked_idx = buf.size();
+        return LINE_STATUS::OPEN;
+    }
+    checked_idx = cr;
+    if ((checked_idx + 1) >= buf.size()) return LINE_STATUS::OPEN;
+    else if (buf[checked_idx + 1] == '\n') {
+        checked_idx += 2;
+        return LINE_STATUS::OK;
+    }
+    return LINE_STATUS::BAD;
 }
 
-PARSE_STATUS HttpParser::parse_request_line(const std::string& text, HttpRequest& req) {
+PARSE_STATUS HttpParser::parse_request_line(std::string_view text, HttpRequest& req) {
     size_t method_space = text.find_first_of(" \t");
-    if (method_space == std::string::npos) {
+    if (method_space == std::string_view::npos) {
         spdlog::error("BAD_REQUEST: No separator after method");
         return PARSE_STATUS::ERROR;
     }
-    std::string method_str = text.substr(0, method_space);
-    spdlog::info("Parsed method: [{}]", method_str);
+    std::string_view method_str = text.substr(0, method_space);
+    SPDLOG_DEBUG("Parsed method: [{}]", method_str);
 
     if (method_str == "GET") {
         req.set_method(HttpRequest::METHOD::GET);
-    } 
+    }
     else if (method_str == "POST") {
         req.set_method(HttpRequest::METHOD::POST);
         req.set_cgi(true);
-    } 
+    }
+    else if (method_str == "HEAD") {
+        req.set_method(HttpRequest::METHOD::HEAD);
+    }
+    else if (method_str == "PUT") {
+        req.set_method(HttpRequest::METHOD::PUT);
+    }
+    else if (method_str == "DELETE") {
+        req.set_method(HttpRequest::METHOD::DELETE);
+    }
+    else if (method_str == "PATCH") {
+        req.set_method(HttpRequest::METHOD::PATH);
+    }
+    else if (method_str == "OPTIONS") {
+        req.set_method(HttpRequest::METHOD::OPTIONS);
+    }
     else {
         req.set_method(HttpRequest::METHOD::UNKNOWN);
     }
 
     size_t url_start = text.find_first_not_of(" \t", method_space);
-    if (url_start == std::string::npos) {
+    if (url_start == std::string_view::npos) {
         spdlog::error("No URL after method");
         return PARSE_STATUS::ERROR;
     }
     size_t url_end = text.find_first_of(" \t", url_start);
-    if (url_end == std::string::npos) {
+    if (url_end == std::string_view::npos) {
         spdlog::error("No separator after URL");
         return PARSE_STATUS::ERROR;
     }
-    std::string url = text.substr(url_start, url_end - url_start);
-    if (url.substr(0, 7) == "http://") {
-        url = url.substr(7);
-        size_t slash_pos = url.find('/');
-        url = (slash_pos != std::string::npos) ? url.substr(slash_pos) : "/";
-    } else if (url.substr(0, 8) == "https://") {
-        url = url.substr(8);
+    std::string_view url = text.substr(url_start, url_end - url_start);
+    if (url.substr(0, 7) == "http://" || url.substr(0, 8) == "https://") {
+        url.remove_prefix(url[4] == 's' ? 8 : 7);
         size_t slash_pos = url.find('/');
-        url = (slash_pos != std::string::npos) ? url.substr(slash_pos) : "/";
+        url = (slash_pos != std::string_view::npos) ? url.substr(slash_pos) : std::string_view("/");
     }
     req.set_url(url);
-    spdlog::info("Parsed URL: [{}]", url);
+    SPDLOG_DEBUG("Parsed URL: [{}]", url);
 
     size_t version_start = text.find_first_not_of(" \t", url_end);
-    if (version_start == std::string::npos) {
+    if (version_start == std::string_view::npos) {
         spdlog::error("No HTTP version after URL");
         return PARSE_STATUS::ERROR;
     }
     size_t version_end = text.find_first_of(" \t", version_start);
-    if (version_end == std::string::npos) version_end = text.length();
+    if (version_end == std::string_view::npos) version_end = text.length();
     req.set_version(text.substr(version_start, version_end - version_start));
 
     if (req.get_version() != "HTTP/1.0" && req.get_version() != "HTTP/1.1") {
@@ -88,82 +121,95 @@ PARSE_STATUS HttpParser::parse_request_line(const std::string& text, HttpRequest
     return PARSE_STATUS::INCOMPLETE;
 }
 
-PARSE_STATUS HttpParser::parse_headers(const std::string& text, HttpRequest& req) {
-    std::string trimmed = trim(text);
-    if (trimmed.empty()) {
-        if (req.get_content_length() != 0) {
-            spdlog::info("Switch to request content parsing");
-            return PARSE_STATUS::INCOMPLETE;
-        }
-        return PARSE_STATUS::SUCCESS;
-    }
+PARSE_STATUS HttpParser::parse_headers(std::string_view text, HttpRequest& req) {
+    size_t colon_pos = scan(text, 0, ':');
+    if (colon_pos == std::string_view::npos) return PARSE_STATUS::ERROR;
 
-    size_t colon_pos = text.find(':');
-    if (colon_pos == std::string::npos) return PARSE_STATUS::ERROR;
-    
-    std::string key = trim(text.substr(0, colon_pos));
-    std::string value = trim(text.substr(colon_pos + 1));
-    req.add_header(key, value);
+    std::string_view key = trim(text.substr(0, colon_pos));
+    std::string_view value = trim(text.substr(colon_pos + 1));
+    if (!req.add_header(key, value)) {
+        spdlog::error("BAD_REQUEST: Too many headers");
+        return PARSE_STATUS::ERROR;
+    }
 
-    if (strcasecmp(key.c_str(), "Connection") == 0) {
-        req.set_keep_alive(strcasecmp(value.c_str(), "keep-alive") == 0);
-    } else if (strcasecmp(key.c_str(), "Content-Length") == 0) {
-        req.set_content_length(atol(value.c_str()));
+    if (iequals(key, "Connection")) {
+        req.set_keep_alive(iequals(value, "keep-alive"));
+    } else if (iequals(key, "Content-Length")) {
+        size_t length = 0;
+        auto result = std::from_chars(value.data(), value.data() + value.size(), length);
+        if (result.ec != std::errc() || result.ptr != value.data() + value.size()) {
+            spdlog::error("BAD_REQUEST: Invalid Content-Length");
+            return PARSE_STATUS::ERROR;
+        }
+        req.set_content_length(length);
     }
 
     return PARSE_STATUS::INCOMPLETE;
 }
 
-PARSE_STATUS HttpParser::parse(const std::string& buf, HttpRequest& req, CHECK_STATE& check_state, size_t& checked_idx, size_t& start_line) {
+PARSE_STATUS HttpParser::parse_header_block(std::string_view block, HttpRequest& req) {
+    // block 为请求行 + 所有请求头，每行以 "\r\n" 结尾，不含结束空行
+    req.clear_headers();
+
+    size_t line_start = 0;
+    bool request_line = true;
+    while (line_start < block.size()) {
+        // 扫描阶段已确认每行以 "\r\n" 结尾且行内没有单独的 '\r'/'\n'，这里仍做检查以免越界
+        size_t line_end = scan(block, line_start, '\r');
+        if (line_end == std::string_view::npos || line_end + 1 >= block.size() || block[line_end + 1] != '\n') {
+            return PARSE_STATUS::ERROR;
+        }
+        std::string_view line = block.substr(line_start, line_end - line_start);
+        line_start = line_end + 2;
+
+        PARSE_STATUS status = request_line ? parse_request_line(line, req) : parse_headers(line, req);
+        if (status == PARSE_STATUS::ERROR)
+            return PARSE_STATUS::ERROR;
+        request_line = false;
+    }
+    return request_line ? PARSE_STATUS::ERROR : PARSE_STATUS::SUCCESS;
+}
+
+PARSE_STATUS HttpParser::parse(std::string_view buf, HttpRequest& req, CHECK_STATE& check_state, size_t& checked_idx, size_t& start_line,
+                               size_t max_content_length) {
+    // 逐行扫描直到遇到空行（头部结束），只推进扫描进度，不产生任何视图
     while (check_state != CHECK_STATE::CHECK_STATE_CONTENT) {
-        // 只调用一次 parse_line，获取当前行的状态
         LINE_STATUS line_status = parse_line(buf, checked_idx);
         if (line_status == LINE_STATUS::BAD)
             return PARSE_STATUS::ERROR;
         if (line_status == LINE_STATUS::OPEN)
             return PARSE_STATUS::INCOMPLETE;
 
-        // 获取当前行内容（行以 "\r\n" 结尾，减2）
-        std::string line = get_line(buf, start_line, checked_idx - 2);
-        start_line = checked_idx;
-
-        switch (check_state) {
-            case CHECK_STATE::CHECK_STATE_REQUESTLINE:
-                if (parse_request_line(line, req) == PARSE_STATUS::ERROR)
-                    return PARSE_STATUS::ERROR;
-                check_state = CHECK_STATE::CHECK_STATE_HEADER;
-                break;
-            case CHECK_STATE::CHECK_STATE_HEADER:
-                if (parse_headers(line, req) == PARSE_STATUS::ERROR)
-                    return PARSE_STATUS::ERROR;
-                // 当遇到空行时，说明头部解析结束
-                if (trim(line).empty()) {
-                    // 如果 Content-Length 为 0，则整个 HTTP 请求解析完成
-                    if (req.get_content_length() == 0)
-                        return PARSE_STATUS::SUCCESS;
-                    else {
-                        // 需要解析报文体，切换状态后退出循环
-                        check_state = CHECK_STATE::CHECK_STATE_CONTENT;
-                    }
-                }
-                break;
-            default:
-                break;
+        if (check_state == CHECK_STATE::CHECK_STATE_REQUESTLINE) {
+            check_state = CHECK_STATE::CHECK_STATE_HEADER;
+        }
+        else if (buf[checked_idx - 3] == '\n') {
+            // 空行（"\r\n" 紧跟在上一行的 "\r\n" 之后）：头部结束，checked_idx 指向报文体起始位置
+            check_state = CHECK_STATE::CHECK_STATE_CONTENT;
         }
-
-        // 当状态切换到 CONTENT 时，退出头部解析循环
-        if (check_state == CHECK_STATE::CHECK_STATE_CONTENT)
-            break;
     }
 
-    // 检查缓冲区里是否已读到足够的内容
-    if (check_state == CHECK_STATE::CHECK_STATE_CONTENT) {
-        if (buf.size() >= start_line + req.get_content_length()) {
-            req.set_content(buf.substr(start_line, req.get_content_length()));
-            return PARSE_STATUS::SUCCESS;
-        } else {
-            return PARSE_STATUS::INCOMPLETE;
-        }
+    // 头部已完整到达，一次性解析为指向 buf 的视图；
+    // 报文体未到齐时下次调用会重新解析（读缓冲区追加数据后原视图可能失效）
+    const size_t body_start = checked_idx;
+    if (parse_header_block(buf.substr(start_line, body_start - 2 - start_line), req) == PARSE_STATUS::ERROR)
+        return PARSE_STATUS::ERROR;
+
+    // 先限制长度再检查是否到齐：body_start + 长度可能回绕，比较剩余字节数不会溢出
+    if (req.get_content_length() > max_content_length) {
+        spdlog::error("Content-Length {} exceeds the limit of {}", req.get_content_length(), max_content_length);
+        return PARSE_STATUS::TOO_LARGE;
+    }
+    if (buf.size() - body_start < req.get_content_length()) {
+        return PARSE_STATUS::INCOMPLETE;
+    }
+    if (req.get_content_length() != 0) {
+        SPDLOG_TRACE("Request content received");
+        req.set_content(buf.substr(body_start, req.get_content_length()));
     }
+
+    // 跳过报文体，start_line 指向下一个（流水线）请求的起始位置
+    start_line = body_start + req.get_content_length();
+    checked_idx = start_line;
     return PARSE_STATUS::SUCCESS;
-}
\ No newline at end of file
+}
@@ -1,30 +1,54 @@
 #ifndef HTTP_PARSER_HPP
 #define HTTP_PARSER_HPP
 
+#include <array>
+#include <chrono>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <utility>
+
+// 同一 TCP 连接上各请求共享的状态，由 http_conn 持有，处理函数可读写
+struct ConnectionState {
+    std::chrono::steady_clock::time_point last_write{};  // 最近一次写数据库的时间（读己之写）
+};
 
 // HTTP请求数据结构
+// 所有字段都是指向连接读缓冲区的 string_view，解析过程不做任何堆分配；
+// 请求处理完毕（next_request / compact_read_buf）之前读缓冲区不会被修改
 class HttpRequest {
 public:
     enum class METHOD {
         GET, POST, HEAD, PUT, DELETE, 
         TRACE, OPTIONS, CONNECT, PATH, UNKNOWN
     };
+
+    struct Header {
+        std::string_view key;
+        std::string_view value;
+    };
+
+    // 路由匹配得到的路径参数（":id" / "*path"），name 指向路由表
+    struct PathParam {
+        std::string_view name;
+        std::string_view value;
+    };
+
+    static constexpr size_t MAX_HEADERS = 64;  // 单个请求最多的请求头数量
+    static constexpr size_t MAX_PARAMS = 8;    // 单个路由最多的路径参数数量
     
     HttpRequest() : method(METHOD::UNKNOWN), content_length(0), cgi(false), linger(false) {}
 
     METHOD get_method() const { return method; }
     void set_method(METHOD m) { method = m; }
 
-    const std::string& get_url() const { return url; }
-    void set_url(const std::string& u) { url = u; }
+    std::string_view get_url() const { return url; }
+    void set_url(std::string_view u) { url = u; }
 
-    const std::string& get_version() const { return version; }
-    void set_version(const std::string& v) { version = v; }
+    std::string_view get_version() const { return version; }
+    void set_version(std::string_view v) { version = v; }
 
-    const std::string& get_content() const { return content; }
-    void set_content(const std::string& c) { content = c; }
+    std::string_view get_content() const { return content; }
+    void set_content(std::string_view c) { content = c; }
 
     size_t get_content_length() const { return content_length; }
     void set_content_length(size_t len) { content_length = len; }
@@ -35,20 +59,60 @@ public:
     bool is_keep_alive() const { return linger; }
     void set_keep_alive(bool l) { linger = l; }
 
-    void add_header(const std::string& key, const std::string& value) {
-        headers[key] = value;
+    bool add_header(std::string_view key, std::string_view value) {
+        if (header_count == MAX_HEADERS) return false;
+        headers[header_count++] = Header{key, value};
+        return true;
     }
 
-    const std::unordered_map<std::string, std::string>& get_headers() const {
-        return headers;
+    size_t get_header_count() const { return header_count; }
+    const Header& get_header(size_t i) const { return headers[i]; }
+    // 按名称（不区分大小写）查找请求头，不存在时返回空
+    std::string_view find_header(std::string_view key) const;
+
+    // 清空已解析的请求头（重新解析同一请求时使用）
+    void clear_headers() { header_count = 0; }
+
+    bool add_param(std::string_view name, std::string_view value) {
+        if (param_count == MAX_PARAMS) return false;
+        params[param_count++] = PathParam{name, value};
+        return true;
     }
+    size_t get_param_count() const { return param_count; }
+    void truncate_params(size_t count) { param_count = count; }
+    const PathParam& get_param(size_t i) const { return params[i]; }
+    // 按名称查找路径参数，不存在时返回空
+    std::string_view find_param(std::string_view name) const {
+        for (size_t i = 0; i < param_count; ++i) {
+            if (params[i].name == name) return params[i].value;
+        }
+        return {};
+    }
+
+    // 所在连接的共享状态，不经过连接分发时为空
+    ConnectionState* get_connection_state() const { return connection_state; }
+    void set_connection_state(ConnectionState* state) { connection_state = state; }
+
+    // 匹配到的路由编号（Router 注册时分配，用于按路由统计），未匹配为 0
+    uint16_t get_route_id() const { return route_id; }
+    void set_route_id(uint16_t id) { route_id = id; }
+
+    // 路径存在但方法不匹配（405）时该路径已注册的方法（"GET, POST"，指向路由表），用于 Allow 响应头
+    std::string_view get_allowed_methods() const { return allowed_methods; }
+    void set_allowed_methods(std::string_view methods) { allowed_methods = methods; }
     
 private:
     METHOD method;
-    std::string url;
-    std::string version;
-    std::unordered_map<std::string, std::string> headers;
-    std::string content;
+    std::string_view url;
+    std::string_view version;
+    std::array<Header, MAX_HEADERS> headers;
+    size_t header_count = 0;
+    std::array<PathParam, MAX_PARAMS> params;
+    size_t param_count = 0;
+    ConnectionState* connection_state = nullptr;
+    uint16_t route_id = 0;
+    std::string_view allowed_methods;
+    std::string_view content;
     size_t content_length;
     bool cgi;
     bool linger;
@@ -64,9 +128,21 @@ public:
     const std::string& get_redirect_url() const { return redirect_url; }
     void set_redirect_url(std::string url) { redirect_url = url; }
 
+    // 处理函数直接生成的响应（HTTP_CODE::CONTENT_REQUEST），状态码须在 HttpResponser 的状态表中，否则按 500 响应
+    int get_status() const { return status; }
+    void set_status(int s) { status = s; }
+    std::string_view get_content_type() const { return content_type; }
+    void set_content_type(std::string_view type) { content_type = type; }
+    const std::string& get_body() const { return body; }
+    std::string& get_body() { return body; }
+    void set_body(std::string b) { body = std::move(b); }
+
 private:
     std::string required_file_path;
     std::string redirect_url;
+    int status = 200;
+    std::string_view content_type = "text/plain; charset=utf-8";  // 指向静态字符串
+    std::string body;
 
 };
 
@@ -74,7 +150,8 @@ private:
 enum class PARSE_STATUS {
     SUCCESS,    // 成功解析一个完整的HTTP请求
     INCOMPLETE, // 数据不完整，需要继续读取
-    ERROR       // 解析出错
+    ERROR,      // 解析出错
+    TOO_LARGE   // Content-Length 超过上限
 };
 
 // HTTP解析状态机
@@ -92,16 +169,23 @@ enum class LINE_STATUS {
 };
 
 // HttpParser 类，专门负责 HTTP 请求的解析
+// 请求行和请求头只在整个头部（直到空行）都已到达后才一次性解析，
+// 因此 HttpRequest 中的 string_view 始终指向当前读缓冲区
 class HttpParser {
 public:
     // 静态成员函数，实现无状态解析
-    static PARSE_STATUS parse(const std::string& buf, HttpRequest& req, CHECK_STATE& check_state, size_t& checked_idx, size_t& start_line);
+    // start_line 为当前请求的起始位置，解析成功后指向下一个请求的起始位置；
+    // checked_idx 为头部结束标记的扫描进度；
+    // Content-Length 超过 max_content_length 时返回 TOO_LARGE（报文体不读取，无法定位下一个请求）
+    static constexpr size_t DEFAULT_MAX_CONTENT_LENGTH = 1024 * 1024;
+    static PARSE_STATUS parse(std::string_view buf, HttpRequest& req, CHECK_STATE& check_state, size_t& checked_idx, size_t& start_line,
+                              size_t max_content_length = DEFAULT_MAX_CONTENT_LENGTH);
 
 private:
-    static LINE_STATUS parse_line(const std::string& buf, size_t& checked_idx);
-    static std::string get_line(const std::string& buf, size_t start_line, size_t end_line);
-    static PARSE_STATUS parse_request_line(const std::string& text, HttpRequest& req);
-    static PARSE_STATUS parse_headers(const std::string& text, HttpRequest& req);
+    static LINE_STATUS parse_line(std::string_view buf, size_t& checked_idx);
+    static PARSE_STATUS parse_header_block(std::string_view block, HttpRequest& req);
+    static PARSE_STATUS parse_request_line(std::string_view text, HttpRequest& req);
+    static PARSE_STATUS parse_headers(std::string_view text, HttpRequest& req);
 };
 
 #endif
\ No newline at end of file
@@ -1,129 +1,264 @@
 #include "http_responser.hpp"
+#include <array>
+#include <charconv>
+#include <ctime>
 #include "spdlog/spdlog.h"
 
-std::unordered_map<std::string, std::string> HttpResponser::file_types = {
+namespace {
+
+// 文件类型映射表
+struct FileType {
+    std::string_view ext;
+    std::string_view type;
+};
+
+constexpr std::array<FileType, 9> file_types = {{
     {".html", "text/html; charset=utf-8"},
     {".htm", "text/html; charset=utf-8"},
-    {".png", "image/png"},       
-    {".jpg", "image/jpeg"},      
+    {".png", "image/png"},
+    {".jpg", "image/jpeg"},
     {".jpeg", "image/jpeg"},
     {".gif", "image/gif"},
     {".css", "text/css"},
     {".js", "application/javascript"},
-    {".ico", "image/x-icon"},       
+    {".ico", "image/x-icon"},
+}};
+
+// 响应状态相关常量
+struct StatusInfo {
+    int status;
+    std::string_view line;   // 完整状态行
+    std::string_view form;   // 错误响应体（非错误状态为空）
 };
 
-HttpResponser::HttpResponser(const HttpRequest& req) : m_request(req) {}
+constexpr std::array<StatusInfo, 9> status_table = {{
+    {200, "HTTP/1.1 200 OK\r\n", ""},
+    {302, "HTTP/1.1 302 Found\r\n", ""},
+    {400, "HTTP/1.1 400 Bad Request\r\n", "Your request has bad syntax or is inherently impossible to satisfy.\n"},
+    {403, "HTTP/1.1 403 Forbidden\r\n", "You do not have permission to get file from this server.\n"},
+    {404, "HTTP/1.1 404 Not Found\r\n", "The requested file was not found on this server.\n"},
+    {405, "HTTP/1.1 405 Method Not Allowed\r\n", "The request method is not supported for the requested resource.\n"},
+    {413, "HTTP/1.1 413 Content Too Large\r\n", "The request body exceeds the size limit of this server.\n"},
+    {500, "HTTP/1.1 500 Internal Error\r\n", "There was an unusual problem serving the request file.\n"},
+    {503, "HTTP/1.1 503 Service Unavailable\r\n", "The server is too busy to handle the request, please retry later.\n"},
+}};
+
+constexpr std::string_view keep_alive_line = "Connection: keep-alive\r\n";
+constexpr std::string_view close_line = "Connection: close\r\n";
+constexpr std::string_view empty_html = "<html><body></body></html>";
+
+// 状态码在表中的下标，不在表中时返回 status_table.size()
+constexpr size_t status_index(int status) {
+    for (size_t i = 0; i < status_table.size(); ++i) {
+        if (status_table[i].status == status) return i;
+    }
+    return status_table.size();
+}
+
+constexpr size_t internal_error_index = status_index(500);
+static_assert(internal_error_index < status_table.size(), "status_table must contain 500");
+
+// 表中没有的状态码（通常是处理函数设置了未登记的状态）是程序错误：记录后按 500 响应，不静默替换
+size_t checked_status_index(int status) {
+    const size_t index = status_index(status);
+    if (index == status_table.size()) {
+        spdlog::error("HTTP status {} is not in the status table, responding with 500", status);
+        return internal_error_index;
+    }
+    return index;
+}
+
+const StatusInfo& status_info(int status) {
+    return status_table[checked_status_index(status)];
+}
+
+// 固定的错误响应：Date 之后的响应头 + 响应体，按 keep-alive 分两份，启动时生成一次
+struct ErrorResponses {
+    ErrorResponses() {
+        for (size_t i = 0; i < status_table.size(); ++i) {
+            const StatusInfo& info = status_table[i];
+            if (info.form.empty()) continue;
+            for (int keep_alive = 0; keep_alive < 2; ++keep_alive) {
+                std::string& out = tails[i][keep_alive];
+                out.append("Content-Length: ").append(std::to_string(info.form.size())).append("\r\n");
+                out.append("Content-Type: text/plain; charset=utf-8\r\n");
+                out.append(keep_alive ? keep_alive_line : close_line);
+                out.append("\r\n");
+                out.append(info.form);
+            }
+        }
+    }
+
+    std::string_view get(int status, bool keep_alive) const {
+        return tails[checked_status_index(status)][keep_alive ? 1 : 0];
+    }
+
+    std::array<std::array<std::string, 2>, status_table.size()> tails;
+};
+
+const ErrorResponses error_responses;
+
+// 每个线程缓存格式化好的 Date 头，秒数变化时才重新格式化
+struct DateCache {
+    time_t second = -1;
+    char line[64];
+    size_t len = 0;
+};
+
+thread_local DateCache date_cache;
+
+}  // namespace
+
+HttpResponser::HttpResponser(const HttpRequest& req, std::string& out) : m_request(req), m_out(out) {}
 
 void HttpResponser::build_response(HTTP_CODE ret, const HttpRequest& request,
-                                  const struct stat& file_stat, char* file_address, const std::string& requested_file_path) {
-    m_write_buf.clear();
-    m_write_idx = 0;
-    m_requested_file_path = requested_file_path;
+                                  const struct stat& file_stat, char* file_address, std::string_view requested_file_path,
+                                  const HttpResponse& response) {
     m_has_file = false;
+    m_status = 0;
     m_file_address = nullptr;
     m_file_size = 0;
 
     switch (ret) {
         case HTTP_CODE::INTERNAL_ERROR:
-            add_status_line(500, error_500_title);
-            add_headers(strlen(error_500_form));
-            add_content(error_500_form);
+            add_error(500);
             break;
 
         case HTTP_CODE::BAD_REQUEST:
-            add_status_line(400, error_400_title);
-            add_headers(strlen(error_400_form));
-            add_content(error_400_form);
+            add_error(400);
             break;
 
         case HTTP_CODE::FORBIDDEN_REQUEST:
-            add_status_line(403, error_403_title);
-            add_headers(strlen(error_403_form));
-            add_content(error_403_form);
+            add_error(403);
             break;
 
         case HTTP_CODE::NO_RESOURCE:
-            add_status_line(404, error_404_title);
-            add_headers(strlen(error_404_form));
-            add_content(error_404_form);
+            add_error(404);
+            break;
+
+        case HTTP_CODE::METHOD_NOT_ALLOWED:
+            // RFC 9110 要求 405 响应带 Allow 头，列出该资源支持的方法
+            m_status = 405;
+            append_status_line(m_out, 405);
+            append_date(m_out);
+            m_out.append("Allow: ").append(request.get_allowed_methods()).append("\r\n");
+            m_out.append(error_responses.get(405, m_request.is_keep_alive()));
+            break;
+
+        case HTTP_CODE::SERVICE_UNAVAILABLE:
+            add_error(503);
+            break;
+
+        case HTTP_CODE::PAYLOAD_TOO_LARGE:
+            // 请求体没有读取，无法定位下一个请求，响应后关闭连接
+            m_status = 413;
+            append_status_line(m_out, 413);
+            append_date(m_out);
+            m_out.append(error_responses.get(413, false));
             break;
 
         case HTTP_CODE::FILE_REQUEST:
-            add_status_line(200, ok_200_title);
+            m_status = 200;
+            append_status_line(m_out, 200);
+            append_date(m_out);
             if (file_stat.st_size != 0) {
-                add_headers(file_stat.st_size);
+                append_file_headers(m_out, file_stat.st_size, requested_file_path, m_request.is_keep_alive());
                 m_file_address = file_address;
                 m_file_size = file_stat.st_size;
                 m_has_file = true;
-            } 
+            }
             else {
-                const char* empty_html = "<html><body></body></html>";
-                add_headers(strlen(empty_html));
-                add_content(empty_html);
+                append_file_headers(m_out, empty_html.size(), requested_file_path, m_request.is_keep_alive());
+                m_out.append(empty_html);
             }
             break;
-        
+
+        case HTTP_CODE::CONTENT_REQUEST:
+            // 记录实际写出的状态（未登记的状态按 500 响应）
+            m_status = status_info(response.get_status()).status;
+            append_status_line(m_out, m_status);
+            append_date(m_out);
+            add_content_length(response.get_body().size());
+            m_out.append("Content-Type: ").append(response.get_content_type()).append("\r\n");
+            add_linger();
+            add_blank_line();
+            m_out.append(response.get_body());
+            break;
+
         case HTTP_CODE::REDIRECT:
-            add_status_line(302, "Found");
+            m_status = 302;
+            append_status_line(m_out, 302);
+            append_date(m_out);
             add_location(request.get_url());
             add_content_length(0);
             add_linger();
             add_blank_line();
             break;
-        
+
         default:
             spdlog::error("Unsupported HTTP_CODE: {}", static_cast<int>(ret));
             break;
     }
 }
 
-bool HttpResponser::add_status_line(int status, const std::string& title) {
-    return add_response("HTTP/1.1 %d %s\r\n", status, title.c_str());
+void HttpResponser::append_status_line(std::string& out, int status) {
+    out.append(status_info(status).line);
 }
 
-bool HttpResponser::add_headers(int content_len) {
-    return add_content_length(content_len) 
-        && add_content_type() 
-        && add_linger() 
-        && add_blank_line();
+void HttpResponser::append_date(std::string& out) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME_COARSE, &now);
+    if (now.tv_sec != date_cache.second) {
+        struct tm tm;
+        gmtime_r(&now.tv_sec, &tm);
+        date_cache.len = strftime(date_cache.line, sizeof(date_cache.line), "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &tm);
+        date_cache.second = now.tv_sec;
+    }
+    out.append(date_cache.line, date_cache.len);
 }
 
-bool HttpResponser::add_content_length(int content_len) {
-    return add_response("Content-Length: %d\r\n", content_len);
+void HttpResponser::append_file_headers(std::string& out, size_t content_length,
+                                        std::string_view requested_file_path, bool keep_alive) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), content_length);
+    out.append("Content-Length: ").append(digits, result.ptr - digits).append("\r\n");
+    out.append("Content-Type: ").append(get_content_type(requested_file_path)).append("\r\n");
+    out.append(keep_alive ? keep_alive_line : close_line);
+    out.append("\r\n");
 }
 
-std::string HttpResponser::get_file_extension() {
-    size_t dot_pos = m_requested_file_path.find_last_of('.');
-    if (dot_pos == std::string::npos) {
-        return "";
-    }
-    return m_requested_file_path.substr(dot_pos);
+void HttpResponser::add_error(int status) {
+    m_status = status;
+    append_status_line(m_out, status);
+    append_date(m_out);
+    m_out.append(error_responses.get(status, m_request.is_keep_alive()));
 }
 
-bool HttpResponser::add_content_type() {
-    std::string ext = get_file_extension();
-    std::string file_type = "application/octet-stream";
+void HttpResponser::add_content_length(size_t content_length) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), content_length);
+    m_out.append("Content-Length: ").append(digits, result.ptr - digits).append("\r\n");
+}
 
-    if (file_types.find(ext) != file_types.end()) {
-        file_type = file_types[ext];
+std::string_view HttpResponser::get_content_type(std::string_view path) {
+    size_t dot_pos = path.find_last_of('.');
+    if (dot_pos != std::string_view::npos) {
+        std::string_view ext = path.substr(dot_pos);
+        for (const FileType& type : file_types) {
+            if (type.ext == ext) return type.type;
+        }
     }
-
-    return add_response("Content-Type: %s\r\n", file_type.c_str());
+    return "application/octet-stream";
 }
 
-bool HttpResponser::add_linger() {
-    return add_response("Connection: %s\r\n", m_request.is_keep_alive() ? "keep-alive" : "close");
+void HttpResponser::add_linger() {
+    m_out.append(m_request.is_keep_alive() ? keep_alive_line : close_line);
 }
 
-bool HttpResponser::add_blank_line() {
-    return add_response("\r\n");
+void HttpResponser::add_blank_line() {
+    m_out.append("\r\n");
 }
 
-bool HttpResponser::add_content(const std::string& content) {
-    return add_response("%s", content.c_str());
+void HttpResponser::add_location(std::string_view location) {
+    m_out.append("Location: ").append(location).append("\r\n");
 }
-
-bool HttpResponser::add_location(const std::string& location) {
-    return add_response("Location: %s\r\n", location.c_str());
-}
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "http_scan.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HTTP_SCAN_X86 1
+#endif
+
+namespace http_scan {
+
+using find_byte_fn = const char* (*)(const char*, const char*, char);
+
+static const char* find_byte_scalar(const char* p, const char* end, char c) {
+    for (; p < end; ++p) {
+        if (*p == c) return p;
+    }
+    return end;
+}
+
+#ifdef HTTP_SCAN_X86
+
+// 每次比较 16 字节：_mm_cmpestri 返回第一个等于 c 的位置，没有则返回 16
+__attribute__((target("sse4.2")))
+static const char* find_byte_sse42(const char* p, const char* end, char c) {
+    const __m128i needle = _mm_set1_epi8(c);
+    while (end - p >= 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const int idx = _mm_cmpestri(needle, 1, block, 16,
+                                     _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT);
+        if (idx != 16) return p + idx;
+        p += 16;
+    }
+    return find_byte_scalar(p, end, c);
+}
+
+// 每次比较 32 字节，用比较掩码的最低置位定位
+__attribute__((target("avx2")))
+static const char* find_byte_avx2(const char* p, const char* end, char c) {
+    const __m256i needle = _mm256_set1_epi8(c);
+    while (end - p >= 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle)));
+        if (mask != 0) return p + __builtin_ctz(mask);
+        p += 32;
+    }
+    if (end - p >= 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm256_castsi256_si128(needle))));
+        if (mask != 0) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+    return find_byte_scalar(p, end, c);
+}
+
+#endif
+
+static bool cpu_supports(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::SCALAR:
+            return true;
+#ifdef HTTP_SCAN_X86
+        case Kernel::SSE42:
+            return __builtin_cpu_supports("sse4.2");
+        case Kernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+static find_byte_fn kernel_fn(Kernel kernel) {
+    switch (kernel) {
+#ifdef HTTP_SCAN_X86
+        case Kernel::SSE42:
+            return find_byte_sse42;
+        case Kernel::AVX2:
+            return find_byte_avx2;
+#endif
+        default:
+            return find_byte_scalar;
+    }
+}
+
+static Kernel detect_kernel() {
+    if (cpu_supports(Kernel::AVX2)) return Kernel::AVX2;
+    if (cpu_supports(Kernel::SSE42)) return Kernel::SSE42;
+    return Kernel::SCALAR;
+}
+
+// 进程启动时完成一次选择，之后只读
+static Kernel g_kernel = detect_kernel();
+static find_byte_fn g_find_byte = kernel_fn(g_kernel);
+
+const char* find_byte(const char* begin, const char* end, char c) {
+    return g_find_byte(begin, end, c);
+}
+
+Kernel active_kernel() {
+    return g_kernel;
+}
+
+const char* kernel_name(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::SSE42: return "sse4.2";
+        case Kernel::AVX2: return "avx2";
+        default: return "scalar";
+    }
+}
+
+bool set_kernel(Kernel kernel) {
+    if (!cpu_supports(kernel)) return false;
+    g_kernel = kernel;
+    g_find_byte = kernel_fn(kernel);
+    return true;
+}
+
+}  // namespace http_scan
@@ -0,0 +1,28 @@
+#ifndef HTTP_SCAN_H
+#define HTTP_SCAN_H
+
+#include <cstddef>
+
+// HTTP 解析用的字节扫描内核（行结束符、请求头分隔符），
+// 启动时按 CPU 特性选择 AVX2 / SSE4.2 / 标量实现
+namespace http_scan {
+
+enum class Kernel {
+    SCALAR,
+    SSE42,
+    AVX2
+};
+
+// 在 [begin, end) 中查找第一个字节 c，找不到返回 end
+const char* find_byte(const char* begin, const char* end, char c);
+
+// 当前使用的内核
+Kernel active_kernel();
+const char* kernel_name(Kernel kernel);
+
+// 指定内核（CPU 不支持时返回 false 且不切换），用于基准对比
+bool set_kernel(Kernel kernel);
+
+}  // namespace http_scan
+
+#endif
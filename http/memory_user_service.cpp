@@ -0,0 +1,562 @@
+#include "memory_user_service.hpp"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "spdlog/spdlog.h"
+
+namespace {
+
+// 快照文件头：魔数 + 用户数（小端，与记录一致按本机字节序写入）
+constexpr std::string_view SNAPSHOT_MAGIC = "USNAP001";
+constexpr size_t SNAPSHOT_HEADER = 16;
+// 单条记录：u16 用户名长度、u16 密码长度、用户名、密码、u32 校验和（前面所有字节的 FNV-1a）
+constexpr size_t MAX_FIELD = 0xFFFF;
+constexpr size_t RECORD_OVERHEAD = 8;
+constexpr size_t SNAPSHOT_FLUSH_BYTES = 1 << 20;
+
+uint32_t checksum(const char* data, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        h = (h ^ static_cast<unsigned char>(data[i])) * 16777619u;
+    }
+    return h;
+}
+
+void append_record(std::string& out, std::string_view username, std::string_view password) {
+    const size_t start = out.size();
+    const uint16_t lens[2] = {static_cast<uint16_t>(username.size()), static_cast<uint16_t>(password.size())};
+    out.append(reinterpret_cast<const char*>(lens), sizeof(lens));
+    out.append(username);
+    out.append(password);
+    const uint32_t sum = checksum(out.data() + start, out.size() - start);
+    out.append(reinterpret_cast<const char*>(&sum), sizeof(sum));
+}
+
+bool write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        const ssize_t n = ::write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// rename 之后同步目录，保证新文件名落盘
+void sync_dir(const std::string& file) {
+    const std::string dir = std::filesystem::path(file).parent_path().string();
+    const int dir_fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+    }
+}
+
+// 读入整个文件，不存在时返回空内容
+bool read_file(const std::string& file, std::string& out) {
+    out.clear();
+    const int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return errno == ENOENT;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    out.resize(static_cast<size_t>(st.st_size));
+    size_t done = 0;
+    while (done < out.size()) {
+        const ssize_t n = ::read(fd, &out[done], out.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        done += static_cast<size_t>(n);
+    }
+    out.resize(done);
+    ::close(fd);
+    return true;
+}
+
+}  // namespace
+
+MemoryUserService::MemoryUserService(const MemoryUserOptions& options) : m_options(options) {}
+
+MemoryUserService::~MemoryUserService() {
+    if (m_compactor.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_compactor_mutex);
+            m_stopping = true;
+        }
+        m_compactor_cond.notify_one();
+        m_compactor.join();
+    }
+    if (m_log_fd >= 0) {
+        ::close(m_log_fd);
+    }
+}
+
+uint64_t MemoryUserService::hash_of(std::string_view username) {
+    uint64_t h = 14695981039346656037ull;
+    for (char c : username) {
+        h = (h ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+    // 高位用于选分片、低位用于槽位，再混合一次使两端都分布均匀
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return h ? h : 1;
+}
+
+const MemoryUserService::Slot* MemoryUserService::find(const Shard& shard, uint64_t hash, std::string_view username) {
+    if (shard.slots.empty()) return nullptr;
+    const size_t mask = shard.slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        const Slot& slot = shard.slots[i];
+        if (slot.hash == 0) return nullptr;
+        if (slot.hash == hash && slot.username == username) return &slot;
+    }
+}
+
+bool MemoryUserService::insert(Shard& shard, uint64_t hash, std::string_view username, std::string_view password) {
+    if (find(shard, hash, username)) return false;
+    // 装载率不超过 3/4
+    if ((shard.size + 1) * 4 > shard.slots.size() * 3) {
+        reserve(shard, std::max<size_t>(shard.size * 2, 8));
+    }
+    const size_t mask = shard.slots.size() - 1;
+    size_t i = hash & mask;
+    while (shard.slots[i].hash != 0) {
+        i = (i + 1) & mask;
+    }
+    Slot& slot = shard.slots[i];
+    slot.hash = hash;
+    slot.username.assign(username);
+    slot.password.assign(password);
+    ++shard.size;
+    return true;
+}
+
+void MemoryUserService::reserve(Shard& shard, size_t users) {
+    size_t capacity = 16;
+    while (capacity * 3 < users * 4) {
+        capacity <<= 1;
+    }
+    if (capacity <= shard.slots.size()) return;
+
+    std::vector<Slot> old;
+    old.swap(shard.slots);
+    shard.slots.resize(capacity);
+    const size_t mask = capacity - 1;
+    for (Slot& slot : old) {
+        if (slot.hash == 0) continue;
+        size_t i = slot.hash & mask;
+        while (shard.slots[i].hash != 0) {
+            i = (i + 1) & mask;
+        }
+        shard.slots[i] = std::move(slot);
+    }
+}
+
+bool MemoryUserService::load() {
+    const auto start = std::chrono::steady_clock::now();
+    for (Shard& shard : m_shards) {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        reserve(shard, m_options.expected_users / SHARD_COUNT + 1);
+    }
+    if (m_options.path.empty()) {
+        spdlog::info("Memory user store ready (not persisted)");
+        return true;
+    }
+
+    const std::filesystem::path dir = std::filesystem::path(m_options.path).parent_path();
+    std::error_code ec;
+    if (!dir.empty()) {
+        std::filesystem::create_directories(dir, ec);
+        if (ec) {
+            spdlog::error("Memory user store: cannot create {}: {}", dir.string(), ec.message());
+            return false;
+        }
+    }
+
+    size_t snapshot_bytes = 0;
+    size_t log_valid = 0;
+    const std::string log_file = m_options.path + ".log";
+    if (!replay(m_options.path + ".snap", true, snapshot_bytes) || !replay(log_file, false, log_valid)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_log_mutex);
+    // 可读写：压缩时要读出快照之后追加的记录
+    m_log_fd = ::open(log_file.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (m_log_fd < 0) {
+        spdlog::error("Memory user store: cannot open {}: {}", log_file, strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (::fstat(m_log_fd, &st) == 0 && static_cast<size_t>(st.st_size) > log_valid) {
+        // 写到一半时崩溃留下的不完整记录，截掉后才能继续追加
+        spdlog::warn("Memory user store: dropping {} bytes of torn records at the end of {}",
+                     static_cast<size_t>(st.st_size) - log_valid, log_file);
+        if (::ftruncate(m_log_fd, static_cast<off_t>(log_valid)) != 0) {
+            spdlog::error("Memory user store: cannot truncate {}: {}", log_file, strerror(errno));
+            return false;
+        }
+    }
+    m_log_bytes = log_valid;
+    m_compact_at = m_options.compact_log_bytes;
+    if (m_options.compact_log_bytes > 0) {
+        m_compactor = std::thread([this]() { compaction_loop(); });
+    }
+
+    spdlog::info("Memory user store loaded {} users in {} ms (snapshot {} B, log {} B)",
+                 m_users.load(std::memory_order_relaxed),
+                 std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count(),
+                 snapshot_bytes, log_valid);
+    return true;
+}
+
+bool MemoryUserService::replay(const std::string& file, bool snapshot, size_t& valid_bytes) {
+    std::string data;
+    if (!read_file(file, data)) {
+        spdlog::error("Memory user store: cannot read {}: {}", file, strerror(errno));
+        return false;
+    }
+    valid_bytes = 0;
+    if (data.empty()) return true;
+
+    size_t pos = 0;
+    if (snapshot) {
+        if (data.size() < SNAPSHOT_HEADER || data.compare(0, SNAPSHOT_MAGIC.size(), SNAPSHOT_MAGIC) != 0) {
+            spdlog::error("Memory user store: {} is not a snapshot", file);
+            return false;
+        }
+        uint64_t count = 0;
+        std::memcpy(&count, data.data() + SNAPSHOT_MAGIC.size(), sizeof(count));
+        // 用户数来自文件头，损坏时可能极大：每条记录至少 RECORD_OVERHEAD 字节，超出即为损坏，不按它预留
+        if (count > (data.size() - SNAPSHOT_HEADER) / RECORD_OVERHEAD) {
+            spdlog::error("Memory user store: snapshot {} is corrupted (header claims {} users in {} bytes)",
+                          file, count, data.size());
+            return false;
+        }
+        // 按快照中的用户数一次分配好，重放时不再扩容
+        for (Shard& shard : m_shards) {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            reserve(shard, count / SHARD_COUNT + count / SHARD_COUNT / 8 + 16);
+        }
+        pos = SNAPSHOT_HEADER;
+    }
+
+    while (pos + RECORD_OVERHEAD <= data.size()) {
+        uint16_t lens[2];
+        std::memcpy(lens, data.data() + pos, sizeof(lens));
+        const size_t end = pos + RECORD_OVERHEAD + lens[0] + lens[1];
+        if (end > data.size()) break;
+        uint32_t sum = 0;
+        std::memcpy(&sum, data.data() + end - sizeof(sum), sizeof(sum));
+        if (sum != checksum(data.data() + pos, end - pos - sizeof(sum))) break;
+
+        const std::string_view username(data.data() + pos + 4, lens[0]);
+        const std::string_view password(data.data() + pos + 4 + lens[0], lens[1]);
+        const uint64_t hash = hash_of(username);
+        Shard& shard = shard_for(hash);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        // 压缩过程中崩溃时同一用户可能同时在快照和日志中
+        if (insert(shard, hash, username, password)) {
+            m_users.fetch_add(1, std::memory_order_relaxed);
+        }
+        pos = end;
+    }
+    valid_bytes = pos;
+
+    if (snapshot && pos != data.size()) {
+        spdlog::error("Memory user store: snapshot {} is corrupted at offset {}", file, pos);
+        return false;
+    }
+    return true;
+}
+
+loginResult MemoryUserService::login(const loginRequest& req) {
+    return check_password(lookupUser(req.username, req.read_primary), req.password);
+}
+
+userRecord MemoryUserService::lookupUser(const std::string& username, bool read_primary) {
+    (void)read_primary;
+    userRecord record;
+    record.ok = true;
+    const uint64_t hash = hash_of(username);
+    Shard& shard = shard_for(hash);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    if (const Slot* slot = find(shard, hash, username)) {
+        record.found = true;
+        record.password = slot->password;
+    }
+    return record;
+}
+
+registerResult MemoryUserService::registerUser(const registerRequest& req) {
+    registerResult res;
+    res.success = false;
+    if (req.username.size() > MAX_FIELD || req.password.size() > MAX_FIELD) {
+        res.msg = "注册失败";
+        return res;
+    }
+
+    const uint64_t hash = hash_of(req.username);
+    Shard& shard = shard_for(hash);
+    if (m_options.path.empty()) {
+        // 不持久化：直接插入
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        if (!insert(shard, hash, req.username, req.password)) {
+            res.msg = "用户已存在";
+            return res;
+        }
+        m_users.fetch_add(1, std::memory_order_relaxed);
+    }
+    else {
+        // 锁顺序：日志锁 -> 分片锁。查重覆盖已插入分片和排队/正在写日志的用户名；
+        // 写入日志后才插入分片，写日志失败的注册对登录和快照都不可见
+        std::unique_lock<std::mutex> lock(m_log_mutex);
+        {
+            std::shared_lock<std::shared_mutex> shard_lock(shard.mutex);
+            if (find(shard, hash, req.username)) {
+                res.msg = "用户已存在";
+                return res;
+            }
+        }
+        if (!m_log_names.insert(req.username).second) {
+            res.msg = "用户已存在";
+            return res;
+        }
+        LogWaiter waiter{&req, hash};
+        append_record(m_log_buffer, req.username, req.password);
+        m_log_waiters.push_back(&waiter);
+        // 组提交：没有线程在写日志时由本线程把排队的全部记录一次写入（sync_log 时一次 fdatasync），
+        // 否则等待正在写的线程完成，之后本条记录可能已被下一组带上
+        while (!waiter.done) {
+            if (m_log_writing) {
+                m_log_cond.wait(lock);
+            } else {
+                write_log_group(lock);
+            }
+        }
+        if (!waiter.ok) {
+            // 没有写进日志的注册重启后会丢失，返回失败
+            res.msg = "注册失败";
+            return res;
+        }
+    }
+    if (m_options.compact_log_bytes > 0 && m_log_bytes.load(std::memory_order_relaxed) >= m_compact_at.load()) {
+        request_compaction();
+    }
+
+    res.success = true;
+    res.msg = "注册成功";
+    return res;
+}
+
+bool MemoryUserService::scanUsernames(const std::function<void(std::string_view)>& fn) {
+    for (Shard& shard : m_shards) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        for (const Slot& slot : shard.slots) {
+            if (slot.hash != 0) fn(slot.username);
+        }
+    }
+    return true;
+}
+
+void MemoryUserService::write_log_group(std::unique_lock<std::mutex>& lock) {
+    m_log_writing = true;
+    std::string records;
+    std::vector<LogWaiter*> waiters;
+    records.swap(m_log_buffer);
+    waiters.swap(m_log_waiters);
+    lock.unlock();
+    // 写日志期间不持有日志锁，新的注册继续排队，由下一组写入
+    const bool ok = write_log(records);
+    lock.lock();
+
+    if (ok) {
+        // 在日志锁内推进日志长度并插入分片：日志锁空闲时 [0, m_log_bytes) 中的用户都已在分片中
+        m_log_bytes += records.size();
+    } else {
+        m_log_failures.fetch_add(waiters.size(), std::memory_order_relaxed);
+    }
+    for (LogWaiter* waiter : waiters) {
+        const registerRequest& req = *waiter->req;
+        if (ok) {
+            Shard& shard = shard_for(waiter->hash);
+            std::unique_lock<std::shared_mutex> shard_lock(shard.mutex);
+            insert(shard, waiter->hash, req.username, req.password);
+            m_users.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_log_names.erase(req.username);
+        waiter->ok = ok;
+        waiter->done = true;
+    }
+    m_log_writing = false;
+    m_log_cond.notify_all();
+}
+
+bool MemoryUserService::write_log(std::string_view records) {
+    if (!write_all(m_log_fd, records.data(), records.size())
+        || (m_options.sync_log && ::fdatasync(m_log_fd) != 0)) {
+        spdlog::error("Memory user store: log write failed: {}", strerror(errno));
+        // 去掉可能写了一半的记录，否则之后追加的记录在重放时都读不到
+        if (::ftruncate(m_log_fd, static_cast<off_t>(m_log_bytes.load())) != 0) {
+            spdlog::error("Memory user store: cannot truncate the log: {}", strerror(errno));
+        }
+        return false;
+    }
+    return true;
+}
+
+bool MemoryUserService::compact() {
+    std::lock_guard<std::mutex> lock(m_compact_mutex);
+    return write_snapshot();
+}
+
+void MemoryUserService::request_compaction() {
+    if (m_compact_pending.exchange(true)) return;
+    std::lock_guard<std::mutex> lock(m_compactor_mutex);
+    m_compactor_cond.notify_one();
+}
+
+void MemoryUserService::compaction_loop() {
+    std::unique_lock<std::mutex> lock(m_compactor_mutex);
+    while (true) {
+        m_compactor_cond.wait(lock, [this]() { return m_stopping || m_compact_pending.load(); });
+        if (m_stopping) break;
+        lock.unlock();
+        if (compact()) {
+            // 压缩期间追加的记录较多时，之后的注册会再次触发
+            m_compact_at.store(m_options.compact_log_bytes);
+        } else {
+            // 失败时（通常是磁盘问题）不在每次注册时重试，日志再增长一个阈值后才再次压缩
+            m_compact_at.store(m_log_bytes.load() + m_options.compact_log_bytes);
+            spdlog::warn("Memory user store: compaction failed, keeping the log; next attempt at {} bytes",
+                         m_compact_at.load());
+        }
+        m_compact_pending.store(false);
+        lock.lock();
+    }
+}
+
+bool MemoryUserService::write_snapshot() {
+    const auto start = std::chrono::steady_clock::now();
+    // 记下当前日志长度：其中的记录都已插入分片，一定包含在下面的快照中
+    uint64_t covered;
+    {
+        std::lock_guard<std::mutex> lock(m_log_mutex);
+        if (m_log_fd < 0) return true;
+        covered = m_log_bytes.load();
+    }
+
+    const std::string snapshot = m_options.path + ".snap";
+    const std::string tmp = snapshot + ".tmp";
+    const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        spdlog::error("Memory user store: cannot create {}: {}", tmp, strerror(errno));
+        return false;
+    }
+
+    // 不持有日志锁，注册照常进行；分片逐个加读锁，登录不受影响。
+    // 期间新注册的用户可能也写进快照，重放日志时重复的记录被忽略
+    std::string buffer(SNAPSHOT_MAGIC);
+    buffer.append(SNAPSHOT_HEADER - SNAPSHOT_MAGIC.size(), '\0');  // 用户数最后填写
+    uint64_t count = 0;
+    bool ok = true;
+    for (Shard& shard : m_shards) {
+        std::shared_lock<std::shared_mutex> shard_lock(shard.mutex);
+        for (const Slot& slot : shard.slots) {
+            if (slot.hash == 0) continue;
+            append_record(buffer, slot.username, slot.password);
+            ++count;
+        }
+        if (buffer.size() >= SNAPSHOT_FLUSH_BYTES) {
+            ok = ok && write_all(fd, buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    }
+    ok = ok && write_all(fd, buffer.data(), buffer.size());
+    ok = ok && ::pwrite(fd, &count, sizeof(count), static_cast<off_t>(SNAPSHOT_MAGIC.size()))
+                   == static_cast<ssize_t>(sizeof(count));
+    ok = ok && ::fsync(fd) == 0;
+    ::close(fd);
+    if (!ok || ::rename(tmp.c_str(), snapshot.c_str()) != 0) {
+        spdlog::error("Memory user store: writing {} failed: {}", snapshot, strerror(errno));
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    // 快照落盘后才能去掉日志（之后崩溃时日志中的记录与快照重复，重放时忽略）
+    sync_dir(snapshot);
+    {
+        // 等正在写的一组日志写完，替换日志文件期间没有写入
+        std::unique_lock<std::mutex> lock(m_log_mutex);
+        m_log_cond.wait(lock, [this]() { return !m_log_writing; });
+        if (!drop_log_prefix(covered)) {
+            return false;
+        }
+    }
+    m_compactions.fetch_add(1, std::memory_order_relaxed);
+
+    spdlog::info("Memory user store: wrote snapshot of {} users in {} ms", count,
+                 std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+    return true;
+}
+
+bool MemoryUserService::drop_log_prefix(uint64_t covered) {
+    const uint64_t total = m_log_bytes.load();
+    if (covered == total) {
+        if (::ftruncate(m_log_fd, 0) != 0) {
+            spdlog::error("Memory user store: cannot truncate the log: {}", strerror(errno));
+            return false;
+        }
+        m_log_bytes = 0;
+        return true;
+    }
+
+    // 写快照期间追加的记录（通常很少）复制到新日志，替换旧日志
+    std::string tail(static_cast<size_t>(total - covered), '\0');
+    size_t done = 0;
+    while (done < tail.size()) {
+        const ssize_t n = ::pread(m_log_fd, &tail[done], tail.size() - done, static_cast<off_t>(covered + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            spdlog::error("Memory user store: cannot read the log: {}", strerror(errno));
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    const std::string log_file = m_options.path + ".log";
+    const std::string tmp = log_file + ".tmp";
+    const int fd = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0 || !write_all(fd, tail.data(), tail.size()) || ::fdatasync(fd) != 0
+        || ::rename(tmp.c_str(), log_file.c_str()) != 0) {
+        // 保留旧日志：其中的记录与快照重复，重放时忽略
+        spdlog::error("Memory user store: rewriting the log failed: {}", strerror(errno));
+        if (fd >= 0) ::close(fd);
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    sync_dir(log_file);
+    ::close(m_log_fd);
+    m_log_fd = fd;
+    m_log_bytes = tail.size();
+    return true;
+}
+
+MemoryUserStats MemoryUserService::GetStats() const {
+    MemoryUserStats stats;
+    stats.users = m_users.load(std::memory_order_relaxed);
+    stats.log_bytes = m_log_bytes.load(std::memory_order_relaxed);
+    stats.compactions = m_compactions.load(std::memory_order_relaxed);
+    stats.log_failures = m_log_failures.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,137 @@
+#ifndef MEMORY_USER_SERVICE_H
+#define MEMORY_USER_SERVICE_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "user_service.hpp"
+
+// 内存用户存储参数
+struct MemoryUserOptions {
+    std::string path = "data/users";          // 快照为 path.snap，追加日志为 path.log；为空时不持久化
+    size_t expected_users = 100000;           // 启动时预留的容量（快照中的用户数更多时按快照预留）
+    size_t compact_log_bytes = 64 * 1024 * 1024;  // 日志超过该大小时由后台线程写新快照并清空日志，0 为不压缩
+    // 写日志后 fdatasync（关闭时进程崩溃不丢注册，断电可能丢最近的注册）。日志按组提交：
+    // 并发的注册攒成一组由一个线程 write + fdatasync，每组一次 fsync，组内的注册都要等它完成
+    bool sync_log = false;
+};
+
+// 内存用户存储统计快照
+struct MemoryUserStats {
+    uint64_t users;         // 用户数
+    uint64_t log_bytes;     // 当前追加日志大小
+    uint64_t compactions;   // 写快照并清空日志的次数
+    uint64_t log_failures;  // 写日志失败（注册返回失败）的次数
+};
+
+// 不依赖数据库的 UserService：用户保存在进程内存中，用于压测 HTTP 栈和没有数据库的小节点。
+//   - 按用户名哈希分成 SHARD_COUNT 个分片，每个分片一把读写锁 + 开放寻址（线性探测）哈希表，
+//     登录只加读锁；
+//   - 注册在日志锁内查重后排队，由一个线程把排队的记录一次写入日志（组提交），写入后才插入分片，
+//     登录和快照看不到写日志失败的注册；
+//   - 日志超过 compact_log_bytes 时由后台线程把全部用户写成新快照（临时文件 + rename），
+//     再去掉日志中已被快照覆盖的部分；写快照期间不持有日志锁，注册不受影响；
+//   - 启动时整块读入快照并重放日志，末尾不完整的日志记录（写到一半时崩溃）被截掉。
+// 只支持单进程独占数据文件，多个实例之间不共享用户
+class MemoryUserService : public UserService {
+public:
+    explicit MemoryUserService(const MemoryUserOptions& options);
+    ~MemoryUserService() override;
+
+    MemoryUserService(const MemoryUserService&) = delete;
+    MemoryUserService& operator=(const MemoryUserService&) = delete;
+
+    // 载入快照、重放日志并打开日志以便追加，失败返回 false
+    bool load();
+
+    loginResult login(const loginRequest& req) override;
+    registerResult registerUser(const registerRequest& req) override;
+    userRecord lookupUser(const std::string& username, bool read_primary) override;
+    bool scanUsernames(const std::function<void(std::string_view)>& fn) override;
+
+    // 立即写快照并去掉日志中已被快照覆盖的部分
+    bool compact();
+
+    MemoryUserStats GetStats() const;
+
+private:
+    static constexpr size_t SHARD_COUNT = 64;
+
+    struct Slot {
+        uint64_t hash = 0;  // 0 表示空槽
+        std::string username;
+        std::string password;
+    };
+
+    struct alignas(64) Shard {
+        std::shared_mutex mutex;
+        std::vector<Slot> slots;  // 容量为 2 的幂
+        size_t size = 0;
+    };
+
+    static uint64_t hash_of(std::string_view username);
+    Shard& shard_for(uint64_t hash) { return m_shards[(hash >> 58) % SHARD_COUNT]; }
+
+    // 以下在持有分片锁时调用
+    static const Slot* find(const Shard& shard, uint64_t hash, std::string_view username);
+    static bool insert(Shard& shard, uint64_t hash, std::string_view username, std::string_view password);
+    static void reserve(Shard& shard, size_t users);
+
+    // 读取快照/日志文件中的记录插入内存，返回有效数据的长度（日志末尾的损坏部分之前）
+    bool replay(const std::string& file, bool snapshot, size_t& valid_bytes);
+    // 等待写日志的注册，位于调用方栈上
+    struct LogWaiter {
+        const registerRequest* req;
+        uint64_t hash;
+        bool done = false;
+        bool ok = false;
+    };
+
+    // 持有 m_log_mutex 时调用：写出排队的全部记录（写的过程中释放锁），插入分片并唤醒这一组
+    void write_log_group(std::unique_lock<std::mutex>& lock);
+    // 追加记录到日志（sync_log 时 fdatasync），失败时截掉写了一半的部分
+    bool write_log(std::string_view records);
+    // 以下在持有 m_log_mutex 时调用
+    // 去掉日志的前 covered 字节（已写入快照），之后追加的记录保留
+    bool drop_log_prefix(uint64_t covered);
+
+    // 在持有 m_compact_mutex 时调用
+    bool write_snapshot();
+    // 日志超过 compact_log_bytes 时唤醒压缩线程
+    void request_compaction();
+    void compaction_loop();
+
+private:
+    MemoryUserOptions m_options;
+    std::array<Shard, SHARD_COUNT> m_shards;
+    std::atomic<uint64_t> m_users{0};
+
+    std::mutex m_log_mutex;
+    std::condition_variable m_log_cond;   // 一组日志写完
+    std::string m_log_buffer;             // 排队等待写入的记录
+    std::vector<LogWaiter*> m_log_waiters;  // 与 m_log_buffer 中的记录一一对应
+    std::unordered_set<std::string_view> m_log_names;  // 排队或正在写入、尚未插入分片的用户名
+    bool m_log_writing = false;           // 有线程正在写日志
+    int m_log_fd = -1;
+    std::atomic<uint64_t> m_log_bytes{0};  // 在日志锁内修改，统计时直接读取
+    std::atomic<uint64_t> m_compactions{0};
+    std::atomic<uint64_t> m_log_failures{0};
+
+    std::mutex m_compact_mutex;  // 同一时间只有一次压缩
+    std::mutex m_compactor_mutex;
+    std::condition_variable m_compactor_cond;
+    std::atomic<bool> m_compact_pending{false};
+    std::atomic<uint64_t> m_compact_at{0};  // 日志达到该大小时触发压缩，失败后推迟一个阈值
+    bool m_stopping = false;
+    std::thread m_compactor;
+};
+
+#endif
@@ -0,0 +1,134 @@
+#include "register_batcher.hpp"
+#include <algorithm>
+#include "spdlog/spdlog.h"
+
+RegisterBatcher::RegisterBatcher(UserService& inner, const RegisterBatchOptions& options)
+    : m_inner(inner), m_options(options) {
+    if (!enabled()) {
+        return;
+    }
+    const int threads = std::max(1, m_options.flush_threads);
+    for (int i = 0; i < threads; ++i) {
+        m_flushers.emplace_back([this]() { flush_loop(); });
+    }
+}
+
+RegisterBatcher::~RegisterBatcher() {
+    stop();
+}
+
+void RegisterBatcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_queue_cond.notify_all();
+    for (std::thread& flusher : m_flushers) {
+        flusher.join();
+    }
+    m_flushers.clear();
+}
+
+loginResult RegisterBatcher::login(const loginRequest& req) {
+    return m_inner.login(req);
+}
+
+userRecord RegisterBatcher::lookupUser(const std::string& username, bool read_primary) {
+    return m_inner.lookupUser(username, read_primary);
+}
+
+bool RegisterBatcher::scanUsernames(const std::function<void(std::string_view)>& fn) {
+    return m_inner.scanUsernames(fn);
+}
+
+std::vector<registerResult> RegisterBatcher::registerBatch(const std::vector<const registerRequest*>& reqs) {
+    return m_inner.registerBatch(reqs);
+}
+
+registerResult RegisterBatcher::registerUser(const registerRequest& req) {
+    Pending pending{&req, Clock::now(), registerResult{}, false};
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!enabled() || m_stopping) {
+        lock.unlock();
+        return m_inner.registerUser(req);
+    }
+    m_queue.push_back(&pending);
+    // 新的一批开始计时或攒满一批时唤醒提交线程
+    if (m_queue.size() == 1 || m_queue.size() >= m_options.max_rows) {
+        m_queue_cond.notify_one();
+    }
+    m_done_cond.wait(lock, [&pending]() { return pending.done; });
+    return std::move(pending.result);
+}
+
+void RegisterBatcher::flush_loop() {
+    const auto window = std::chrono::microseconds(m_options.window_us);
+    std::vector<Pending*> batch;
+    std::vector<const registerRequest*> reqs;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_queue_cond.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+        if (m_queue.empty()) {
+            break;  // 停止且没有排队的请求
+        }
+
+        // 从这批第一个请求入队算起，最多等待 window；停止时不再等待
+        const auto deadline = m_queue.front()->enqueued + window;
+        m_queue_cond.wait_until(lock, deadline, [this]() {
+            return m_stopping || m_queue.size() >= m_options.max_rows;
+        });
+        if (m_queue.empty()) {
+            continue;  // 已被其他提交线程取走
+        }
+
+        const size_t count = std::min(m_queue.size(), m_options.max_rows);
+        if (count == m_options.max_rows) {
+            ++m_full;
+        }
+        batch.assign(m_queue.begin(), m_queue.begin() + static_cast<std::ptrdiff_t>(count));
+        m_queue.erase(m_queue.begin(), m_queue.begin() + static_cast<std::ptrdiff_t>(count));
+        // 剩余的请求交给其他提交线程，作为下一批
+        if (!m_queue.empty()) {
+            m_queue_cond.notify_one();
+        }
+        lock.unlock();
+
+        // 异常不能逃出提交线程（std::terminate），这一批的调用方也必须被唤醒：
+        // 捕获后 results 为空，下面把整批标记为"注册失败"
+        std::vector<registerResult> results;
+        try {
+            reqs.clear();
+            for (Pending* pending : batch) {
+                reqs.push_back(pending->req);
+            }
+            results = m_inner.registerBatch(reqs);
+        } catch (const std::exception& e) {
+            spdlog::error("Batch register of {} users threw: {}", count, e.what());
+            results.clear();
+        } catch (...) {
+            spdlog::error("Batch register of {} users threw an unknown exception", count);
+            results.clear();
+        }
+        ++m_batches;
+        m_rows += count;
+        m_batch_rows.record(count);
+
+        lock.lock();
+        for (size_t i = 0; i < count; ++i) {
+            if (i < results.size()) {
+                batch[i]->result = std::move(results[i]);
+            } else {
+                batch[i]->result.success = false;
+                batch[i]->result.msg = "注册失败";
+            }
+            batch[i]->done = true;
+        }
+        m_done_cond.notify_all();
+    }
+}
+
+RegisterBatchStats RegisterBatcher::GetStats() const {
+    return RegisterBatchStats{m_batches.load(), m_rows.load(), m_full.load(), &m_batch_rows};
+}
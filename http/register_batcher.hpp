@@ -0,0 +1,86 @@
+#ifndef REGISTER_BATCHER_H
+#define REGISTER_BATCHER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "histogram.hpp"
+#include "user_service.hpp"
+
+// 注册批处理参数
+struct RegisterBatchOptions {
+    size_t max_rows = 64;   // 每批最多的注册数，达到后立即提交；不超过 1 时关闭批处理
+    int window_us = 2000;   // 一批中第一个请求最多等待多久（微秒）
+    int flush_threads = 2;  // 同时执行的批次数
+};
+
+// 注册批处理统计快照
+struct RegisterBatchStats {
+    uint64_t batches;   // 已提交的批次数
+    uint64_t rows;      // 已处理的注册数
+    uint64_t full;      // 因达到 max_rows 提前提交的批次数
+    const LatencyHistogram* batch_rows;  // 每批的行数分布
+};
+
+// 注册的组提交（group commit）：并发的注册请求先排队，由提交线程按
+// "等满 window_us 或攒够 max_rows" 取出一批，交给下层 UserService::registerBatch
+// 在一个事务里完成，每个请求等待并取回自己那一行的结果。
+// 一次提交（一次 fsync）分摊到整批注册上；每批的行数不超过同时在等待的调用方数量，
+// 即 DB 执行器的线程数
+class RegisterBatcher : public UserService {
+public:
+    RegisterBatcher(UserService& inner, const RegisterBatchOptions& options);
+    ~RegisterBatcher() override;
+
+    RegisterBatcher(const RegisterBatcher&) = delete;
+    RegisterBatcher& operator=(const RegisterBatcher&) = delete;
+
+    bool enabled() const { return m_options.max_rows > 1; }
+
+    loginResult login(const loginRequest& req) override;
+    registerResult registerUser(const registerRequest& req) override;
+    std::vector<registerResult> registerBatch(const std::vector<const registerRequest*>& reqs) override;
+    userRecord lookupUser(const std::string& username, bool read_primary) override;
+    bool scanUsernames(const std::function<void(std::string_view)>& fn) override;
+
+    // 停止提交线程，排队中的请求处理完再返回
+    void stop();
+
+    RegisterBatchStats GetStats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // 排队中的注册请求，位于调用方栈上，调用方等待 done
+    struct Pending {
+        const registerRequest* req;
+        Clock::time_point enqueued;
+        registerResult result;
+        bool done = false;
+    };
+
+    void flush_loop();
+
+private:
+    UserService& m_inner;
+    RegisterBatchOptions m_options;
+
+    std::mutex m_mutex;
+    std::condition_variable m_queue_cond;  // 提交线程等待新请求/攒满一批
+    std::condition_variable m_done_cond;   // 调用方等待自己的结果
+    std::deque<Pending*> m_queue;
+    bool m_stopping = false;
+    std::vector<std::thread> m_flushers;
+
+    std::atomic<uint64_t> m_batches{0};
+    std::atomic<uint64_t> m_rows{0};
+    std::atomic<uint64_t> m_full{0};
+    LatencyHistogram m_batch_rows;
+};
+
+#endif
@@ -0,0 +1,197 @@
+#include "router.hpp"
+#include <stdexcept>
+
+namespace {
+
+const char* method_name(HttpRequest::METHOD method) {
+    static constexpr const char* names[] = {"GET", "POST", "HEAD", "PUT", "DELETE",
+                                            "TRACE", "OPTIONS", "CONNECT", "PATCH", "ANY"};
+    return names[static_cast<size_t>(method)];
+}
+
+}  // namespace
+
+Router::Router(UserController& userController) {
+    register_route(METHOD::POST, "/welcome",
+        RouteHandler::bind<&UserController::handle_login_or_register>(&userController).offload());
+    register_route("/favicon.ico",
+        RouteHandler::bind<&UserController::handle_favicon>(&userController));
+    register_route("/",
+        RouteHandler::bind<&UserController::handle_main>(&userController));
+}
+
+void Router::register_route(METHOD method, std::string_view path, RouteHandler handler) {
+    if (path.empty() || path[0] != '/') {
+        throw std::invalid_argument("route must start with '/': " + std::string(path));
+    }
+    handler.route_id = static_cast<uint16_t>(route_names_.size());
+    insert(&root, path, method, handler);
+    route_names_.push_back(method == METHOD::UNKNOWN ? std::string(path)
+                                                     : std::string(method_name(method)) + " " + std::string(path));
+}
+
+void Router::insert(Node* node, std::string_view path, METHOD method, RouteHandler handler) {
+    while (!path.empty()) {
+        if (path[0] == ':' || path[0] == '*') {
+            const bool wildcard = path[0] == '*';
+            const size_t name_end = std::min(path.find('/'), path.size());
+            const std::string_view name = path.substr(1, name_end - 1);
+            if (name.empty()) {
+                throw std::invalid_argument("route parameter without name");
+            }
+            if (wildcard && name_end != path.size()) {
+                throw std::invalid_argument("wildcard must be the last route segment: " + std::string(path));
+            }
+
+            std::unique_ptr<Node>& child = wildcard ? node->wildcard_child : node->param_child;
+            if (!child) {
+                child = std::make_unique<Node>();
+                child->param_name = std::string(name);
+            } else if (child->param_name != name) {
+                throw std::invalid_argument("conflicting route parameter names: "
+                                            + child->param_name + " vs " + std::string(name));
+            }
+            node = child.get();
+            path.remove_prefix(name_end);
+            continue;
+        }
+
+        // 静态片段：到下一个参数/通配为止
+        const size_t static_len = std::min(path.find_first_of(":*"), path.size());
+        const std::string_view segment = path.substr(0, static_len);
+
+        const size_t idx = node->indices.find(segment[0]);
+        if (idx == std::string::npos) {
+            auto child = std::make_unique<Node>();
+            child->prefix = std::string(segment);
+            node->indices.push_back(segment[0]);
+            node->children.push_back(std::move(child));
+            node = node->children.back().get();
+            path.remove_prefix(segment.size());
+            continue;
+        }
+
+        // 与已有子节点求公共前缀，不完全匹配时拆分该子节点
+        Node* child = node->children[idx].get();
+        size_t common = 0;
+        while (common < segment.size() && common < child->prefix.size()
+               && segment[common] == child->prefix[common]) {
+            ++common;
+        }
+        if (common < child->prefix.size()) {
+            auto split = std::make_unique<Node>();
+            split->prefix = child->prefix.substr(0, common);
+            child->prefix.erase(0, common);
+            split->indices.push_back(child->prefix[0]);
+            split->children.push_back(std::move(node->children[idx]));
+            node->children[idx] = std::move(split);
+            child = node->children[idx].get();
+        }
+        node = child;
+        path.remove_prefix(common);
+    }
+
+    node->handlers[static_cast<size_t>(method)] = handler;
+    node->has_handler = true;
+
+    node->allow.clear();
+    for (size_t i = 0; i < static_cast<size_t>(METHOD::UNKNOWN); ++i) {
+        if (node->handlers[i]) {
+            if (!node->allow.empty()) node->allow += ", ";
+            node->allow += method_name(static_cast<METHOD>(i));
+        }
+    }
+}
+
+const Router::Node* Router::match(const Node* node, std::string_view path, HttpRequest& req) const {
+    // 没有参数/通配子节点时不存在回溯，沿静态子节点迭代下降
+    while (!path.empty() && !node->param_child && !node->wildcard_child) {
+        const size_t idx = node->indices.find(path[0]);
+        if (idx == std::string::npos) return nullptr;
+        const Node* child = node->children[idx].get();
+        if (path.compare(0, child->prefix.size(), child->prefix) != 0) return nullptr;
+        path.remove_prefix(child->prefix.size());
+        node = child;
+    }
+
+    if (path.empty()) {
+        if (node->has_handler) return node;
+        // "/files/" 也能匹配 "/files/*path"（通配为空）
+        if (node->wildcard_child && node->wildcard_child->has_handler) {
+            if (!req.add_param(node->wildcard_child->param_name, path)) return nullptr;
+            return node->wildcard_child.get();
+        }
+        return nullptr;
+    }
+
+    // 静态子节点
+    const size_t idx = node->indices.find(path[0]);
+    if (idx != std::string::npos) {
+        const Node* child = node->children[idx].get();
+        if (path.compare(0, child->prefix.size(), child->prefix) == 0) {
+            if (const Node* found = match(child, path.substr(child->prefix.size()), req)) {
+                return found;
+            }
+        }
+    }
+
+    // 参数段：匹配到下一个 '/'
+    if (node->param_child) {
+        const size_t seg_end = std::min(path.find('/'), path.size());
+        if (seg_end > 0) {
+            const size_t saved = req.get_param_count();
+            if (req.add_param(node->param_child->param_name, path.substr(0, seg_end))) {
+                if (const Node* found = match(node->param_child.get(), path.substr(seg_end), req)) {
+                    return found;
+                }
+            }
+            req.truncate_params(saved);
+        }
+    }
+
+    // 通配：匹配剩余全部路径
+    if (node->wildcard_child && node->wildcard_child->has_handler) {
+        if (req.add_param(node->wildcard_child->param_name, path)) {
+            return node->wildcard_child.get();
+        }
+    }
+    return nullptr;
+}
+
+const RouteHandler* Router::resolve(HttpRequest& req, HTTP_CODE& status) const {
+    std::string_view url = req.get_url();
+    size_t pos = url.find('?');
+    if (pos != std::string_view::npos) {
+        url = url.substr(0, pos);
+    }
+
+    req.truncate_params(0);
+    const Node* node = match(&root, url, req);
+    if (!node) {
+        status = HTTP_CODE::NO_RESOURCE;
+        return nullptr;
+    }
+
+    const RouteHandler& handler = node->handlers[static_cast<size_t>(req.get_method())];
+    if (handler) {
+        req.set_route_id(handler.route_id);
+        return &handler;
+    }
+    const RouteHandler& any = node->handlers[static_cast<size_t>(METHOD::UNKNOWN)];
+    if (any) {
+        req.set_route_id(any.route_id);
+        return &any;
+    }
+    req.set_allowed_methods(node->allow);
+    status = HTTP_CODE::METHOD_NOT_ALLOWED;
+    return nullptr;
+}
+
+HTTP_CODE Router::dispatch(HttpRequest& req, HttpResponse& res) const {
+    HTTP_CODE status = HTTP_CODE::NO_RESOURCE;
+    const RouteHandler* handler = resolve(req, status);
+    if (!handler) {
+        return status;
+    }
+    return (*handler)(req, res);
+}
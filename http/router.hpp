@@ -1,51 +1,95 @@
 #ifndef ROUTER_H
 #define ROUTER_H
 
-#include <unordered_map>
-#include <functional>
-#include "http_parser.hpp" 
-#include "user_controller.hpp" 
+#include <array>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "http_parser.hpp"
+#include "user_controller.hpp"
 
-using RouteHandler = std::function<HTTP_CODE(HttpRequest&, HttpResponse&)>;
+// 路由处理函数：函数指针 + 上下文指针，注册和分发都不做类型擦除的堆分配
+struct RouteHandler {
+    using Fn = HTTP_CODE (*)(void* ctx, HttpRequest& req, HttpResponse& res);
 
-class Router {
-public:
-    Router(UserController& userController) {
-        register_route("/welcome", 
-            [&](HttpRequest& req, HttpResponse& res) {
-                return userController.handle_login_or_register(req, res);
-            }
-        );
-        
-        register_route("/favicon.ico", 
-            [&](HttpRequest& req, HttpResponse& res) {
-                return userController.handle_favicon(req, res);
-            });
-        register_route("/", 
-            [&](HttpRequest& req, HttpResponse& res) {
-                return userController.handle_main(req, res);
-            });
+    Fn fn = nullptr;
+    void* ctx = nullptr;
+    bool blocking = false;  // 处理函数会阻塞（访问数据库），由 DB 执行器执行而不是网络线程
+    uint16_t route_id = 0;  // 注册时由 Router 分配
+
+    explicit operator bool() const { return fn != nullptr; }
+    HTTP_CODE operator()(HttpRequest& req, HttpResponse& res) const { return fn(ctx, req, res); }
+
+    // 标记为阻塞处理函数：RouteHandler::bind<...>(&controller).offload()
+    RouteHandler offload() const {
+        RouteHandler handler = *this;
+        handler.blocking = true;
+        return handler;
     }
 
-    void register_route(const std::string& path, RouteHandler handler) {
-        routes[path] = std::move(handler);
+    // 绑定对象的成员函数：RouteHandler::bind<&UserController::handle_main>(&controller)
+    template <auto Method, typename T>
+    static RouteHandler bind(T* obj) {
+        return RouteHandler{
+            [](void* ctx, HttpRequest& req, HttpResponse& res) {
+                return (static_cast<T*>(ctx)->*Method)(req, res);
+            },
+            obj};
     }
+};
+
+// 压缩前缀树（radix tree）路由，按 string_view 匹配，支持：
+//   - 按请求方法注册（METHOD::UNKNOWN 表示匹配任意方法）
+//   - ":name" 匹配一个路径段，"*name" 匹配剩余全部路径，结果保存在 HttpRequest 的路径参数中
+// 匹配优先级：静态片段 > 参数段 > 通配
+class Router {
+public:
+    using METHOD = HttpRequest::METHOD;
+
+    Router() = default;
+    explicit Router(UserController& userController);
 
-    HTTP_CODE dispatch(HttpRequest& req, HttpResponse& res) {
-        std::string url = req.get_url();
-        size_t pos = url.find('?'); 
-        if (pos != std::string::npos) {
-            url = url.substr(0, pos);
-        }
-        auto it = routes.find(url);
-        if (it != routes.end()) {
-            return it->second(req, res); 
-        }
-        return HTTP_CODE::NO_RESOURCE;
+    Router(const Router&) = delete;
+    Router& operator=(const Router&) = delete;
+
+    // 注册路由，路径冲突（同一位置的参数名不同、通配不在末尾）时抛出 std::invalid_argument
+    void register_route(METHOD method, std::string_view path, RouteHandler handler);
+    void register_route(std::string_view path, RouteHandler handler) {
+        register_route(METHOD::UNKNOWN, path, handler);
     }
 
+    // 查找请求对应的处理函数并填充路径参数；找不到时返回 nullptr，status 为 404 或 405
+    // （405 时把该路径已注册的方法写入 req 的 allowed_methods）
+    const RouteHandler* resolve(HttpRequest& req, HTTP_CODE& status) const;
+
+    // 查找并直接在当前线程执行处理函数
+    HTTP_CODE dispatch(HttpRequest& req, HttpResponse& res) const;
+
+    // 各路由的名称（"POST /welcome"，不限方法时只有路径），下标为路由编号，0 为未匹配
+    const std::vector<std::string>& route_names() const { return route_names_; }
+
+private:
+    static constexpr size_t METHOD_COUNT = static_cast<size_t>(METHOD::UNKNOWN) + 1;
+
+    struct Node {
+        std::string prefix;                         // 静态片段（压缩后的公共前缀）
+        std::string indices;                        // 各静态子节点前缀的首字符
+        std::vector<std::unique_ptr<Node>> children;
+        std::unique_ptr<Node> param_child;          // ":name" 子节点
+        std::unique_ptr<Node> wildcard_child;       // "*name" 子节点
+        std::string param_name;                     // 参数/通配节点的参数名
+        std::array<RouteHandler, METHOD_COUNT> handlers{};  // 下标为方法，UNKNOWN 为任意方法
+        std::string allow;                          // 已注册的方法（"GET, POST"），405 响应的 Allow 头
+        bool has_handler = false;
+    };
+
+    void insert(Node* node, std::string_view path, METHOD method, RouteHandler handler);
+    const Node* match(const Node* node, std::string_view path, HttpRequest& req) const;
+
 private:
-    std::unordered_map<std::string, RouteHandler> routes; 
+    Node root;
+    std::vector<std::string> route_names_{"unmatched"};
 };
 
-#endif
\ No newline at end of file
+#endif
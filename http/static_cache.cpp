@@ -0,0 +1,187 @@
+#include "static_cache.hpp"
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include <mutex>
+#include "http_responser.hpp"
+#include "spdlog/spdlog.h"
+
+StaticFileCache* StaticFileCache::GetInstance() {
+    static StaticFileCache cache;
+    return &cache;
+}
+
+void StaticFileCache::init(size_t max_bytes, size_t max_file_size, int revalidate_ms) {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    m_max_bytes = max_bytes;
+    m_max_file_size = max_file_size;
+    m_revalidate_ms = revalidate_ms;
+    m_files.clear();
+    m_bytes = 0;
+    m_uncacheable = 0;
+}
+
+int64_t StaticFileCache::now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+CachedFilePtr StaticFileCache::get(const std::string& full_path, const std::string& requested_path, int& error_status) {
+    const int64_t now = now_ms();
+    error_status = 0;
+    bool stale = false;
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        auto it = m_files.find(full_path);
+        if (it != m_files.end()) {
+            CachedFilePtr file = it->second;
+            lock.unlock();
+
+            if (is_fresh(*file, full_path, now)) {
+                if (file->uncacheable) {
+                    error_status = file->error_status;
+                    return nullptr;
+                }
+                file->last_used.store(now, std::memory_order_relaxed);
+                return file;
+            }
+            stale = true;
+        }
+    }
+
+    // 未命中或文件已修改，重新载入；读取失败且没有旧条目要移除时不加写锁
+    CachedFilePtr file = load(full_path, requested_path);
+    if (!file && !stale) {
+        return nullptr;
+    }
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    auto it = m_files.find(full_path);
+    if (it != m_files.end()) {
+        m_bytes -= it->second->body.size();
+        m_uncacheable -= it->second->uncacheable ? 1 : 0;
+        m_files.erase(it);
+    }
+    if (!file) {
+        return nullptr;
+    }
+    insert(full_path, file);
+    if (file->uncacheable) {
+        error_status = file->error_status;
+        return nullptr;
+    }
+    return file;
+}
+
+bool StaticFileCache::is_fresh(const CachedFile& file, const std::string& full_path, int64_t now) const {
+    int64_t checked = file.checked_at.load(std::memory_order_relaxed);
+    if (now - checked < m_revalidate_ms) {
+        return true;
+    }
+    // 只允许一个线程执行本轮校验，其余线程继续使用当前条目
+    if (!file.checked_at.compare_exchange_strong(checked, now, std::memory_order_relaxed)) {
+        return true;
+    }
+
+    struct stat st;
+    if (stat(full_path.c_str(), &st) < 0) {
+        return file.size < 0;  // 仍然不存在
+    }
+    return st.st_size == file.size
+        && st.st_mtim.tv_sec == file.mtime.tv_sec
+        && st.st_mtim.tv_nsec == file.mtime.tv_nsec
+        && st.st_ctim.tv_sec == file.ctime.tv_sec
+        && st.st_ctim.tv_nsec == file.ctime.tv_nsec;
+}
+
+CachedFilePtr StaticFileCache::load(const std::string& full_path, const std::string& requested_path) {
+    auto file = std::make_shared<CachedFile>();
+    file->checked_at.store(now_ms(), std::memory_order_relaxed);
+    file->last_used.store(now_ms(), std::memory_order_relaxed);
+
+    struct stat st;
+    if (stat(full_path.c_str(), &st) < 0) {
+        file->mtime = timespec{0, 0};
+        file->ctime = timespec{0, 0};
+        file->size = -1;
+        file->uncacheable = true;
+        file->error_status = 404;
+        return file;
+    }
+    // 不可读和目录记录错误状态（与常规路径的判断顺序一致）；空文件和超过上限的文件不缓存内容，交给常规路径处理
+    file->mtime = st.st_mtim;
+    file->ctime = st.st_ctim;
+    file->size = st.st_size;
+    if (!(st.st_mode & S_IROTH)) {
+        file->uncacheable = true;
+        file->error_status = 403;
+        return file;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        file->uncacheable = true;
+        file->error_status = 400;
+        return file;
+    }
+    if (!S_ISREG(st.st_mode) || st.st_size == 0 || static_cast<size_t>(st.st_size) > m_max_file_size) {
+        file->uncacheable = true;
+        return file;
+    }
+
+    int fd = open(full_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    file->body.resize(static_cast<size_t>(st.st_size));
+    size_t have_read = 0;
+    while (have_read < file->body.size()) {
+        const ssize_t n = read(fd, &file->body[have_read], file->body.size() - have_read);
+        if (n <= 0) {
+            close(fd);
+            return nullptr;
+        }
+        have_read += static_cast<size_t>(n);
+    }
+    close(fd);
+
+    // 预先序列化两种连接状态下的响应头
+    HttpResponser::append_file_headers(file->header_keep_alive, file->body.size(), requested_path, true);
+    HttpResponser::append_file_headers(file->header_close, file->body.size(), requested_path, false);
+
+    SPDLOG_DEBUG("Static cache loaded {} ({} bytes)", full_path, file->body.size());
+    return file;
+}
+
+void StaticFileCache::insert(const std::string& full_path, CachedFilePtr file) {
+    if (file->uncacheable) {
+        if (m_uncacheable >= MAX_UNCACHEABLE) {
+            return;
+        }
+        ++m_uncacheable;
+        m_files.emplace(full_path, std::move(file));
+        return;
+    }
+    // 容量不足时按最近最少使用淘汰
+    while (m_bytes + file->body.size() > m_max_bytes && !m_files.empty()) {
+        auto victim = m_files.begin();
+        for (auto it = m_files.begin(); it != m_files.end(); ++it) {
+            if (it->second->last_used.load(std::memory_order_relaxed)
+                < victim->second->last_used.load(std::memory_order_relaxed)) {
+                victim = it;
+            }
+        }
+        m_bytes -= victim->second->body.size();
+        m_uncacheable -= victim->second->uncacheable ? 1 : 0;
+        m_files.erase(victim);
+    }
+    if (m_bytes + file->body.size() > m_max_bytes) {
+        return;
+    }
+
+    m_bytes += file->body.size();
+    m_files.emplace(full_path, std::move(file));
+}
+
+size_t StaticFileCache::size_bytes() const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_bytes;
+}
@@ -0,0 +1,73 @@
+#ifndef STATIC_CACHE_H
+#define STATIC_CACHE_H
+
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <sys/stat.h>
+
+// 缓存的静态文件：文件内容 + 预先序列化的响应头
+struct CachedFile {
+    std::string body;
+    std::string header_keep_alive;   // 状态行和 Date 之后的响应头（Connection: keep-alive）
+    std::string header_close;        // 状态行和 Date 之后的响应头（Connection: close）
+    struct timespec mtime;           // 载入时的修改时间
+    struct timespec ctime;           // 载入时的状态修改时间（权限变化只改变它）
+    off_t size;                      // 载入时的文件大小（文件不存在时为 -1）
+    bool uncacheable = false;        // 否定条目：文件不存在或不宜缓存，命中时返回 nullptr，不再 stat
+    int error_status = 0;            // 否定条目对应的错误状态（404/403/400），0 为交给常规文件路径（过大、空文件）
+    mutable std::atomic<int64_t> checked_at{0};  // 上次校验时间（毫秒）
+    mutable std::atomic<int64_t> last_used{0};   // 上次命中时间（毫秒），用于淘汰
+
+    const std::string& header(bool keep_alive) const {
+        return keep_alive ? header_keep_alive : header_close;
+    }
+};
+
+using CachedFilePtr = std::shared_ptr<const CachedFile>;
+
+// 有界的静态文件缓存（所有连接/分片共享），以解析后的完整路径为键。
+// 命中时不再 stat/open/mmap，也不再查扩展名、格式化响应头（只写入状态行和 Date）；
+// 每个条目最多每 revalidate_ms 毫秒 stat 一次，修改时间或大小变化则重新载入。
+// 不存在和不宜缓存的文件也记录为否定条目（同样按 revalidate_ms 校验），热点 404 和大文件不会每次都加写锁。
+class StaticFileCache {
+public:
+    static StaticFileCache* GetInstance();
+
+    // max_bytes 为 0 时关闭缓存
+    void init(size_t max_bytes, size_t max_file_size, int revalidate_ms);
+    bool enabled() const { return m_max_bytes > 0; }
+
+    // 获取文件；未缓存或已过期时载入。未命中缓存内容时返回 nullptr：
+    // error_status 非 0 时文件不存在/不可读/是目录（404/403/400），调用方直接给出错误响应，不必再 stat；
+    // 为 0 时（过大、空文件、读取失败）由调用方走常规文件路径
+    CachedFilePtr get(const std::string& full_path, const std::string& requested_path, int& error_status);
+
+    size_t size_bytes() const;
+
+private:
+    StaticFileCache() = default;
+
+    // 载入文件；不存在或不宜缓存时返回否定条目，读取失败返回 nullptr（不缓存）
+    CachedFilePtr load(const std::string& full_path, const std::string& requested_path);
+    bool is_fresh(const CachedFile& file, const std::string& full_path, int64_t now_ms) const;
+    void insert(const std::string& full_path, CachedFilePtr file);
+
+    static int64_t now_ms();
+
+    // 否定条目数上限（不占内容字节，防止大量不同的 404 路径使缓存无限增长）
+    static constexpr size_t MAX_UNCACHEABLE = 4096;
+
+private:
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<std::string, CachedFilePtr> m_files;
+    size_t m_bytes = 0;              // 已缓存文件内容总字节数
+    size_t m_uncacheable = 0;        // 否定条目数
+    size_t m_max_bytes = 0;          // 缓存容量
+    size_t m_max_file_size = 0;      // 单个文件上限
+    int m_revalidate_ms = 1000;      // 校验间隔
+};
+
+#endif
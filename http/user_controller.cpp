@@ -1,24 +1,34 @@
 #include "user_controller.hpp"
 
+namespace {
+
+// 注册成功后这段时间内，同一连接上的登录读主库，避开从库的复制延迟
+constexpr auto READ_YOUR_WRITES_WINDOW = std::chrono::seconds(5);
+
+}  // namespace
+
 HTTP_CODE UserController::handle_login_or_register(HttpRequest& req, HttpResponse& res) {
     if (!req.is_cgi()) {
         return HTTP_CODE::BAD_REQUEST;
     }
 
-    const std::string& content = req.get_content();
+    std::string_view content = req.get_content();
     size_t user_pos = content.find("user=");
     size_t password_pos = content.find("password=");
     size_t op_pos = content.find("op=");
-    if (user_pos == std::string::npos || password_pos == std::string::npos || op_pos == std::string::npos) {
+    if (user_pos == std::string_view::npos || password_pos == std::string_view::npos || op_pos == std::string_view::npos) {
         return HTTP_CODE::BAD_REQUEST;
     }
 
-    std::string username = content.substr(user_pos + 5, password_pos - (user_pos + 6));
-    std::string password = content.substr(password_pos + 9, op_pos - (password_pos + 10));
-    std::string op = content.substr(op_pos + 3);
+    std::string username(content.substr(user_pos + 5, password_pos - (user_pos + 6)));
+    std::string password(content.substr(password_pos + 9, op_pos - (password_pos + 10)));
+    std::string_view op = content.substr(op_pos + 3);
 
+    ConnectionState* state = req.get_connection_state();
     if (op == "login") {
-        loginResult login_res = m_service.login({username, password});
+        const bool read_primary = state
+            && std::chrono::steady_clock::now() - state->last_write < READ_YOUR_WRITES_WINDOW;
+        loginResult login_res = m_service.login({username, password, read_primary});
         if (login_res.success) {
             res.set_required_file_path("/welcome.jpg");
             return HTTP_CODE::FILE_REQUEST;
@@ -31,6 +41,9 @@ HTTP_CODE UserController::handle_login_or_register(HttpRequest& req, HttpRespons
     else if (op == "register") {
         registerResult reg_res = m_service.registerUser({username, password});
         if (reg_res.success) {
+            if (state) {
+                state->last_write = std::chrono::steady_clock::now();
+            }
             res.set_redirect_url("/?registerok=1");
         } 
         else {
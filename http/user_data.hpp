@@ -8,6 +8,7 @@ struct loginResult {
 struct loginRequest {
     std::string username;
     std::string password;
+    bool read_primary = false;  // 读主库：同一连接刚注册过，从库可能还没复制到
 };
 
 struct registerRequest {
@@ -18,4 +19,12 @@ struct registerRequest {
 struct registerResult {
     bool success;
     std::string msg;
-};
\ No newline at end of file
+};
+
+// 按用户名查到的凭据
+struct userRecord {
+    bool ok = false;     // 查询成功；false 时为数据库错误，原因见 msg
+    bool found = false;  // 用户存在
+    std::string password;
+    std::string msg;
+};
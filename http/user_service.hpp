@@ -1,14 +1,57 @@
 #ifndef USER_SERVICE_H
 #define USER_SERVICE_H
 
+#include <functional>
+#include <string_view>
+#include <vector>
 #include "user_data.hpp"
 
+class PooledConnection;
+
 // 业务接口抽象
 class UserService {
 public:
     virtual ~UserService() = default;
     virtual loginResult login(const loginRequest& req) = 0;
     virtual registerResult registerUser(const registerRequest& req) = 0;
+    // 批量注册，结果与请求一一对应（同一批内重复的用户名只有第一个可能成功）；
+    // 默认逐个调用 registerUser
+    virtual std::vector<registerResult> registerBatch(const std::vector<const registerRequest*>& reqs) {
+        std::vector<registerResult> results;
+        results.reserve(reqs.size());
+        for (const registerRequest* req : reqs) {
+            results.push_back(registerUser(*req));
+        }
+        return results;
+    }
+    // 查询用户凭据（不校验密码），供缓存等装饰层复用；read_primary 含义同 loginRequest
+    virtual userRecord lookupUser(const std::string& username, bool read_primary) = 0;
+    // 逐个回调全部已注册的用户名（流式读取，不一次性载入内存）；不支持或读取失败时返回 false
+    virtual bool scanUsernames(const std::function<void(std::string_view)>& fn) {
+        (void)fn;
+        return false;
+    }
+
+protected:
+    // 根据查到的凭据校验密码
+    static loginResult check_password(const userRecord& record, const std::string& password) {
+        loginResult res;
+        res.success = false;
+        if (!record.ok) {
+            res.msg = record.msg;
+        }
+        else if (!record.found) {
+            res.msg = "用户名不存在";
+        }
+        else if (record.password == password) {
+            res.success = true;
+            res.msg = "登录成功";
+        }
+        else {
+            res.msg = "密码错误";
+        }
+        return res;
+    }
 };
 
 // 业务接口实现
@@ -16,6 +59,26 @@ class UserServiceMain : public UserService {
 public:
     loginResult login(const loginRequest& req) override;
     registerResult registerUser(const registerRequest& req) override;
+    // 一个事务内完成整批注册，只提交一次：用一条多行 INSERT ... ON DUPLICATE KEY UPDATE 插入，
+    // 有用户名已存在时改为事务内逐行插入，按 affected rows 区分；不做加锁读，避免间隙锁死锁。
+    // 死锁时整批重试，语句失败时回滚并逐个注册，连接断开时整批失败（不确定是否已提交）
+    std::vector<registerResult> registerBatch(const std::vector<const registerRequest*>& reqs) override;
+    userRecord lookupUser(const std::string& username, bool read_primary) override;
+    bool scanUsernames(const std::function<void(std::string_view)>& fn) override;
+
+private:
+    // 整批事务的结果
+    enum class BatchStatus {
+        COMMITTED,       // 已提交，exists 为各行是否已存在
+        DUPLICATE,       // 多行插入时有用户名已存在，已回滚
+        DEADLOCK,        // 死锁（1213），事务已回滚
+        FAILED,          // 语句失败，已回滚
+        CONNECTION_LOST  // 连接断开，COMMIT 途中断开时无法确定是否已提交
+    };
+
+    // 整批事务；per_row 为 true 时逐行插入
+    BatchStatus insert_batch(PooledConnection& conn, const std::vector<const registerRequest*>& unique_reqs,
+                             bool per_row, std::vector<bool>& exists);
 };
 
 #endif
\ No newline at end of file
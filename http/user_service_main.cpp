@@ -1,54 +1,72 @@
 #include "user_service.hpp"
-#include "../mysql/mysqlpool.hpp"
+#include <algorithm>
+#include <unordered_map>
+#include "../mysql/db_cluster.hpp"
 #include "spdlog/spdlog.h"
 
-loginResult UserServiceMain::login(const loginRequest& req){
-    loginResult res;
-    res.success = false;
-    connection_pool* db_pool = connection_pool::GetInstance();
-    connPtr mysql = db_pool->GetConnection();
-    MYSQL* raw_mysql = mysql.get();
+namespace {
 
-    MYSQL_STMT* stmt = mysql_stmt_init(raw_mysql);
-    if (!stmt){
-        res.msg = "数据库预处理语句初始化失败";
-        return res;
-    }
+// 预处理语句按 SQL 文本缓存在连接上，文本必须保持不变
+const std::string LOGIN_SQL = "SELECT password FROM user WHERE username = ?";
+const std::string REGISTER_SQL = "INSERT INTO user(username, password) VALUES(?, ?)";
+const char SCAN_USERNAMES_SQL[] = "SELECT username FROM user";
+const char START_TRANSACTION_SQL[] = "START TRANSACTION";
 
-    const char* sql = "SELECT password FROM user WHERE username = ?";
-    if (mysql_stmt_prepare(stmt, sql, strlen(sql)) != 0){
-        res.msg = "数据库预处理失败";
-        mysql_stmt_close(stmt);
-        return res;
+// 批量注册的语句按行数生成，每种行数在连接上各缓存一条预处理语句；
+// 用户名已存在时不报错也不修改该行（affected rows 为 0），插入的行 affected rows 为 1
+std::string insert_users_sql(size_t count) {
+    std::string sql = "INSERT INTO user(username, password) VALUES";
+    for (size_t i = 0; i < count; ++i) {
+        sql += i ? ",(?, ?)" : "(?, ?)";
     }
+    sql += " ON DUPLICATE KEY UPDATE username = username";
+    return sql;
+}
+
+void bind_string(MYSQL_BIND& bind, const std::string& value) {
+    memset(&bind, 0, sizeof(bind));
+    bind.buffer_type = MYSQL_TYPE_STRING;
+    bind.buffer = (char*)value.c_str();
+    bind.buffer_length = value.size();
+}
+
+}  // namespace
+
+loginResult UserServiceMain::login(const loginRequest& req){
+    return check_password(lookupUser(req.username, req.read_primary), req.password);
+}
+
+userRecord UserServiceMain::lookupUser(const std::string& username, bool read_primary){
+    userRecord res;
 
     MYSQL_BIND param_bind;
     memset(&param_bind, 0, sizeof(param_bind));
     param_bind.buffer_type = MYSQL_TYPE_STRING;
-    param_bind.buffer = (char*)req.username.c_str();
-    param_bind.buffer_length = req.username.size();
-    if (mysql_stmt_bind_param(stmt, &param_bind) != 0){
-        res.msg = "参数绑定失败";
-        mysql_stmt_close(stmt);
+    param_bind.buffer = (char*)username.c_str();
+    param_bind.buffer_length = username.size();
+
+    // 登录只读，优先由从库执行（从库不可用时回退主库）；
+    // 缓存的预处理语句：每次登录只有一次 execute 往返
+    connPtr mysql;
+    MYSQL_STMT* stmt = DbCluster::GetInstance()->ExecuteRead(mysql, LOGIN_SQL, &param_bind, read_primary);
+    if (!mysql){
+        res.msg = "数据库繁忙";
         return res;
     }
-
-    if (mysql_stmt_execute(stmt) != 0){
+    if (!stmt){
         res.msg = "查询执行失败";
-        mysql_stmt_close(stmt);
         return res;
     }
 
     if (mysql_stmt_store_result(stmt) != 0) {
         res.msg = "存储结果失败";
-        mysql_stmt_close(stmt);
+        mysql_stmt_free_result(stmt);
         return res;
     }
 
-    MYSQL_RES *result = mysql_stmt_result_metadata(stmt);
     MYSQL_BIND result_bind;
     char passwd_buf[256];
-    unsigned long passwd_len;
+    unsigned long passwd_len = 0;
     memset(&result_bind, 0, sizeof(result_bind));
     result_bind.buffer_type = MYSQL_TYPE_STRING;
     result_bind.buffer = passwd_buf;
@@ -57,23 +75,18 @@ loginResult UserServiceMain::login(const loginRequest& req){
     mysql_stmt_bind_result(stmt, &result_bind);
     int fetch_result = mysql_stmt_fetch(stmt);
     if (fetch_result == 0){
-        std::string stored_passwd(passwd_buf, passwd_len);
-        if (stored_passwd == req.password){
-            res.success = true;
-            res.msg = "登录成功";
-        }
-        else{
-            res.msg = "密码错误";
-        }
+        res.ok = true;
+        res.found = true;
+        res.password.assign(passwd_buf, passwd_len);
     }
     else if (fetch_result == MYSQL_NO_DATA){
-        res.msg = "用户名不存在";
+        res.ok = true;
     }
     else{
         res.msg = "获取结果失败";
     }
-    mysql_free_result(result);
-    mysql_stmt_close(stmt);
+    // 语句留在连接的缓存中，只释放结果集
+    mysql_stmt_free_result(stmt);
 
     return res;
 }
@@ -81,20 +94,10 @@ loginResult UserServiceMain::login(const loginRequest& req){
 registerResult UserServiceMain::registerUser(const registerRequest& req){
     registerResult res;
     res.success = false;
-    connection_pool* db_pool = connection_pool::GetInstance();
-    connPtr mysql = db_pool->GetConnection();
-    MYSQL* raw_mysql = mysql.get();
-
-    MYSQL_STMT* stmt = mysql_stmt_init(raw_mysql);
-    if (!stmt){
-        res.msg = "数据库预处理语句初始化失败";
-        return res;
-    }
-
-    const char* sql = "INSERT INTO user(username, password) VALUES(?, ?)";
-    if (mysql_stmt_prepare(stmt, sql, strlen(sql)) != 0){
-        res.msg = "数据库预处理失败";
-        mysql_stmt_close(stmt);
+    // 写操作只能在主库执行
+    connPtr mysql = DbCluster::GetInstance()->GetPrimary();
+    if (!mysql){
+        res.msg = "数据库繁忙";
         return res;
     }
 
@@ -109,20 +112,14 @@ registerResult UserServiceMain::registerUser(const registerRequest& req){
     param_bind[1].buffer = (char*)req.password.c_str();
     param_bind[1].buffer_length = req.password.size();
 
-    if (mysql_stmt_bind_param(stmt, param_bind) != 0){
-        res.msg = "参数绑定失败";
-        mysql_stmt_close(stmt);
-        return res;
-    }
-
-    if (mysql_stmt_execute(stmt) != 0){
-        if (mysql_stmt_errno(stmt) == 1062){
+    MYSQL_STMT* stmt = mysql->execute(REGISTER_SQL, param_bind);
+    if (!stmt){
+        if (mysql->last_error() == 1062){
             res.msg = "用户已存在";
         }
         else{
             res.msg = "注册失败";
         }
-        mysql_stmt_close(stmt);
         return res;
     }
 
@@ -134,6 +131,184 @@ registerResult UserServiceMain::registerUser(const registerRequest& req){
         res.msg = "未插入数据";
     }
 
-    mysql_stmt_close(stmt);
     return res;
-}
\ No newline at end of file
+}
+
+std::vector<registerResult> UserServiceMain::registerBatch(const std::vector<const registerRequest*>& reqs){
+    if (reqs.size() <= 1){
+        return UserService::registerBatch(reqs);
+    }
+
+    std::vector<registerResult> results(reqs.size());
+    // 同一批内重复的用户名只插入第一个，其余沿用第一个的结果
+    std::vector<const registerRequest*> unique_reqs;
+    std::unordered_map<std::string_view, size_t> seen;
+    for (const registerRequest* req : reqs){
+        if (seen.emplace(req->username, 0).second){
+            unique_reqs.push_back(req);
+        }
+    }
+    // 按用户名排序：并发的批次以相同顺序对唯一索引加锁，不会因顺序相反而死锁
+    std::sort(unique_reqs.begin(), unique_reqs.end(),
+              [](const registerRequest* a, const registerRequest* b) { return a->username < b->username; });
+    for (size_t i = 0; i < unique_reqs.size(); ++i){
+        seen[unique_reqs[i]->username] = i;
+    }
+
+    std::vector<registerResult> unique_results(unique_reqs.size());
+    std::vector<bool> exists;
+    BatchStatus status = BatchStatus::FAILED;
+    {
+        connPtr mysql = DbCluster::GetInstance()->GetPrimary();
+        if (!mysql){
+            for (registerResult& res : results){
+                res.success = false;
+                res.msg = "数据库繁忙";
+            }
+            return results;
+        }
+        bool per_row = false;
+        for (int attempt = 0; attempt < 3; ++attempt){
+            status = insert_batch(*mysql, unique_reqs, per_row, exists);
+            if (status == BatchStatus::DUPLICATE){
+                // 有用户名已存在：多行插入无法区分是哪几行，改为事务内逐行插入
+                per_row = true;
+            }
+            else if (status == BatchStatus::DEADLOCK){
+                // 死锁时 InnoDB 已回滚整个事务，没有任何一行生效，整批重试
+                spdlog::warn("Batch register of {} users deadlocked, retrying", unique_reqs.size());
+            }
+            else{
+                break;
+            }
+        }
+    }
+
+    if (status == BatchStatus::COMMITTED){
+        for (size_t i = 0; i < unique_reqs.size(); ++i){
+            unique_results[i].success = !exists[i];
+            unique_results[i].msg = exists[i] ? "用户已存在" : "注册成功";
+        }
+    }
+    else if (status == BatchStatus::CONNECTION_LOST){
+        // 连接断开：COMMIT 途中断开时无法确定这批是否已提交，逐个重试可能把刚插入的行报成
+        // "用户已存在"，整批按失败返回
+        spdlog::warn("Batch register of {} users lost the connection, failing the batch", unique_reqs.size());
+        for (registerResult& res : unique_results){
+            res.success = false;
+            res.msg = "注册失败";
+        }
+    }
+    else{
+        // 语句失败（已回滚，没有任何一行生效）：归还连接后逐个注册，保证每行都有准确的结果
+        spdlog::warn("Batch register of {} users failed, retrying one by one", unique_reqs.size());
+        for (size_t i = 0; i < unique_reqs.size(); ++i){
+            unique_results[i] = registerUser(*unique_reqs[i]);
+        }
+    }
+
+    for (size_t i = 0; i < reqs.size(); ++i){
+        const size_t first = seen[reqs[i]->username];
+        results[i] = unique_results[first];
+        if (unique_reqs[first] != reqs[i] && unique_results[first].success){
+            results[i].success = false;
+            results[i].msg = "用户已存在";
+        }
+    }
+    return results;
+}
+
+UserServiceMain::BatchStatus UserServiceMain::insert_batch(PooledConnection& conn,
+                                                           const std::vector<const registerRequest*>& unique_reqs,
+                                                           bool per_row, std::vector<bool>& exists){
+    MYSQL* handle = conn.get();
+    exists.assign(unique_reqs.size(), false);
+
+    // 事务内的语句都不重连重试（新连接已不在原事务中），出错时整批结束
+    auto fail = [&conn](unsigned int err) {
+        if (PooledConnection::is_connection_error(err)) {
+            // 未提交的事务随旧连接回滚；重连以便连接归还后可用（重连失败时由池销毁）
+            conn.reconnect();
+            return BatchStatus::CONNECTION_LOST;
+        }
+        mysql_rollback(conn.get());
+        return err == 1213 ? BatchStatus::DEADLOCK : BatchStatus::FAILED;
+    };
+
+    if (mysql_real_query(handle, START_TRANSACTION_SQL, sizeof(START_TRANSACTION_SQL) - 1) != 0){
+        return fail(mysql_errno(handle));
+    }
+
+    std::vector<MYSQL_BIND> binds;
+    if (!per_row){
+        // 一条多行 INSERT；全部插入时各行的结果已确定
+        binds.resize(unique_reqs.size() * 2);
+        for (size_t i = 0; i < unique_reqs.size(); ++i){
+            bind_string(binds[i * 2], unique_reqs[i]->username);
+            bind_string(binds[i * 2 + 1], unique_reqs[i]->password);
+        }
+        MYSQL_STMT* stmt = conn.execute(insert_users_sql(unique_reqs.size()), binds.data(),
+                                        PooledConnection::Retry::NONE);
+        if (!stmt){
+            return fail(conn.last_error());
+        }
+        if (mysql_stmt_affected_rows(stmt) != unique_reqs.size()){
+            mysql_rollback(handle);
+            return BatchStatus::DUPLICATE;
+        }
+    }
+    else{
+        // 逐行插入，按每行的 affected rows 区分插入和已存在，仍只提交一次
+        binds.resize(2);
+        const std::string sql = insert_users_sql(1);
+        for (size_t i = 0; i < unique_reqs.size(); ++i){
+            bind_string(binds[0], unique_reqs[i]->username);
+            bind_string(binds[1], unique_reqs[i]->password);
+            MYSQL_STMT* stmt = conn.execute(sql, binds.data(), PooledConnection::Retry::NONE);
+            if (!stmt){
+                return fail(conn.last_error());
+            }
+            exists[i] = mysql_stmt_affected_rows(stmt) == 0;
+        }
+    }
+
+    // 整批只提交一次
+    if (mysql_commit(handle) != 0){
+        return fail(mysql_errno(handle));
+    }
+    return BatchStatus::COMMITTED;
+}
+
+bool UserServiceMain::scanUsernames(const std::function<void(std::string_view)>& fn){
+    // 从主库扫描：从库的复制延迟会让刚注册的用户漏在过滤器之外
+    connPtr mysql = DbCluster::GetInstance()->GetPrimary();
+    if (!mysql){
+        spdlog::warn("Username scan: no database connection");
+        return false;
+    }
+    MYSQL* conn = mysql->get();
+    if (mysql_real_query(conn, SCAN_USERNAMES_SQL, sizeof(SCAN_USERNAMES_SQL) - 1) != 0){
+        spdlog::warn("Username scan failed: {}", mysql_error(conn));
+        return false;
+    }
+
+    // mysql_use_result 逐行从服务端读取，不把整张表缓存在客户端
+    MYSQL_RES* result = mysql_use_result(conn);
+    if (!result){
+        spdlog::warn("Username scan failed: {}", mysql_error(conn));
+        return false;
+    }
+    while (MYSQL_ROW row = mysql_fetch_row(result)){
+        unsigned long* lengths = mysql_fetch_lengths(result);
+        if (row[0]){
+            fn(std::string_view(row[0], lengths[0]));
+        }
+    }
+    // 读完全部行之前出错时 mysql_fetch_row 同样返回空，用 errno 区分
+    const bool ok = mysql_errno(conn) == 0;
+    if (!ok){
+        spdlog::warn("Username scan interrupted: {}", mysql_error(conn));
+    }
+    mysql_free_result(result);
+    return ok;
+}
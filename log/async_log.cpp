@@ -0,0 +1,251 @@
+#include "async_log.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+namespace {
+
+std::atomic<uint64_t> next_sink_id{1};
+
+}  // namespace
+
+AsyncLogSink::Ring::Ring(size_t count) {
+    size_t size = 2;
+    while (size < count) {
+        size <<= 1;
+    }
+    slots.reset(new Slot[size]);
+    mask = size - 1;
+}
+
+AsyncLogSink::ThreadRings::~ThreadRings() {
+    for (auto& entry : rings) {
+        entry.second->retired.store(true, std::memory_order_release);
+    }
+}
+
+AsyncLogSink::AsyncLogSink(std::vector<spdlog::sink_ptr> sinks, const AsyncLogOptions& options)
+    : m_id(next_sink_id.fetch_add(1, std::memory_order_relaxed)),
+      m_sinks(std::move(sinks)),
+      m_options(options),
+      m_ring_slots(std::max<size_t>(2, options.ring_slots)) {
+    m_flusher = std::thread([this]() { flush_loop(); });
+}
+
+AsyncLogSink::~AsyncLogSink() {
+    stop();
+}
+
+std::shared_ptr<AsyncLogSink> AsyncLogSink::install(const AsyncLogOptions& options) {
+    std::shared_ptr<spdlog::logger> current = spdlog::default_logger();
+    auto sink = std::make_shared<AsyncLogSink>(current->sinks(), options);
+    auto logger = std::make_shared<spdlog::logger>(current->name(), sink);
+    logger->set_level(current->level());
+    logger->flush_on(current->flush_level());
+    spdlog::set_default_logger(logger);
+    return sink;
+}
+
+AsyncLogSink::Ring* AsyncLogSink::ring_for_thread() {
+    static thread_local ThreadRings local;
+    static thread_local uint64_t cached_id = 0;
+    static thread_local Ring* cached = nullptr;
+    if (cached_id == m_id) {
+        return cached;
+    }
+
+    Ring* ring = nullptr;
+    for (auto& entry : local.rings) {
+        if (entry.first == m_id) {
+            ring = entry.second.get();
+            break;
+        }
+    }
+    if (ring == nullptr) {
+        auto created = std::make_shared<Ring>(m_ring_slots);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_rings.push_back(created);
+        }
+        local.rings.emplace_back(m_id, created);
+        ring = created.get();
+    }
+    cached_id = m_id;
+    cached = ring;
+    return ring;
+}
+
+void AsyncLogSink::log(const spdlog::details::log_msg& msg) {
+    if (!m_running.load(std::memory_order_relaxed)) {
+        return;
+    }
+    Ring& ring = *ring_for_thread();
+
+    const size_t tail = ring.tail.load(std::memory_order_relaxed);
+    if (tail - ring.cached_head > ring.mask) {
+        ring.cached_head = ring.head.load(std::memory_order_acquire);
+        while (tail - ring.cached_head > ring.mask) {
+            if (m_options.overflow == LogOverflow::DROP || !m_running.load(std::memory_order_relaxed)) {
+                ring.dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            m_wake.notify_one();
+            std::this_thread::yield();
+            ring.cached_head = ring.head.load(std::memory_order_acquire);
+        }
+    }
+
+    Slot& slot = ring.slots[tail & ring.mask];
+    slot.time = msg.time;
+    slot.source = msg.source;
+    slot.thread_id = msg.thread_id;
+    slot.level = msg.level;
+    const size_t name_len = std::min(msg.logger_name.size(), SLOT_TEXT / 4);
+    const size_t text_len = std::min(msg.payload.size(), SLOT_TEXT - name_len);
+    std::memcpy(slot.text, msg.logger_name.data(), name_len);
+    std::memcpy(slot.text + name_len, msg.payload.data(), text_len);
+    slot.name_len = static_cast<uint16_t>(name_len);
+    slot.text_len = static_cast<uint16_t>(text_len);
+    ring.tail.store(tail + 1, std::memory_order_release);
+
+    // 缓冲区用掉一半时提前唤醒后台线程，不等轮询间隔
+    if (tail + 1 - ring.cached_head == (ring.mask + 1) / 2) {
+        m_wake.notify_one();
+    }
+}
+
+bool AsyncLogSink::drain(Ring& ring) {
+    size_t head = ring.head.load(std::memory_order_relaxed);
+    const size_t tail = ring.tail.load(std::memory_order_acquire);
+    if (head == tail) {
+        return false;
+    }
+    for (; head != tail; ++head) {
+        const Slot& slot = ring.slots[head & ring.mask];
+        spdlog::details::log_msg msg(slot.time, slot.source,
+                                     spdlog::string_view_t(slot.text, slot.name_len), slot.level,
+                                     spdlog::string_view_t(slot.text + slot.name_len, slot.text_len));
+        msg.thread_id = slot.thread_id;
+        for (auto& sink : m_sinks) {
+            if (!sink->should_log(msg.level)) continue;
+            try {
+                sink->log(msg);
+            } catch (const std::exception& e) {
+                std::fprintf(stderr, "async log sink error: %s\n", e.what());
+            }
+        }
+        // 逐条释放槽位，阻塞等待空间的线程可以尽早继续
+        ring.head.store(head + 1, std::memory_order_release);
+    }
+    return true;
+}
+
+void AsyncLogSink::flush_loop() {
+    const auto interval = std::chrono::milliseconds(std::max(1, m_options.flush_interval_ms));
+    std::vector<std::shared_ptr<Ring>> rings;
+    uint64_t reported_dropped = 0;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        const uint64_t flush_target = m_flush_requested;
+        const bool stopping = m_stopping;
+        rings = m_rings;
+        lock.unlock();
+
+        bool drained = false;
+        for (auto& ring : rings) {
+            drained |= drain(*ring);
+        }
+
+        // 丢弃的条数有变化时补一条告警（直接交给下层 sink，不经过缓冲区）
+        const uint64_t total_dropped = dropped();
+        if (total_dropped != reported_dropped) {
+            char text[96];
+            const int len = std::snprintf(text, sizeof(text), "Async log ring full, %llu message(s) dropped so far",
+                                          static_cast<unsigned long long>(total_dropped));
+            spdlog::details::log_msg msg(spdlog::string_view_t(), spdlog::level::warn,
+                                         spdlog::string_view_t(text, static_cast<size_t>(len)));
+            for (auto& sink : m_sinks) {
+                if (sink->should_log(msg.level)) sink->log(msg);
+            }
+            reported_dropped = total_dropped;
+            drained = true;
+        }
+        if (drained || flush_target > m_flush_done) {
+            for (auto& sink : m_sinks) {
+                sink->flush();
+            }
+        }
+
+        lock.lock();
+        // 移除已退出线程的空缓冲区
+        for (auto it = m_rings.begin(); it != m_rings.end();) {
+            Ring& ring = **it;
+            if (ring.retired.load(std::memory_order_acquire)
+                && ring.head.load(std::memory_order_relaxed) == ring.tail.load(std::memory_order_acquire)) {
+                m_retired_dropped.fetch_add(ring.dropped.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                it = m_rings.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (flush_target > m_flush_done) {
+            m_flush_done = flush_target;
+            m_flushed.notify_all();
+        }
+        if (stopping) {
+            break;
+        }
+        if (!drained) {
+            m_wake.wait_for(lock, interval, [this]() {
+                return m_stopping || m_flush_requested > m_flush_done;
+            });
+        }
+    }
+}
+
+void AsyncLogSink::flush() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_stopping) {
+        return;
+    }
+    const uint64_t target = ++m_flush_requested;
+    m_wake.notify_one();
+    m_flushed.wait(lock, [this, target]() { return m_flush_done >= target; });
+}
+
+void AsyncLogSink::set_pattern(const std::string& pattern) {
+    for (auto& sink : m_sinks) {
+        sink->set_pattern(pattern);
+    }
+}
+
+void AsyncLogSink::set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) {
+    for (auto& sink : m_sinks) {
+        sink->set_formatter(sink_formatter->clone());
+    }
+}
+
+void AsyncLogSink::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopping) {
+            return;
+        }
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    m_flusher.join();
+    m_running.store(false, std::memory_order_relaxed);
+}
+
+uint64_t AsyncLogSink::dropped() const {
+    uint64_t total = m_retired_dropped.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& ring : m_rings) {
+        total += ring->dropped.load(std::memory_order_relaxed);
+    }
+    return total;
+}
@@ -0,0 +1,106 @@
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <spdlog/sinks/sink.h>
+
+// 环形缓冲区满时的处理方式
+enum class LogOverflow {
+    DROP,   // 丢弃并计数，写日志的线程从不等待
+    BLOCK   // 等待后台线程腾出空间
+};
+
+struct AsyncLogOptions {
+    size_t ring_slots = 4096;        // 每个线程的环形缓冲区条数（向上取 2 的幂）
+    LogOverflow overflow = LogOverflow::DROP;
+    int flush_interval_ms = 20;      // 后台线程空闲时的轮询间隔
+};
+
+// 异步日志 sink：每个写日志的线程有自己的单生产者/单消费者环形缓冲区，
+// log() 只把消息（级别、时间、线程、正文）拷进本线程的缓冲区，不加锁、不格式化；
+// 唯一的后台线程依次取出各缓冲区的消息，交给原来的 sink 格式化和输出。
+// 不同线程的日志之间不保证按时间排序。超过 SLOT_TEXT 的正文被截断
+class AsyncLogSink : public spdlog::sinks::sink {
+public:
+    static constexpr size_t SLOT_TEXT = 472;
+
+    AsyncLogSink(std::vector<spdlog::sink_ptr> sinks, const AsyncLogOptions& options);
+    ~AsyncLogSink() override;
+
+    AsyncLogSink(const AsyncLogSink&) = delete;
+    AsyncLogSink& operator=(const AsyncLogSink&) = delete;
+
+    // 用异步 sink 包装默认 logger 原有的 sinks 并替换默认 logger
+    static std::shared_ptr<AsyncLogSink> install(const AsyncLogOptions& options);
+
+    void log(const spdlog::details::log_msg& msg) override;
+    // 等待调用之前写入的日志全部输出
+    void flush() override;
+    void set_pattern(const std::string& pattern) override;
+    void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) override;
+
+    // 停止后台线程，输出剩余日志；之后写入的日志被丢弃
+    void stop();
+
+    uint64_t dropped() const;
+
+private:
+    struct Slot {
+        spdlog::log_clock::time_point time;
+        spdlog::source_loc source;
+        size_t thread_id;
+        spdlog::level::level_enum level;
+        uint16_t name_len;
+        uint16_t text_len;
+        char text[SLOT_TEXT];  // logger 名称 + 正文
+    };
+
+    struct Ring {
+        explicit Ring(size_t slots);
+
+        std::unique_ptr<Slot[]> slots;
+        size_t mask;
+        alignas(64) std::atomic<size_t> head{0};     // 后台线程读取的位置
+        alignas(64) std::atomic<size_t> tail{0};     // 写日志的线程写入的位置
+        size_t cached_head = 0;                      // 写入方缓存的 head，满时才重新读取
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<bool> retired{false};            // 所属线程已退出
+    };
+
+    // 线程退出时把它的缓冲区标记为退出，后台线程取空后移除
+    struct ThreadRings {
+        std::vector<std::pair<uint64_t, std::shared_ptr<Ring>>> rings;
+        ~ThreadRings();
+    };
+
+    Ring* ring_for_thread();
+    bool drain(Ring& ring);
+    void flush_loop();
+
+private:
+    const uint64_t m_id;  // 区分线程局部缓存属于哪个 sink
+    std::vector<spdlog::sink_ptr> m_sinks;
+    AsyncLogOptions m_options;
+    size_t m_ring_slots;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;     // 唤醒后台线程
+    std::condition_variable m_flushed;  // flush() 等待完成
+    std::vector<std::shared_ptr<Ring>> m_rings;
+    uint64_t m_flush_requested = 0;
+    uint64_t m_flush_done = 0;
+    bool m_stopping = false;
+    std::atomic<bool> m_running{true};
+    std::atomic<uint64_t> m_retired_dropped{0};  // 已移除的缓冲区丢弃的条数
+    std::thread m_flusher;
+};
+
+#endif
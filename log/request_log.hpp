@@ -0,0 +1,37 @@
+#ifndef REQUEST_LOG_H
+#define REQUEST_LOG_H
+
+#include <atomic>
+#include <cstdint>
+#include <spdlog/spdlog.h>
+
+// 连接/请求路径上的日志按连接采样：每 N 个连接记录一个连接的完整日志，
+// 采样与否在连接建立时决定（每个线程各自计数，不共享计数器）
+namespace request_log {
+
+inline std::atomic<uint32_t>& sample_rate_ref() {
+    static std::atomic<uint32_t> rate{1};
+    return rate;
+}
+
+// 1 为全部记录，N 为每 N 个连接记录一个，0 为关闭
+inline void set_sample_rate(uint32_t rate) { sample_rate_ref().store(rate, std::memory_order_relaxed); }
+inline uint32_t sample_rate() { return sample_rate_ref().load(std::memory_order_relaxed); }
+
+// 新连接是否记录日志
+inline bool sample() {
+    const uint32_t rate = sample_rate();
+    if (rate <= 1) return rate == 1;
+    static thread_local uint32_t counter = 0;
+    return counter++ % rate == 0;
+}
+
+}  // namespace request_log
+
+// 仅在 sampled 为 true 时格式化并输出 info 日志
+#define REQUEST_LOG(sampled, ...)               \
+    do {                                        \
+        if (sampled) SPDLOG_INFO(__VA_ARGS__);  \
+    } while (0)
+
+#endif
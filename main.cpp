@@ -1,7 +1,9 @@
 #include <asio.hpp>
 #include <spdlog/spdlog.h>
 #include "webserver.hpp"
-#include "../mysql/mysqlpool.hpp"
+#include "../mysql/db_cluster.hpp"
+#include "../log/async_log.hpp"
+#include "../log/request_log.hpp"
 
 // 服务器配置参数
 const int THREAD_NUM = 4;
@@ -11,24 +13,128 @@ const std::string WEB_ROOT = "../root";   // 根路径
 const std::string DB_USER = "root";      // 数据库账户名
 const std::string DB_PASS = "123456";    // 数据库密码
 const std::string DB_NAME = "test";  // 使用的数据库名
-const int MAX_DB_CONN = 10;             
+const int MIN_DB_CONN = 2;               // 常驻数据库连接数
+const int MAX_DB_CONN = 10;              // 数据库连接数上限（按负载伸缩）
+const int DB_ACQUIRE_TIMEOUT_MS = 3000;  // 获取数据库连接的等待上限
+const int DB_STARTUP_THREADS = 8;        // 并行建立启动连接的线程数
+const int DB_READY_CONN = 1;             // 建立多少个连接后开始监听（其余后台建立，/readyz 据此返回）
+// 只读从库（host, port），登录查询分给从库，为空时全部走主库
+const std::vector<std::pair<std::string, unsigned int>> DB_REPLICAS = {};
+const int DB_REPLICA_DOWN_MS = 5000;     // 从库失败后暂停分配读请求的时间
+const bool SHARDED = false;              // thread-per-core 分片模式（每核一个 io_context + SO_REUSEPORT）
+const int STATS_INTERVAL = 10;           // 分片统计输出间隔（秒）
+const bool USE_SENDFILE = true;          // 静态文件使用 sendfile 零拷贝发送（false 为 mmap）
+const size_t STATIC_CACHE_BYTES = 64 * 1024 * 1024;  // 静态文件缓存容量（0 为关闭）
+const size_t DB_QUEUE_CAPACITY = 1024;   // DB 执行器最大排队请求数（超出返回 503）
+const size_t REGISTER_BATCH_ROWS = 64;   // 注册组提交每批最多行数（1 为关闭）
+const int REGISTER_BATCH_WINDOW_US = 2000; // 注册组提交的等待窗口
+const size_t AUTH_CACHE_CAPACITY = 10000; // 登录认证缓存的用户数上限（0 为关闭）
+const int AUTH_CACHE_TTL_MS = 60000;      // 认证缓存有效期
+const size_t BLOOM_EXPECTED_USERS = 0;    // 用户名 Bloom 过滤器的预期用户数（0 为关闭）
+const int IDLE_TIMEOUT_MS = 60000;        // 连接空闲超时
+const int HEADER_TIMEOUT_MS = 10000;      // 收完请求头的期限（从第一个字节起）
+const int BODY_TIMEOUT_MS = 30000;        // 接收请求体时两次读取之间的最长间隔
+const bool ASYNC_LOG = true;              // 日志由后台线程输出（网络线程只写本线程的环形缓冲区）
+const size_t LOG_RING_SLOTS = 4096;       // 每个线程的日志缓冲条数
+const bool LOG_BLOCK_ON_FULL = false;     // 缓冲区满时等待（false 为丢弃并计数）
+const uint32_t REQUEST_LOG_SAMPLE_RATE = 100; // 每 N 个连接记录一个连接的请求日志（1 为全部，0 为关闭）
+const UserBackend USER_BACKEND = UserBackend::MYSQL; // 用户数据后端（MEMORY 为进程内存 + 本地快照，不连接数据库；
+                                                     // FAKE_DB 为模拟延迟的假数据库，用于压测连接池和执行器）
+const std::string MEMORY_USERS_PATH = "data/users";  // 内存后端的快照/日志路径前缀
+const DbLatency FAKE_DB_CONNECT = DbLatency::fixed(5000);          // 假数据库建立连接的耗时
+const DbLatency FAKE_DB_QUERY = DbLatency::lognormal(1000, 0.5);   // 假数据库每次查询的耗时
+const uint32_t TRACE_SAMPLE_RATE = 0;     // 每 N 个请求追踪一个请求的各阶段耗时（0 为关闭），导出路由 /debug/trace
+
+// 初始化主库和从库的连接池
+static bool init_database() {
+    PoolConfig db_config;
+    db_config.url = IP;
+    db_config.port = 3306;
+    db_config.user = DB_USER;
+    db_config.password = DB_PASS;
+    db_config.database = DB_NAME;
+    db_config.min_conn = MIN_DB_CONN;
+    db_config.max_conn = MAX_DB_CONN;
+    db_config.acquire_timeout_ms = DB_ACQUIRE_TIMEOUT_MS;
+    db_config.startup_threads = DB_STARTUP_THREADS;
+    db_config.ready_conn = DB_READY_CONN;
+
+    std::vector<PoolConfig> replica_configs;
+    if (USER_BACKEND == UserBackend::FAKE_DB) {
+        // 假连接不能 ping，关闭空闲校验（否则每次校验都按重连计时），也不使用从库
+        db_config.connector = FakeDbUserService::connector(FAKE_DB_CONNECT);
+        db_config.validation_interval_ms = 3600 * 1000;
+        db_config.keepalive_interval_ms = 3600 * 1000;
+    }
+    else {
+        for (const auto& replica : DB_REPLICAS) {
+            PoolConfig replica_config = db_config;
+            replica_config.url = replica.first;
+            replica_config.port = replica.second;
+            // 从库不可用时尽快回退主库，不长时间等待
+            replica_config.acquire_timeout_ms = 200;
+            replica_configs.push_back(replica_config);
+        }
+    }
+
+    if (!DbCluster::GetInstance()->init(db_config, replica_configs, DB_REPLICA_DOWN_MS)) {
+        spdlog::error("Database connection pool initialization failed");
+        return false;
+    }
+    connection_pool* db_pool = connection_pool::GetInstance();
+    spdlog::info("Database connection pool ready ({} of {}-{} connections, {} replica(s))",
+                 db_pool->GetEstablished(), MIN_DB_CONN, MAX_DB_CONN, replica_configs.size());
+    return true;
+}
 
 int main() {
+    std::shared_ptr<AsyncLogSink> async_log;
     try {
         spdlog::set_level(spdlog::level::info);
+        if (ASYNC_LOG) {
+            AsyncLogOptions log_options;
+            log_options.ring_slots = LOG_RING_SLOTS;
+            log_options.overflow = LOG_BLOCK_ON_FULL ? LogOverflow::BLOCK : LogOverflow::DROP;
+            async_log = AsyncLogSink::install(log_options);
+        }
+        request_log::set_sample_rate(REQUEST_LOG_SAMPLE_RATE);
         spdlog::info("正在启动服务器...");
 
-        connection_pool* db_pool = connection_pool::GetInstance();
-        db_pool->init(IP, DB_USER, DB_PASS, DB_NAME, 3306, MAX_DB_CONN, 0);
-        spdlog::info("Database connection pool initialized with {} connections", MAX_DB_CONN);
+        if (USER_BACKEND != UserBackend::MEMORY && !init_database()) {
+            return 1;
+        }
 
         asio::io_context io_context;
 
-        WebServer server(io_context, THREAD_NUM, WEB_ROOT);
+        ServerOptions options;
+        options.thread_num = THREAD_NUM;
+        options.root = WEB_ROOT;
+        options.sharded = SHARDED;
+        options.stats_report_interval = STATS_INTERVAL;
+        options.use_sendfile = USE_SENDFILE;
+        options.static_cache_bytes = STATIC_CACHE_BYTES;
+        options.db_threads = MAX_DB_CONN;
+        options.db_queue_capacity = DB_QUEUE_CAPACITY;
+        options.register_batch_max_rows = REGISTER_BATCH_ROWS;
+        options.register_batch_window_us = REGISTER_BATCH_WINDOW_US;
+        options.auth_cache_capacity = AUTH_CACHE_CAPACITY;
+        options.auth_cache_ttl_ms = AUTH_CACHE_TTL_MS;
+        options.bloom_expected_users = BLOOM_EXPECTED_USERS;
+        options.idle_timeout_ms = IDLE_TIMEOUT_MS;
+        options.header_timeout_ms = HEADER_TIMEOUT_MS;
+        options.body_timeout_ms = BODY_TIMEOUT_MS;
+        options.trace_sample_rate = TRACE_SAMPLE_RATE;
+        options.user_backend = USER_BACKEND;
+        options.memory_users_path = MEMORY_USERS_PATH;
+        options.fake_db_query = FAKE_DB_QUERY;
+
+        WebServer server(io_context, options);
         spdlog::info("Server started on port {}", PORT);
         spdlog::info("Web root: {}", WEB_ROOT);
 
-        server.listen(IP, PORT);
+        if (!server.listen(IP, PORT)) {
+            return 1;
+        }
 
         // 运行事件循环
         server.run();
@@ -38,5 +144,8 @@ int main() {
     }
 
     spdlog::info("关闭服务器");
+    if (async_log) {
+        async_log->stop();
+    }
     return 0;
 }
\ No newline at end of file
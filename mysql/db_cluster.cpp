@@ -0,0 +1,188 @@
+#include "db_cluster.hpp"
+#include <climits>
+#include <ctime>
+
+namespace {
+
+int64_t now_ms() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+	return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+// 各线程各自轮转在途请求数相同的从库，避免共享计数器
+thread_local unsigned int replica_cursor = 0;
+
+// 连不上或连接断开（2002/2003/2006/2013），只有这类错误说明从库不可用；
+// 语句本身的错误（锁等待超时、表不存在等）与从库是否可用无关
+bool is_down_error(unsigned int err) {
+	return err == 2002 || err == 2003 || err == 2006 || err == 2013;
+}
+
+}  // namespace
+
+DbCluster *DbCluster::GetInstance(){
+	static DbCluster cluster;
+	return &cluster;
+}
+
+DbCluster::~DbCluster(){
+	DestroyPool();
+}
+
+bool DbCluster::init(const PoolConfig& primary, const vector<PoolConfig>& replicas, int replica_down_ms){
+	m_down_ms = replica_down_ms;
+	if (!connection_pool::GetInstance()->init(primary)) {
+		return false;
+	}
+
+	m_replicas.clear();
+	for (const PoolConfig& config : replicas) {
+		auto replica = std::make_unique<Replica>();
+		replica->pool = std::make_unique<connection_pool>();
+		PoolConfig replica_config = config;
+		replica_config.ready_conn = 0;
+		replica->pool->init(replica_config);
+		spdlog::info("MySQL replica {}:{} added (min={} max={})",
+					 config.url, config.port, replica_config.min_conn, replica_config.max_conn);
+		m_replicas.push_back(std::move(replica));
+	}
+	return true;
+}
+
+connPtr DbCluster::GetPrimary(){
+	return connection_pool::GetInstance()->GetConnection();
+}
+
+connPtr DbCluster::GetReplica(){
+	const size_t count = m_replicas.size();
+	if (count == 0) {
+		return GetPrimary();
+	}
+
+	// 连接失败的从库标记为不可用后换下一个，最多尝试每个从库一次
+	for (size_t attempt = 0; attempt < count; ++attempt) {
+		const int64_t now = now_ms();
+		const unsigned int start = replica_cursor++;
+		Replica* best = nullptr;
+		int best_outstanding = INT_MAX;
+		for (size_t i = 0; i < count; ++i) {
+			Replica* replica = m_replicas[(start + i) % count].get();
+			if (replica->down_until_ms.load(std::memory_order_relaxed) > now) {
+				continue;
+			}
+			// 不可用窗口过后，等维护线程在后台重新建立连接再恢复分配，
+			// 读请求不在线程内等待连接超时（min_conn 为 0 时没有后台重连，由读请求试连）
+			if (replica->reconnecting.load(std::memory_order_relaxed)) {
+				if (replica->pool->GetEstablished() == 0 && replica->pool->GetConfig().min_conn > 0) {
+					continue;
+				}
+				replica->reconnecting.store(false, std::memory_order_relaxed);
+			}
+			const int outstanding = replica->pool->GetOutstanding();
+			if (outstanding < best_outstanding) {
+				best = replica;
+				best_outstanding = outstanding;
+			}
+		}
+		if (!best) {
+			break;
+		}
+
+		bool connect_failed = false;
+		connPtr conn = best->pool->GetConnection(
+			std::chrono::milliseconds(best->pool->GetConfig().acquire_timeout_ms), connect_failed);
+		if (conn) {
+			best->reads.fetch_add(1, std::memory_order_relaxed);
+			return conn;
+		}
+		if (!connect_failed) {
+			// 连接全部借出、等待超时：从库繁忙但可用，不标记不可用，直接改读主库
+			break;
+		}
+		mark_down(best);
+	}
+
+	m_fallbacks.fetch_add(1, std::memory_order_relaxed);
+	return GetPrimary();
+}
+
+MYSQL_STMT* DbCluster::ExecuteRead(connPtr& conn, const string& sql, MYSQL_BIND* params, bool read_primary){
+	conn = read_primary ? GetPrimary() : GetReplica();
+	if (!conn) {
+		return nullptr;
+	}
+	MYSQL_STMT* stmt = conn->execute(sql, params, PooledConnection::Retry::IDEMPOTENT);
+	if (stmt || IsPrimary(conn)) {
+		return stmt;
+	}
+
+	// 从库执行失败（execute 内部已重连重试过一次）：改读主库，连接错误时才标记从库不可用
+	const unsigned int err = conn->last_error();
+	spdlog::warn("Read on MySQL replica failed (errno {}), retrying on primary", err);
+	if (is_down_error(err)) {
+		MarkDown(conn);
+	} else if (Replica* replica = find_replica(conn)) {
+		replica->failures.fetch_add(1, std::memory_order_relaxed);
+	}
+	m_fallbacks.fetch_add(1, std::memory_order_relaxed);
+	conn = GetPrimary();
+	if (!conn) {
+		return nullptr;
+	}
+	return conn->execute(sql, params, PooledConnection::Retry::IDEMPOTENT);
+}
+
+bool DbCluster::IsPrimary(const connPtr& conn) const {
+	return conn.get_deleter().pool == connection_pool::GetInstance();
+}
+
+DbCluster::Replica* DbCluster::find_replica(const connPtr& conn) const {
+	for (const auto& replica : m_replicas) {
+		if (replica->pool.get() == conn.get_deleter().pool) {
+			return replica.get();
+		}
+	}
+	return nullptr;
+}
+
+void DbCluster::MarkDown(const connPtr& conn){
+	if (Replica* replica = find_replica(conn)) {
+		mark_down(replica);
+	}
+}
+
+void DbCluster::mark_down(Replica* replica){
+	replica->failures.fetch_add(1, std::memory_order_relaxed);
+	replica->reconnecting.store(true, std::memory_order_relaxed);
+	const int64_t now = now_ms();
+	int64_t until = replica->down_until_ms.load(std::memory_order_relaxed);
+	// 只有把从库从可用改为不可用的线程输出日志
+	if (until <= now && replica->down_until_ms.compare_exchange_strong(until, now + m_down_ms)) {
+		const PoolConfig& config = replica->pool->GetConfig();
+		spdlog::warn("MySQL replica {}:{} marked down for {} ms, reads fall back to primary",
+					 config.url, config.port, m_down_ms);
+	}
+}
+
+vector<ReplicaStats> DbCluster::GetReplicaStats() const {
+	vector<ReplicaStats> stats;
+	const int64_t now = now_ms();
+	for (const auto& replica : m_replicas) {
+		const PoolConfig& config = replica->pool->GetConfig();
+		stats.push_back(ReplicaStats{
+			config.url,
+			config.port,
+			replica->down_until_ms.load(std::memory_order_relaxed) > now,
+			replica->pool->GetOutstanding(),
+			replica->reads.load(std::memory_order_relaxed),
+			replica->failures.load(std::memory_order_relaxed)});
+	}
+	return stats;
+}
+
+void DbCluster::DestroyPool(){
+	for (const auto& replica : m_replicas) {
+		replica->pool->DestroyPool();
+	}
+}
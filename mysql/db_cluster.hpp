@@ -0,0 +1,77 @@
+#ifndef _DB_CLUSTER_
+#define _DB_CLUSTER_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "mysqlpool.hpp"
+
+using namespace std;
+
+// 单个从库的统计快照
+struct ReplicaStats {
+	string host;
+	unsigned int port;
+	bool down;				//处于不可用窗口内，暂不分配读请求
+	int outstanding;		//在途请求数
+	uint64_t reads;			//分配到该从库的读请求数
+	uint64_t failures;		//取不到连接或执行失败的次数
+};
+
+// 一主多从：写操作和要求读到最新数据的读走主库，其余只读语句分给从库
+//   - 在可用从库中选择在途请求（借出连接数）最少的一个，相同时各线程轮转起点；
+//   - 从库连不上或连接断开时，标记为不可用 replica_down_ms 毫秒并回退到主库，之后等连接池在后台
+//     重新建立连接才恢复分配；连接全部借出（等待超时）或语句出错只回退主库，不标记不可用；
+//   - 读己之写由调用方指定：刚写入过的客户端连接传 read_primary，直接读主库
+// 没有配置从库时所有读写都走主库，行为与单个连接池相同
+class DbCluster
+{
+public:
+	static DbCluster *GetInstance();
+
+	// 主库使用 connection_pool::GetInstance()，初始化失败返回 false；
+	// 从库连接在后台建立（不等待就绪），连不上的从库不影响启动，之后由连接池的维护线程重连
+	bool init(const PoolConfig& primary, const vector<PoolConfig>& replicas, int replica_down_ms = 5000);
+
+	connPtr GetPrimary();
+	// 选择一个从库连接；没有可用从库时返回主库连接，主库也取不到时返回空指针
+	connPtr GetReplica();
+
+	// 执行只读语句并返回语句句柄（结果集由调用方读取后释放），conn 返回持有结果集的连接；
+	// read_primary 为 false 时先在从库执行，从库失败则回退到主库重试一次。
+	// 取不到任何连接时 conn 为空
+	MYSQL_STMT* ExecuteRead(connPtr& conn, const string& sql, MYSQL_BIND* params, bool read_primary);
+
+	bool IsPrimary(const connPtr& conn) const;
+	// 标记连接所属的从库不可用（连接错误时调用）
+	void MarkDown(const connPtr& conn);
+
+	size_t GetReplicaCount() const { return m_replicas.size(); }
+	vector<ReplicaStats> GetReplicaStats() const;
+	// 因从库不可用而改读主库的次数
+	uint64_t GetFallbacks() const { return m_fallbacks.load(std::memory_order_relaxed); }
+
+	void DestroyPool();
+
+private:
+	DbCluster() = default;
+	~DbCluster();
+
+	struct Replica {
+		unique_ptr<connection_pool> pool;
+		std::atomic<int64_t> down_until_ms{0};
+		std::atomic<bool> reconnecting{false};	//标记不可用后尚未确认重新连上
+		std::atomic<uint64_t> reads{0};
+		std::atomic<uint64_t> failures{0};
+	};
+
+	Replica* find_replica(const connPtr& conn) const;
+	void mark_down(Replica* replica);
+
+	vector<unique_ptr<Replica>> m_replicas;
+	int m_down_ms = 5000;
+	std::atomic<uint64_t> m_fallbacks{0};
+};
+
+#endif
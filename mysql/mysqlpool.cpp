@@ -1,10 +1,180 @@
 #include "mysqlpool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <vector>
+#include "thread_role.hpp"
+#include "request_trace.hpp"
 
 using namespace std;
 
+// ======================== PooledConnection ========================
+
+PooledConnection::PooledConnection(MYSQL* conn, Connector connector)
+	: m_conn(conn), m_connector(std::move(connector)), m_thread_id(mysql_thread_id(conn)) {
+	last_used = Clock::now();
+	last_validated = last_used;
+}
+
+PooledConnection::~PooledConnection() {
+	clear_statements();
+	if (m_conn) {
+		mysql_close(m_conn);
+	}
+}
+
+void PooledConnection::clear_statements() {
+	for (auto& entry : m_stmts) {
+		mysql_stmt_close(entry.second);
+	}
+	m_stmts.clear();
+}
+
+bool PooledConnection::is_connection_error(unsigned int err) {
+	return err == 2006 || err == 2013;
+}
+
+bool PooledConnection::needs_reprepare(unsigned int err) {
+	return is_connection_error(err) || err == 1243;
+}
+
+bool PooledConnection::validate() {
+	if (mysql_ping(m_conn) == 0) {
+		last_validated = Clock::now();
+		return true;
+	}
+	spdlog::warn("MySQL connection failed validation: {}", mysql_error(m_conn));
+	return reconnect();
+}
+
+bool PooledConnection::reconnect() {
+	clear_statements();
+	MYSQL* fresh = m_connector ? m_connector() : nullptr;
+	if (!fresh) {
+		m_broken = true;
+		return false;
+	}
+	mysql_close(m_conn);
+	m_conn = fresh;
+	m_thread_id = mysql_thread_id(m_conn);
+	m_broken = false;
+	++reconnects;
+	last_validated = Clock::now();
+	return true;
+}
+
+MYSQL_STMT* PooledConnection::prepare(const string& sql) {
+	// 客户端自动重连后服务端连接 ID 改变，旧的语句句柄全部失效
+	const unsigned long thread_id = mysql_thread_id(m_conn);
+	if (thread_id != m_thread_id) {
+		clear_statements();
+		m_thread_id = thread_id;
+	}
+
+	auto it = m_stmts.find(sql);
+	if (it != m_stmts.end()) {
+		return it->second;
+	}
+
+	MYSQL_STMT* stmt = mysql_stmt_init(m_conn);
+	if (!stmt) {
+		m_last_error = mysql_errno(m_conn);
+		return nullptr;
+	}
+	if (mysql_stmt_prepare(stmt, sql.c_str(), sql.size()) != 0) {
+		m_last_error = mysql_stmt_errno(stmt);
+		spdlog::error("mysql_stmt_prepare failed: {}", mysql_stmt_error(stmt));
+		mysql_stmt_close(stmt);
+		return nullptr;
+	}
+	m_stmts.emplace(sql, stmt);
+	return stmt;
+}
+
+MYSQL_STMT* PooledConnection::execute(const string& sql, MYSQL_BIND* params, Retry retry) {
+	TraceSpan span("mysql_execute");
+	for (int attempt = 0; attempt < 2; ++attempt) {
+		bool sent = false;
+		MYSQL_STMT* stmt = prepare(sql);
+		if (stmt) {
+			if (params && mysql_stmt_bind_param(stmt, params) != 0) {
+				m_last_error = mysql_stmt_errno(stmt);
+				return nullptr;
+			}
+			if (mysql_stmt_execute(stmt) == 0) {
+				m_last_error = 0;
+				return stmt;
+			}
+			m_last_error = mysql_stmt_errno(stmt);
+			sent = true;
+		}
+
+		if (!needs_reprepare(m_last_error) || retry == Retry::NONE) {
+			return nullptr;
+		}
+		if (is_connection_error(m_last_error)) {
+			// 执行中连接断开：语句可能已在服务端生效，只有幂等语句可以重试
+			const bool retry_statement = attempt == 0 && (!sent || retry == Retry::IDEMPOTENT);
+			spdlog::warn("MySQL connection lost ({}), reconnecting{}", m_last_error,
+						 retry_statement ? "" : " without retrying the statement");
+			if (!reconnect() || !retry_statement) {
+				return nullptr;
+			}
+		} else {
+			// 1243：服务端不认识语句句柄，语句没有执行，重新预处理后重试
+			if (attempt > 0) {
+				return nullptr;
+			}
+			spdlog::warn("Prepared statement invalidated ({}), re-preparing", m_last_error);
+			clear_statements();
+		}
+	}
+	return nullptr;
+}
+
+// ======================== connection_pool ========================
+
+namespace {
+
+// 每个线程最近归还的槽位（按池区分），借出时优先尝试
+struct LocalSlots {
+	static constexpr int SIZE = 4;
+	const connection_pool* pool[SIZE] = {};
+	int slot[SIZE] = {};
+	int next = 0;
+};
+
+thread_local LocalSlots local_slots;
+
+// 借出/归还路径上的时间戳只用于空闲/校验间隔判断，毫秒级精度足够，
+// 用 CLOCK_MONOTONIC_COARSE 避免每次读高精度时钟（与 steady_clock 同一时间基准）
+PooledConnection::Clock::time_point coarse_now() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+	return PooledConnection::Clock::time_point(
+		std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec));
+}
+
+void remember_slot(const connection_pool* pool, int slot) {
+	for (int i = 0; i < LocalSlots::SIZE; ++i) {
+		if (local_slots.pool[i] == pool && local_slots.slot[i] == slot) {
+			return;
+		}
+	}
+	const int i = local_slots.next;
+	local_slots.pool[i] = pool;
+	local_slots.slot[i] = slot;
+	local_slots.next = (i + 1) % LocalSlots::SIZE;
+}
+
+}  // namespace
+
+void connReleaser::operator()(PooledConnection* conn) const {
+	pool->ReleaseConnection(conn);
+}
+
 connection_pool::connection_pool(){
-	m_CurConn = 0;
-	m_FreeConn = 0;
+	m_MaxConn = 0;
 }
 
 connection_pool *connection_pool::GetInstance(){
@@ -13,82 +183,473 @@ connection_pool *connection_pool::GetInstance(){
 }
 
 //构造初始化
-void connection_pool::init(string url, string User, string PassWord, string DBName, int Port, int MaxConn, int close_log){
-	m_url = url;
-	m_Port = Port;
-	m_User = User;
-	m_PassWord = PassWord;
-	m_DatabaseName = DBName;
+bool connection_pool::init(string url, string User, string PassWord, string DBName, int Port, int MaxConn, int close_log){
+	PoolConfig config;
+	config.url = url;
+	config.port = Port;
+	config.user = User;
+	config.password = PassWord;
+	config.database = DBName;
+	config.min_conn = MaxConn;
+	config.max_conn = MaxConn;
 	m_close_log = close_log;
+	return init(config);
+}
+
+bool connection_pool::init(const PoolConfig& config){
+	// 借出的连接、维护线程和启动线程都指向当前槽位，只有 DestroyPool 之后且连接全部归还时才能重建
+	if (m_slots && !m_closed.load()) {
+		spdlog::error("MySQL pool is already initialized, call DestroyPool first");
+		return false;
+	}
+	if (m_outstanding.load() > 0) {
+		spdlog::error("MySQL pool cannot be re-initialized while {} connection(s) are checked out",
+					  m_outstanding.load());
+		return false;
+	}
+
+	m_config = config;
+	m_config.max_conn = std::max(1, m_config.max_conn);
+	m_config.min_conn = std::min(std::max(0, m_config.min_conn), m_config.max_conn);
+
+	m_url = m_config.url;
+	m_Port = m_config.port;
+	m_User = m_config.user;
+	m_PassWord = m_config.password;
+	m_DatabaseName = m_config.database;
+	m_MaxConn = m_config.max_conn;
+	m_slots = std::make_unique<Slot[]>(static_cast<size_t>(m_MaxConn));
+	m_TotalConn = 0;
+	m_open = 0;
+	m_created = 0;
+	m_closed = false;
 
-	for (int i = 0; i < MaxConn; i++){
-		MYSQL *con = mysql_init(nullptr);
+	const int wait_target = m_config.ready_conn < 0 ? m_config.min_conn
+													: std::min(m_config.ready_conn, m_config.min_conn);
+	m_ready_threshold = std::min(std::max(1, wait_target), m_config.min_conn);
 
-		if (con == NULL) {
-			spdlog::error("mysql_init failed: {}", mysql_error(nullptr)); 
-			exit(1);
+	// 多线程建立连接前完成客户端库的全局初始化（mysql_init 隐式初始化不是线程安全的）
+	mysql_library_init(0, nullptr, nullptr);
+
+	// 启动时只建立常驻连接，其余按需建立；常驻连接由多个线程并行建立
+	const int threads = std::min(std::max(1, m_config.startup_threads), m_config.min_conn);
+	m_startup_remaining = m_config.min_conn;
+	{
+		std::lock_guard<std::mutex> lock(m_ready_mutex);
+		m_startup_done = 0;
+	}
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < threads; ++i) {
+		m_startup.emplace_back([this]() { startup_worker(); });
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(m_ready_mutex);
+		m_ready_cond.wait(lock, [this, wait_target, threads]() {
+			return m_open.load() >= wait_target || m_startup_done == threads;
+		});
+	}
+	if (m_open.load() < wait_target) {
+		spdlog::error("MySQL pool failed to open {} startup connection(s)", wait_target);
+		DestroyPool();
+		return false;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_maintenance_mutex);
+		m_stopping = false;
+	}
+	if (!m_maintenance.joinable()) {
+		m_maintenance = std::thread([this]() { maintenance_loop(); });
+	}
+	spdlog::info("MySQL pool ready after {} ms: {} of min={} connections open (max={}), rest filling in background",
+				 std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count(),
+				 m_open.load(), m_config.min_conn, m_config.max_conn);
+	return true;
+}
+
+void connection_pool::startup_worker(){
+	bool connect_failed = false;
+	while (m_startup_remaining.fetch_sub(1) > 0) {
+		PooledConnection* conn = create(connect_failed);
+		if (!conn) {
+			// 连接失败时不再重试，剩余的常驻连接由维护线程补足（维护线程在 m_startup_remaining 归零后才补）
+			m_startup_remaining.store(0);
+			break;
 		}
+		m_slots[conn->slot].state.store(Slot::NOT_IN_USE);
+		notify_waiter();
+		{
+			std::lock_guard<std::mutex> lock(m_ready_mutex);
+		}
+		m_ready_cond.notify_all();
+	}
 
-		MYSQL *conn_result = mysql_real_connect(con, url.c_str(), User.c_str(), PassWord.c_str(), DBName.c_str(), Port, NULL, 0);
-		if (conn_result == NULL) {
-			spdlog::error("mysql_real_connect failed: {}", mysql_error(con));
-			exit(1);
+	{
+		std::lock_guard<std::mutex> lock(m_ready_mutex);
+		++m_startup_done;
+	}
+	m_ready_cond.notify_all();
+	mysql_thread_end();
+}
+
+bool connection_pool::IsReady() const {
+	return m_slots && !m_closed.load() && m_open.load() >= m_ready_threshold;
+}
+
+MYSQL* connection_pool::connect(){
+	if (m_config.connector) {
+		return m_config.connector();
+	}
+
+	MYSQL *con = mysql_init(nullptr);
+	if (con == NULL) {
+		spdlog::error("mysql_init failed: {}", mysql_error(nullptr)); 
+		return nullptr;
+	}
+
+	const unsigned int timeout = static_cast<unsigned int>(m_config.connect_timeout_s);
+	mysql_options(con, MYSQL_OPT_CONNECT_TIMEOUT, &timeout);
+	if (m_config.io_timeout_s > 0) {
+		// 数据库挂起时读写不会无限阻塞 DB 线程，超时按连接断开（2013）处理
+		const unsigned int io_timeout = static_cast<unsigned int>(m_config.io_timeout_s);
+		mysql_options(con, MYSQL_OPT_READ_TIMEOUT, &io_timeout);
+		mysql_options(con, MYSQL_OPT_WRITE_TIMEOUT, &io_timeout);
+	}
+
+	MYSQL *conn_result = mysql_real_connect(con, m_config.url.c_str(), m_config.user.c_str(), m_config.password.c_str(),
+											m_config.database.c_str(), m_config.port, NULL, 0);
+	if (conn_result == NULL) {
+		spdlog::error("mysql_real_connect failed: {}", mysql_error(con));
+		mysql_close(con);
+		return nullptr;
+	}
+	return con;
+}
+
+void connection_pool::record_wait(std::chrono::steady_clock::time_point start){
+	// 网络线程上出现等待说明有阻塞调用绕过了 DB 执行器
+	const auto now = std::chrono::steady_clock::now();
+	const uint64_t waited_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+		now - start).count());
+	(is_network_thread() ? m_network_wait_us : m_worker_wait_us).record(waited_us);
+	RequestTracer::GetInstance()->record("pool_wait", current_trace_id(), RequestTracer::to_ns(start),
+		RequestTracer::to_ns(now));
+}
+
+PooledConnection* connection_pool::borrow(int index){
+	Slot& slot = m_slots[index];
+	int expected = Slot::NOT_IN_USE;
+	if (slot.state.load(std::memory_order_relaxed) != expected
+		|| !slot.state.compare_exchange_strong(expected, Slot::IN_USE)) {
+		return nullptr;
+	}
+	return slot.conn.get();
+}
+
+PooledConnection* connection_pool::borrow_any(){
+	for (int i = 0; i < m_MaxConn; ++i) {
+		if (PooledConnection* conn = borrow(i)) {
+			return conn;
 		}
-		connList.emplace_back(std::move(con), mysql_deleter);
-		++m_FreeConn;
 	}
+	return nullptr;
+}
 
-	m_MaxConn = m_FreeConn;
+PooledConnection* connection_pool::create(bool& connect_failed){
+	if (connect_failed || m_closed.load()) {
+		return nullptr;
+	}
+	for (int i = 0; i < m_MaxConn; ++i) {
+		Slot& slot = m_slots[i];
+		int expected = Slot::EMPTY;
+		if (!slot.state.compare_exchange_strong(expected, Slot::RESERVED)) {
+			continue;
+		}
+
+		// 占住空槽位后再建立连接（建立过程不持有任何锁）
+		++m_TotalConn;
+		MYSQL* con = connect();
+		if (!con) {
+			--m_TotalConn;
+			slot.state.store(Slot::EMPTY);
+			connect_failed = true;
+			notify_waiter();
+			return nullptr;
+		}
+		slot.conn = std::make_unique<PooledConnection>(con, [this]() { return connect(); });
+		slot.conn->slot = i;
+		++m_created;
+		++m_open;
+		slot.state.store(Slot::IN_USE);
+		return slot.conn.get();
+	}
+	return nullptr;
 }
 
+bool connection_pool::checkout(PooledConnection* conn){
+	const auto validation_interval = std::chrono::milliseconds(m_config.validation_interval_ms);
+	if (coarse_now() - conn->last_validated <= validation_interval) {
+		return true;
+	}
+
+	// 空闲较久的连接借出前先校验，失效时重连；重连失败则移除
+	const uint64_t reconnects = conn->reconnects;
+	const bool ok = conn->validate();
+	if (!ok || conn->reconnects != reconnects) {
+		++m_replaced;
+	}
+	if (!ok) {
+		remove(m_slots[conn->slot]);
+	}
+	return ok;
+}
+
+void connection_pool::remove(Slot& slot){
+	slot.conn.reset();
+	--m_open;
+	--m_TotalConn;
+	slot.state.store(Slot::EMPTY);
+	// 空出的槽位允许等待者新建连接
+	notify_waiter();
+}
+
+void connection_pool::notify_waiter(){
+	if (m_Waiters.load() > 0) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_cond.notify_one();
+	}
+}
+
+connPtr connection_pool::lend(PooledConnection* conn){
+	m_outstanding.fetch_add(1, std::memory_order_relaxed);
+	return connPtr(conn, connReleaser{this});
+}
 
-// 当有请求时，从数据库连接池中返回一个可用连接，更新使用和空闲连接数
 connPtr connection_pool::GetConnection(){
-    std::unique_lock<std::mutex> lock(m_mutex);  // 自动加锁，支持条件变量wait
+	return GetConnection(std::chrono::milliseconds(m_config.acquire_timeout_ms));
+}
 
-	m_cond.wait(lock, [this](){
-		return m_FreeConn > 0;
-	} );
+connPtr connection_pool::GetConnection(std::chrono::milliseconds timeout){
+	bool connect_failed = false;
+	return GetConnection(timeout, connect_failed);
+}
 
-	connPtr conn = std::move(connList.front());
-	connList.pop_front();
-	MYSQL* raw_conn = conn.release();
-	--m_FreeConn;
-	++m_CurConn;
+// 当有请求时，从数据库连接池中返回一个可用连接
+// 依次尝试：本线程最近归还的连接 -> 任意空闲连接 -> 在上限内新建 -> 等待归还，超时返回空指针
+connPtr connection_pool::GetConnection(std::chrono::milliseconds timeout, bool& connect_failed){
+	connect_failed = false;
+	// 快速路径：本线程最近归还的槽位，不加锁、不计时
+	for (int i = 0; i < LocalSlots::SIZE; ++i) {
+		// 同一地址上可能是重新初始化（或销毁后重新构造）的池，槽位数可能变少
+		if (local_slots.pool[i] != this || local_slots.slot[i] >= m_MaxConn) continue;
+		PooledConnection* conn = borrow(local_slots.slot[i]);
+		if (!conn) continue;
+		if (checkout(conn)) {
+			return lend(conn);
+		}
+		connect_failed = true;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	const auto deadline = start + timeout;
 
-	 return connPtr(raw_conn, [this](MYSQL* conn) {
-        this->ReleaseConnection(conn);
-    });
+	while (true) {
+		PooledConnection* conn = borrow_any();
+		if (!conn) {
+			conn = create(connect_failed);
+		}
+		if (conn) {
+			if (!checkout(conn)) {
+				// 校验失败且重连不上，与新建连接失败同样处理
+				connect_failed = true;
+				continue;
+			}
+			record_wait(start);
+			return lend(conn);
+		}
+
+		// 没有空闲连接且不能新建：加锁后先登记等待者再重新扫描，
+		// 保证与归还线程之间不会丢失唤醒
+		std::unique_lock<std::mutex> lock(m_mutex);
+		++m_Waiters;
+		bool ready = true;
+		while (!(conn = borrow_any())) {
+			if (!connect_failed && m_TotalConn.load() < m_MaxConn) {
+				break;
+			}
+			if (m_cond.wait_until(lock, deadline) == std::cv_status::timeout) {
+				conn = borrow_any();
+				ready = conn != nullptr;
+				break;
+			}
+		}
+		--m_Waiters;
+		lock.unlock();
+
+		if (!ready) {
+			++m_timeouts;
+			record_wait(start);
+			spdlog::warn("GetConnection timed out after {} ms", timeout.count());
+			return connPtr(nullptr, connReleaser{this});
+		}
+		if (conn) {
+			if (!checkout(conn)) {
+				connect_failed = true;
+				continue;
+			}
+			record_wait(start);
+			return lend(conn);
+		}
+		// 有空槽位：回到循环开头新建连接
+	}
 }
  
 // 释放当前使用的连接
-bool connection_pool::ReleaseConnection(MYSQL* conn) {
+bool connection_pool::ReleaseConnection(PooledConnection* conn) {
     if (!conn) return false;
+    m_outstanding.fetch_sub(1, std::memory_order_relaxed);
 
-    std::lock_guard<std::mutex> lock(m_mutex); 
+    Slot& slot = m_slots[conn->slot];
+    if (conn->broken() || m_closed.load()) {
+        // 重连失败的连接直接销毁，空出的槽位由后续请求或维护线程补上
+        if (conn->broken()) {
+            ++m_replaced;
+        }
+        remove(slot);
+        return true;
+    }
 
-    connList.emplace_back(conn, mysql_deleter);
-    ++m_FreeConn;
-    --m_CurConn;
+    conn->last_used = coarse_now();
+    slot.state.store(Slot::NOT_IN_USE);
+    remember_slot(this, conn->slot);
 
-    // 通知一个等待的线程（有新连接可用）
-    m_cond.notify_one();
+    // 只有存在等待者时才加锁唤醒
+    notify_waiter();
     return true;
 }
 
+void connection_pool::maintenance_loop() {
+	std::unique_lock<std::mutex> lock(m_maintenance_mutex);
+	while (!m_stopping) {
+		m_maintenance_cond.wait_for(lock, std::chrono::milliseconds(m_config.maintenance_interval_ms),
+									[this]() { return m_stopping; });
+		if (m_stopping) {
+			break;
+		}
+		lock.unlock();
+		maintain();
+		lock.lock();
+	}
+}
+
+void connection_pool::maintain() {
+	const auto now = std::chrono::steady_clock::now();
+	const auto idle_timeout = std::chrono::milliseconds(m_config.idle_timeout_ms);
+	const auto keepalive_interval = std::chrono::milliseconds(m_config.keepalive_interval_ms);
+	int shrunk = 0;
+
+	for (int i = 0; i < m_MaxConn; ++i) {
+		Slot& slot = m_slots[i];
+		// 占住空闲槽位，期间其他线程不会借出
+		int expected = Slot::NOT_IN_USE;
+		if (!slot.state.compare_exchange_strong(expected, Slot::RESERVED)) {
+			continue;
+		}
+		PooledConnection* conn = slot.conn.get();
+
+		// 收缩：超过 min_conn 的部分空闲超时后关闭
+		if (m_TotalConn.load() > m_config.min_conn && now - conn->last_used > idle_timeout) {
+			remove(slot);
+			++m_shrunk;
+			++shrunk;
+			continue;
+		}
+
+		// 保活：长时间未校验的空闲连接 ping 一次
+		if (now - conn->last_validated > keepalive_interval) {
+			const uint64_t reconnects = conn->reconnects;
+			const bool ok = conn->validate();
+			if (!ok || conn->reconnects != reconnects) {
+				++m_replaced;
+			}
+			if (!ok) {
+				remove(slot);
+				continue;
+			}
+		}
+		slot.state.store(Slot::NOT_IN_USE);
+		notify_waiter();
+	}
+	if (shrunk > 0) {
+		spdlog::info("MySQL pool closed {} idle connection(s)", shrunk);
+	}
+
+	// 补足常驻连接（启动线程仍在建立时跳过）
+	bool connect_failed = false;
+	while (m_startup_remaining.load() <= 0 && m_TotalConn.load() < m_config.min_conn) {
+		PooledConnection* conn = create(connect_failed);
+		if (!conn) {
+			break;
+		}
+		m_slots[conn->slot].state.store(Slot::NOT_IN_USE);
+		notify_waiter();
+	}
+}
+
+PoolStats connection_pool::GetStats() {
+	PoolStats stats{};
+	for (int i = 0; i < m_MaxConn; ++i) {
+		const int state = m_slots[i].state.load(std::memory_order_relaxed);
+		if (state == Slot::IN_USE) ++stats.in_use;
+		if (state == Slot::NOT_IN_USE) ++stats.idle;
+	}
+	stats.total = m_TotalConn.load();
+	stats.waiters = m_Waiters.load();
+	stats.created = m_created.load();
+	stats.shrunk = m_shrunk.load();
+	stats.replaced = m_replaced.load();
+	stats.timeouts = m_timeouts.load();
+	return stats;
+}
+
 void connection_pool::DestroyPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_maintenance_mutex);
+        m_stopping = true;
+    }
+    m_maintenance_cond.notify_all();
+    if (m_maintenance.joinable()) {
+        m_maintenance.join();
+    }
+
+    // 关闭空闲连接，借出中的连接在归还时关闭；启动线程不再建立新连接
+    m_closed = true;
+    for (std::thread& t : m_startup) {
+        t.join();
+    }
+    m_startup.clear();
+    for (int i = 0; i < m_MaxConn; ++i) {
+        Slot& slot = m_slots[i];
+        int expected = Slot::NOT_IN_USE;
+        if (slot.state.compare_exchange_strong(expected, Slot::RESERVED)) {
+            remove(slot);
+        }
+    }
+
     std::lock_guard<std::mutex> lock(m_mutex);
-    // 清空列表时，智能指针会自动调用mysql_deleter关闭连接
-    connList.clear();
-    m_CurConn = 0;
-    m_FreeConn = 0;
+    m_cond.notify_all();
 }
 
 // 获取当前空闲连接数
 int connection_pool::GetFreeConn() {
-    return m_FreeConn;
+    int idle = 0;
+    for (int i = 0; i < m_MaxConn; ++i) {
+        if (m_slots[i].state.load(std::memory_order_relaxed) == Slot::NOT_IN_USE) ++idle;
+    }
+    return idle;
 }
 
 connection_pool::~connection_pool() {
     DestroyPool();
-}
\ No newline at end of file
+}
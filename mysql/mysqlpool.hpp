@@ -1,48 +1,253 @@
 #ifndef _CONNECTION_POOL_
 #define _CONNECTION_POOL_
 
-#include <list>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
 #include <mysql/mysql.h>
 #include <string>
 #include <mutex>
 #include <condition_variable>
 #include <functional>
+#include <memory>
+#include <unordered_map>
 #include "spdlog/spdlog.h"
+#include "histogram.hpp"
 
 using namespace std;
 
-using connDeleter = std::function<void(MYSQL*)>;
-using connPtr = std::unique_ptr<MYSQL, connDeleter>;
+// 连接参数与池大小
+struct PoolConfig {
+	string url;			 //主机地址
+	unsigned int port = 3306;
+	string user;
+	string password;
+	string database;
 
+	int min_conn = 2;	 //常驻连接数，启动时建立，维护线程保持不低于该值
+	int max_conn = 10;	 //连接数上限，负载升高时按需建立
+	int acquire_timeout_ms = 3000;		//GetConnection 默认等待上限
+	int idle_timeout_ms = 60000;		//超出 min_conn 的连接空闲多久后关闭
+	int validation_interval_ms = 5000;	//空闲超过该时间的连接借出前先 ping
+	int keepalive_interval_ms = 30000;	//空闲连接定期 ping，避免被服务端 wait_timeout 断开
+	int maintenance_interval_ms = 1000;	//后台维护周期
+	int connect_timeout_s = 3;			//建立连接的超时
+	int io_timeout_s = 0;				//单次读/写网络的超时，0 为不限；须大于最长语句的耗时（含行锁等待）
+
+	// 启动：min_conn 个常驻连接由 startup_threads 个线程并行建立，
+	// 建立 ready_conn 个后 init 即返回，其余在后台继续；
+	// ready_conn 为 -1 时等待全部常驻连接，为 0 时 init 不等待（连接全部在后台建立）
+	int startup_threads = 8;
+	int ready_conn = -1;
+
+	// 建立连接的函数，为空时使用 mysql_real_connect 连接上面的地址（测试和基准可替换）
+	std::function<MYSQL*()> connector;
+};
+
+// 池中的数据库连接：MYSQL 句柄 + 按 SQL 文本缓存的预处理语句
+// 语句在连接第一次执行某条 SQL 时预处理，之后每次只需一次 execute 往返
+class PooledConnection {
+public:
+	using Connector = std::function<MYSQL*()>;
+	using Clock = std::chrono::steady_clock;
+
+	PooledConnection(MYSQL* conn, Connector connector);
+	~PooledConnection();
+
+	PooledConnection(const PooledConnection&) = delete;
+	PooledConnection& operator=(const PooledConnection&) = delete;
+
+	MYSQL* get() const { return m_conn; }
+
+	// 返回已预处理的语句，首次使用时预处理并缓存；失败返回 nullptr
+	MYSQL_STMT* prepare(const string& sql);
+
+	// 语句失败后是否重试
+	enum class Retry {
+		UNSENT,		 //只在语句确定没有执行时重试：预处理阶段连接断开、语句句柄失效（1243）
+		IDEMPOTENT,	 //幂等语句（只读查询）：执行中连接断开也重连重试
+		NONE		 //不重连也不重试（事务内：新连接已不在原事务中）
+	};
+
+	// 绑定参数（可为 nullptr）并执行缓存的语句，成功返回语句句柄，结果集由调用方读取后
+	// mysql_stmt_free_result 释放；失败时按 retry 重连/重新预处理后重试一次。
+	// 写语句在执行中连接断开（2006/2013）时服务端可能已经执行，默认不重试，只重连以便连接归还后可用
+	MYSQL_STMT* execute(const string& sql, MYSQL_BIND* params, Retry retry = Retry::UNSENT);
+
+	// 最近一次失败的错误码（MySQL errno）
+	unsigned int last_error() const { return m_last_error; }
+
+	size_t cached_statements() const { return m_stmts.size(); }
+
+	// 关闭全部缓存的语句（重连后服务端的语句已失效）
+	void clear_statements();
+
+	// ping 检查连接，失败时重连；返回连接是否可用
+	bool validate();
+
+	// 关闭旧连接并重新建立，缓存的语句随之失效
+	bool reconnect();
+
+	// 连接已断开且重连失败，归还时由池销毁
+	bool broken() const { return m_broken; }
+
+	Clock::time_point last_used;		//最近一次归还的时间
+	Clock::time_point last_validated;	//最近一次确认可用的时间
+	uint64_t reconnects = 0;			//重连次数
+	int slot = -1;						//在连接池中的槽位
+
+	// 连接断开（2006/2013）
+	static bool is_connection_error(unsigned int err);
+
+private:
+	// 需要重新预处理：连接断开或服务端不认识语句句柄（1243）
+	static bool needs_reprepare(unsigned int err);
+
+	MYSQL* m_conn;
+	Connector m_connector;		 //建立新连接（重连时使用）
+	unsigned long m_thread_id;	 //预处理语句所属的服务端连接 ID，自动重连后会变化
+	unsigned int m_last_error = 0;
+	bool m_broken = false;
+	unordered_map<string, MYSQL_STMT*> m_stmts;
+};
+
+class connection_pool;
+
+// 归还连接的删除器：只保存池指针，不做堆分配；连接对象由池的槽位持有，不会被释放
+struct connReleaser {
+	connection_pool* pool = nullptr;
+	void operator()(PooledConnection* conn) const;
+};
+using connPtr = std::unique_ptr<PooledConnection, connReleaser>;
+
+// 连接池统计快照
+struct PoolStats {
+	int total;				//已建立的连接数（含正在建立的）
+	int in_use;				//已借出
+	int idle;				//空闲
+	int waiters;			//正在等待连接的线程数
+	uint64_t created;		//累计建立
+	uint64_t shrunk;		//因空闲超时关闭
+	uint64_t replaced;		//因连接失效而重连或替换
+	uint64_t timeouts;		//获取连接超时次数
+};
+
+// 弹性连接池：连接数在 [min_conn, max_conn] 之间随负载伸缩，
+// 借出前校验长时间空闲的连接，失效连接自动重连或替换，获取连接有超时
+//
+// 连接保存在固定数量的槽位中，槽位状态用原子变量表示，借出/归还只做一次 CAS/store：
+//   - 每个线程记住最近归还的槽位，优先重新借出（通常仍然空闲，不和其他线程竞争）；
+//   - 未命中时扫描全部槽位，空闲连接对所有线程可见；
+//   - 只有没有空闲连接、需要等待时才加锁，归还时仅在有等待者时加锁唤醒
 class connection_pool
 {
 public:
-	connPtr GetConnection();		     //获取数据库连接
-	bool ReleaseConnection(MYSQL *conn); //释放连接
+	// 主库连接池通过 GetInstance 获取；从库等其他地址各自构造一个实例
+	connection_pool();
+	~connection_pool();
+
+	connection_pool(const connection_pool&) = delete;
+	connection_pool& operator=(const connection_pool&) = delete;
+
+	connPtr GetConnection();		     //获取数据库连接（默认超时），超时返回空指针
+	connPtr GetConnection(std::chrono::milliseconds timeout);
+	// 同上，返回空指针时 connect_failed 表示是否有连接建立（或校验重连）失败，
+	// 用于区分数据库连不上和连接全部借出时的等待超时
+	connPtr GetConnection(std::chrono::milliseconds timeout, bool& connect_failed);
+	bool ReleaseConnection(PooledConnection *conn); //释放连接
 	int GetFreeConn();					 //获取连接
+	//获取连接的等待耗时（微秒），按调用线程是否为网络线程分别统计；
+	//命中线程本地缓存的获取不等待，不计入
+	const LatencyHistogram& GetWaitHistogram(bool network_thread) const {
+		return network_thread ? m_network_wait_us : m_worker_wait_us;
+	}
+	PoolStats GetStats();
+	// 当前借出的连接数（即在途请求数），用于多个池之间的负载均衡
+	int GetOutstanding() const { return m_outstanding.load(std::memory_order_relaxed); }
 	void DestroyPool();					 //销毁所有连接
 
+	// 就绪：当前打开的连接数达到 ready_conn（未指定时为 min_conn），可以接收流量；
+	// 连接全部断开或被关闭后不再就绪
+	bool IsReady() const;
+	// 当前打开的连接数（不含正在建立的）
+	int GetEstablished() const { return m_open.load(std::memory_order_relaxed); }
+	int GetReadyThreshold() const { return m_ready_threshold; }
+
 	//单例模式
 	static connection_pool *GetInstance();
 
-	void init(string url, string User, string PassWord, string DataBaseName, int Port, int MaxConn, int close_log); 
+	// 并行建立 min_conn 个连接并启动维护线程，就绪（ready_conn 个连接建立）后返回；
+	// 全部启动连接都失败、无法就绪时返回 false；
+	// 已初始化（需先 DestroyPool）或仍有借出的连接时不重建槽位，返回 false
+	bool init(const PoolConfig& config);
+	bool init(string url, string User, string PassWord, string DataBaseName, int Port, int MaxConn, int close_log); 
+
+	const PoolConfig& GetConfig() const { return m_config; }
 
 private:
-	connection_pool();
-	~connection_pool();
+	// 连接槽：只有把 state 从 NOT_IN_USE/EMPTY 改为 IN_USE/RESERVED 的线程可以访问 conn
+	struct alignas(64) Slot {
+		enum : int { EMPTY, NOT_IN_USE, IN_USE, RESERVED };
+		std::atomic<int> state{EMPTY};
+		std::unique_ptr<PooledConnection> conn;
+	};
+
+	// 建立一个新的 MYSQL 连接（不持有锁），失败返回 nullptr
+	MYSQL* connect();
 
-	int m_MaxConn;  //最大连接数
-	int m_CurConn;  //当前已使用的连接数
-	int m_FreeConn; //当前空闲的连接数
-	std::mutex m_mutex;
-	list<connPtr> connList; //连接池
+	// 借出指定槽位的空闲连接，失败返回 nullptr
+	PooledConnection* borrow(int index);
+	// 扫描全部槽位借出空闲连接
+	PooledConnection* borrow_any();
+	// 在空槽位上新建连接，成功时返回已借出的连接；没有空槽位或连接失败返回 nullptr
+	PooledConnection* create(bool& connect_failed);
+	// 借出后的校验：空闲较久的连接先 ping，失效且重连失败时移除并返回 false
+	bool checkout(PooledConnection* conn);
+	// 关闭槽位上的连接并置空（调用方已占有该槽位）
+	void remove(Slot& slot);
+	// 有线程在等待时唤醒一个
+	void notify_waiter();
+	// 借出连接：计入在途请求数并包装为 connPtr
+	connPtr lend(PooledConnection* conn);
+
+	// 启动线程：并行建立常驻连接，每建立一个通知 init 检查是否就绪
+	void startup_worker();
+
+	// 维护线程：关闭空闲超时的连接、ping 空闲连接、补足 min_conn
+	void maintenance_loop();
+	void maintain();
+
+	void record_wait(std::chrono::steady_clock::time_point start);
+
+	PoolConfig m_config;
+	int m_MaxConn;  //最大连接数（槽位数）
+	std::unique_ptr<Slot[]> m_slots;
+	std::atomic<int> m_TotalConn{0};  //已建立和正在建立的连接数
+	std::atomic<int> m_open{0};       //已建立的连接数
+	std::atomic<int> m_Waiters{0};    //等待连接的线程数
+	std::atomic<int> m_outstanding{0}; //已借出的连接数
+	std::atomic<bool> m_closed{false};
+	std::atomic<uint64_t> m_created{0};
+	std::atomic<uint64_t> m_shrunk{0};
+	std::atomic<uint64_t> m_replaced{0};
+	std::atomic<uint64_t> m_timeouts{0};
+	std::mutex m_mutex;				  //只用于等待/唤醒
 	std::condition_variable m_cond;
+	LatencyHistogram m_network_wait_us; //网络线程等待连接的耗时
+	LatencyHistogram m_worker_wait_us;  //其他线程等待连接的耗时
+
+	int m_ready_threshold = 0;
+	std::vector<std::thread> m_startup;		//并行建立启动连接的线程
+	std::atomic<int> m_startup_remaining{0};	//尚未开始建立的启动连接数
+	int m_startup_done = 0;						//已结束的启动线程数
+	std::mutex m_ready_mutex;
+	std::condition_variable m_ready_cond;
 
-	static void mysql_deleter(MYSQL* conn) {
-        if (conn) {
-            mysql_close(conn);
-        }
-    }
+	std::thread m_maintenance;
+	std::mutex m_maintenance_mutex;
+	std::condition_variable m_maintenance_cond;
+	bool m_stopping = false;
 
 public:
 	string m_url;			 //主机地址
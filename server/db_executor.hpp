@@ -0,0 +1,74 @@
+#ifndef DB_EXECUTOR_H
+#define DB_EXECUTOR_H
+
+#include "asio.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <utility>
+#include "histogram.hpp"
+#include "thread_role.hpp"
+
+// 阻塞任务（数据库访问）专用的有界执行器
+// 网络线程只投递任务，不等待；排队 + 执行中的任务数达到上限时拒绝投递，由调用方返回 503
+class DbExecutor {
+public:
+    DbExecutor(size_t threads, size_t queue_capacity)
+        : pool_(threads), capacity_(threads + queue_capacity) {}
+
+    ~DbExecutor() {
+        pool_.join();
+    }
+
+    DbExecutor(const DbExecutor&) = delete;
+    DbExecutor& operator=(const DbExecutor&) = delete;
+
+    // 投递任务，执行器已满时返回 false（任务不会执行）
+    template <typename Task>
+    bool try_post(Task&& task) {
+        if (inflight_.fetch_add(1, std::memory_order_relaxed) >= capacity_) {
+            inflight_.fetch_sub(1, std::memory_order_relaxed);
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        const auto enqueued = std::chrono::steady_clock::now();
+        asio::post(pool_, [this, enqueued, task = std::forward<Task>(task)]() mutable {
+            set_thread_role(ThreadRole::DB);
+            const auto start = std::chrono::steady_clock::now();
+            queue_wait_us_.record(elapsed_us(enqueued, start));
+
+            task();
+
+            exec_us_.record(elapsed_us(start, std::chrono::steady_clock::now()));
+            inflight_.fetch_sub(1, std::memory_order_relaxed);
+        });
+        return true;
+    }
+
+    // 停止执行器，尚未开始的任务被丢弃
+    void stop() { pool_.stop(); }
+
+    size_t inflight() const { return inflight_.load(std::memory_order_relaxed); }
+    size_t capacity() const { return capacity_; }
+    uint64_t rejected() const { return rejected_.load(std::memory_order_relaxed); }
+    const LatencyHistogram& queue_wait_us() const { return queue_wait_us_; }  // 排队时间（微秒）
+    const LatencyHistogram& exec_us() const { return exec_us_; }              // 执行时间（微秒）
+
+private:
+    static uint64_t elapsed_us(std::chrono::steady_clock::time_point from,
+                               std::chrono::steady_clock::time_point to) {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(to - from).count());
+    }
+
+private:
+    asio::thread_pool pool_;
+    const size_t capacity_;
+    std::atomic<size_t> inflight_{0};
+    std::atomic<uint64_t> rejected_{0};
+    LatencyHistogram queue_wait_us_;
+    LatencyHistogram exec_us_;
+};
+
+#endif
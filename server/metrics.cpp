@@ -0,0 +1,162 @@
+#include "metrics.hpp"
+#include <iterator>
+#include "spdlog/spdlog.h"
+
+const std::vector<uint64_t> LATENCY_BOUNDS_US = {100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000,
+                                                 100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000};
+
+namespace {
+
+const std::vector<uint64_t> PARSE_BOUNDS_NS = {100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000};
+const std::vector<uint64_t> WRITE_BOUNDS_US = {10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 100000, 1000000};
+
+}  // namespace
+
+void HistogramSnapshot::add(const LocalHistogram& hist) {
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        buckets[i] += hist.bucket(i);
+    }
+    count += hist.count();
+    sum += hist.sum();
+}
+
+void HistogramSnapshot::add(const LatencyHistogram& hist) {
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        buckets[i] += hist.bucket(i);
+    }
+    count += hist.count();
+    sum += hist.sum();
+}
+
+size_t ThreadMetrics::status_slot(int status) {
+    for (size_t i = 0; i < STATUS_CODES.size(); ++i) {
+        if (STATUS_CODES[i] == status) return i;
+    }
+    return STATUS_CODES.size();
+}
+
+MetricsRegistry* MetricsRegistry::GetInstance() {
+    static MetricsRegistry registry;
+    return &registry;
+}
+
+ThreadMetrics* MetricsRegistry::register_thread() {
+    auto metrics = std::make_unique<ThreadMetrics>();
+    ThreadMetrics* ptr = metrics.get();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_threads.push_back(std::move(metrics));
+    return ptr;
+}
+
+void MetricsRegistry::render(std::string& out, const std::vector<std::string>& route_names) {
+    std::vector<ThreadMetrics*> threads;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& metrics : m_threads) {
+            threads.push_back(metrics.get());
+        }
+    }
+
+    std::array<std::array<uint64_t, ThreadMetrics::STATUS_SLOTS>, ThreadMetrics::MAX_ROUTES> requests{};
+    std::vector<HistogramSnapshot> request_us(ThreadMetrics::MAX_ROUTES);
+    HistogramSnapshot parse_ns;
+    HistogramSnapshot write_us;
+    for (const ThreadMetrics* metrics : threads) {
+        for (size_t route = 0; route < ThreadMetrics::MAX_ROUTES; ++route) {
+            for (size_t status = 0; status < ThreadMetrics::STATUS_SLOTS; ++status) {
+                requests[route][status] += metrics->requests[route][status].get();
+            }
+            request_us[route].add(metrics->request_us[route]);
+        }
+        parse_ns.add(metrics->parse_ns);
+        write_us.add(metrics->write_us);
+    }
+
+    auto route_label = [&route_names](size_t route) {
+        const std::string_view name = route > 0 && route < route_names.size() ? route_names[route] : "other";
+        return "route=\"" + PrometheusWriter::escape(name) + "\"";
+    };
+
+    PrometheusWriter writer(out);
+    writer.declare("http_requests_total", "counter", "Completed HTTP requests by route and status code.");
+    for (size_t route = 0; route < ThreadMetrics::MAX_ROUTES; ++route) {
+        for (size_t status = 0; status < ThreadMetrics::STATUS_SLOTS; ++status) {
+            if (requests[route][status] == 0) continue;
+            const std::string code = status < ThreadMetrics::STATUS_CODES.size()
+                                         ? std::to_string(ThreadMetrics::STATUS_CODES[status])
+                                         : std::string("other");
+            writer.sample("http_requests_total", route_label(route) + ",code=\"" + code + "\"",
+                          requests[route][status]);
+        }
+    }
+
+    writer.declare("http_request_duration_seconds", "histogram",
+                   "Time from the first byte of a request until its response is written.");
+    for (size_t route = 0; route < ThreadMetrics::MAX_ROUTES; ++route) {
+        if (request_us[route].count == 0) continue;
+        writer.histogram("http_request_duration_seconds", route_label(route), request_us[route],
+                         LATENCY_BOUNDS_US, 1e6);
+    }
+
+    writer.declare("http_parse_duration_seconds", "histogram", "Time spent parsing each request.");
+    writer.histogram("http_parse_duration_seconds", "", parse_ns, PARSE_BOUNDS_NS, 1e9);
+
+    writer.declare("http_write_duration_seconds", "histogram", "Time to write one batch of responses.");
+    writer.histogram("http_write_duration_seconds", "", write_us, WRITE_BOUNDS_US, 1e6);
+}
+
+void PrometheusWriter::declare(std::string_view name, std::string_view type, std::string_view help) {
+    fmt::format_to(std::back_inserter(m_out), "# HELP {} {}\n# TYPE {} {}\n", name, help, name, type);
+}
+
+void PrometheusWriter::sample(std::string_view name, std::string_view labels, uint64_t value) {
+    if (labels.empty()) {
+        fmt::format_to(std::back_inserter(m_out), "{} {}\n", name, value);
+    } else {
+        fmt::format_to(std::back_inserter(m_out), "{}{{{}}} {}\n", name, labels, value);
+    }
+}
+
+void PrometheusWriter::sample(std::string_view name, std::string_view labels, double value) {
+    if (labels.empty()) {
+        fmt::format_to(std::back_inserter(m_out), "{} {}\n", name, value);
+    } else {
+        fmt::format_to(std::back_inserter(m_out), "{}{{{}}} {}\n", name, labels, value);
+    }
+}
+
+void PrometheusWriter::histogram(std::string_view name, std::string_view labels, const HistogramSnapshot& hist,
+                                 const std::vector<uint64_t>& bounds, double units_per_second) {
+    const std::string_view sep = labels.empty() ? "" : ",";
+    uint64_t cumulative = 0;
+    size_t index = 0;
+    for (uint64_t bound : bounds) {
+        while (index < hist.buckets.size() && LatencyHistogram::bucket_upper(index) <= bound) {
+            cumulative += hist.buckets[index++];
+        }
+        fmt::format_to(std::back_inserter(m_out), "{}_bucket{{{}{}le=\"{}\"}} {}\n",
+                       name, labels, sep, static_cast<double>(bound) / units_per_second, cumulative);
+    }
+    // 各桶与 count 不是同时读取的，总数取桶的合计，保证 +Inf 不小于前面的桶
+    while (index < hist.buckets.size()) {
+        cumulative += hist.buckets[index++];
+    }
+    fmt::format_to(std::back_inserter(m_out), "{}_bucket{{{}{}le=\"+Inf\"}} {}\n", name, labels, sep, cumulative);
+    const std::string braces = labels.empty() ? std::string() : "{" + std::string(labels) + "}";
+    fmt::format_to(std::back_inserter(m_out), "{}_sum{} {}\n", name, braces, static_cast<double>(hist.sum) / units_per_second);
+    fmt::format_to(std::back_inserter(m_out), "{}_count{} {}\n", name, braces, cumulative);
+}
+
+std::string PrometheusWriter::escape(std::string_view value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (char c : value) {
+        switch (c) {
+            case '\\': escaped += "\\\\"; break;
+            case '"': escaped += "\\\""; break;
+            case '\n': escaped += "\\n"; break;
+            default: escaped += c; break;
+        }
+    }
+    return escaped;
+}
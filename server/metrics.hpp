@@ -0,0 +1,121 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "histogram.hpp"
+
+// 单写者计数器：只由所属线程累加（普通读-改-写，没有 lock 前缀的原子指令），
+// 导出线程随时读取
+class LocalCounter {
+public:
+    void add(uint64_t n = 1) { value_.store(value_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+    uint64_t get() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+// 单写者直方图，分桶与 LatencyHistogram 相同（对数-线性，相对误差 1/8）
+class LocalHistogram {
+public:
+    void record(uint64_t value) {
+        buckets_[LatencyHistogram::bucket_of(value)].add();
+        count_.add();
+        sum_.add(value);
+    }
+
+    uint64_t bucket(size_t index) const { return buckets_[index].get(); }
+    uint64_t count() const { return count_.get(); }
+    uint64_t sum() const { return sum_.get(); }
+
+private:
+    std::array<LocalCounter, LatencyHistogram::BUCKETS> buckets_{};
+    LocalCounter count_;
+    LocalCounter sum_;
+};
+
+// 导出时合并得到的直方图
+struct HistogramSnapshot {
+    std::array<uint64_t, LatencyHistogram::BUCKETS> buckets{};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+
+    void add(const LocalHistogram& hist);
+    void add(const LatencyHistogram& hist);
+};
+
+// 每个网络线程一份的请求指标，按路由（Router 分配的编号）和状态码细分
+struct alignas(64) ThreadMetrics {
+    static constexpr size_t MAX_ROUTES = 16;  // 编号超出的路由计入 0（"other"）
+    static constexpr std::array<int, 17> STATUS_CODES = {
+        200, 204, 206, 301, 302, 304, 400, 401, 403, 404, 405, 408, 413, 429, 500, 503, 504};
+    static constexpr size_t STATUS_SLOTS = STATUS_CODES.size() + 1;  // 最后一个为其他状态码
+
+    static size_t route_slot(uint16_t route_id) { return route_id < MAX_ROUTES ? route_id : 0; }
+    static size_t status_slot(int status);
+
+    std::array<std::array<LocalCounter, STATUS_SLOTS>, MAX_ROUTES> requests;  // 完成的请求数
+    std::array<LocalHistogram, MAX_ROUTES> request_us;  // 请求第一个字节到达至响应发送完毕（微秒）
+    LocalHistogram parse_ns;   // 解析请求（HttpParser::parse）的耗时（纳秒）
+    LocalHistogram write_us;   // 一批响应从开始发送到发送完毕（微秒）
+};
+
+// 指标注册表：各线程第一次记录时登记自己的 ThreadMetrics（之后不加锁），
+// 导出时遍历所有线程的数据求和；线程退出后其数据保留，计数不会回退
+class MetricsRegistry {
+public:
+    static MetricsRegistry* GetInstance();
+
+    // 当前线程的指标
+    static ThreadMetrics& local() {
+        static thread_local ThreadMetrics* metrics = GetInstance()->register_thread();
+        return *metrics;
+    }
+
+    // 追加 Prometheus 文本格式的请求指标，route_names 下标为路由编号
+    void render(std::string& out, const std::vector<std::string>& route_names);
+
+private:
+    MetricsRegistry() = default;
+    ThreadMetrics* register_thread();
+
+private:
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<ThreadMetrics>> m_threads;
+};
+
+// 微秒耗时直方图默认的 le 桶上界
+extern const std::vector<uint64_t> LATENCY_BOUNDS_US;
+
+// Prometheus 文本格式（0.0.4）输出
+class PrometheusWriter {
+public:
+    static constexpr std::string_view CONTENT_TYPE = "text/plain; version=0.0.4; charset=utf-8";
+
+    explicit PrometheusWriter(std::string& out) : m_out(out) {}
+
+    // # HELP / # TYPE 行，每个指标名输出一次
+    void declare(std::string_view name, std::string_view type, std::string_view help);
+    // 一个样本，labels 为已拼好的 k="v" 列表（可为空）
+    void sample(std::string_view name, std::string_view labels, uint64_t value);
+    void sample(std::string_view name, std::string_view labels, double value);
+    // 直方图样本：bounds 为各 le 桶上界（记录时的单位），输出时除以 units_per_second 换算为秒。
+    // 落在 le 附近的细分桶按其上界归属，桶计数有最多 1/8 的相对误差
+    void histogram(std::string_view name, std::string_view labels, const HistogramSnapshot& hist,
+                   const std::vector<uint64_t>& bounds, double units_per_second);
+
+    // 标签值转义（反斜杠、双引号、换行）
+    static std::string escape(std::string_view value);
+
+private:
+    std::string& m_out;
+};
+
+#endif
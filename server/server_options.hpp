@@ -0,0 +1,83 @@
+#ifndef SERVER_OPTIONS_H
+#define SERVER_OPTIONS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "db_latency.hpp"
+
+// 用户数据后端
+enum class UserBackend {
+    MYSQL,   // MySQL（UserServiceMain），可叠加注册组提交/认证缓存/Bloom 过滤器
+    MEMORY,  // 进程内存 + 本地快照/日志（MemoryUserService），不使用数据库
+    FAKE_DB  // 模拟数据库延迟（FakeDbUserService），连接池由调用方用假连接初始化，用于压测连接池和执行器
+};
+
+// 服务器运行参数
+struct ServerOptions {
+    int thread_num = 4;               // 工作线程数（分片模式下即分片数）
+    std::string root;                 // 网页根目录
+
+    // thread-per-core 分片模式：每个分片独占一个 io_context、一个线程
+    // 和一个 SO_REUSEPORT 监听套接字，连接始终留在接受它的分片上
+    bool sharded = false;
+    bool pin_threads = false;         // 分片线程绑定到 CPU 核
+    int stats_report_interval = 10;   // 分片统计输出间隔（秒），0 为关闭
+    std::string metrics_path = "/metrics";  // Prometheus 指标路由，为空时不注册
+
+    // 请求阶段追踪：每 N 个请求追踪一个（0 为关闭），每个线程保留最近 trace_buffer_events 个事件，
+    // 开启时在 trace_path 导出 Chrome Trace 格式的 JSON
+    uint32_t trace_sample_rate = 0;
+    size_t trace_buffer_events = 65536;
+    std::string trace_path = "/debug/trace";
+
+    // 连接超时（毫秒），由每个分片的时间轮按 timer_tick_ms 粗粒度批量检查：
+    //   idle   - 两个请求之间、发送响应期间无活动
+    //   header - 从请求的第一个字节起收完请求头的期限（不因后续数据延长）
+    //   body   - 接收请求体期间两次读取之间的最长间隔
+    int idle_timeout_ms = 60000;
+    int header_timeout_ms = 10000;
+    int body_timeout_ms = 30000;
+    int timer_tick_ms = 500;
+
+    // 请求体（Content-Length）上限，超过时返回 413 并关闭连接
+    size_t max_body_bytes = 1024 * 1024;
+
+    // 静态文件发送方式：true 为 sendfile(2) 零拷贝，false 为 mmap + async_write
+    bool use_sendfile = true;
+
+    // 静态文件缓存：容量为 0 时关闭
+    size_t static_cache_bytes = 64 * 1024 * 1024;   // 缓存总容量
+    size_t static_cache_max_file = 4 * 1024 * 1024; // 单个文件上限
+    int static_cache_revalidate_ms = 1000;          // 修改时间校验间隔（毫秒）
+
+    // 阻塞路由（数据库访问）的执行器：线程数一般与数据库连接数相同，
+    // 排队数超过上限时直接返回 503，而不是让请求无限堆积
+    int db_threads = 10;
+    size_t db_queue_capacity = 1024;
+
+    // 用户数据后端；MEMORY 时不使用下面的注册组提交、认证缓存和 Bloom 过滤器
+    UserBackend user_backend = UserBackend::MYSQL;
+    std::string memory_users_path = "data/users";  // 快照 .snap 和日志 .log 的路径前缀，为空时不持久化
+    size_t memory_users_expected = 100000;         // 预留容量
+    size_t memory_users_compact_bytes = 64 * 1024 * 1024;  // 日志超过该大小时写快照
+    bool memory_users_sync = false;                // 每次注册后 fdatasync 日志
+    DbLatency fake_db_query = DbLatency::fixed(1000);  // FAKE_DB 每次查询持有连接的时间分布和失败率
+
+    // 注册组提交：并发的注册最多等待 window_us 或攒够 max_rows 个后在一个事务里提交，
+    // max_rows 不超过 1 时关闭
+    size_t register_batch_max_rows = 64;
+    int register_batch_window_us = 2000;
+    int register_batch_threads = 2;
+
+    // 登录认证缓存：容量为 0 时关闭，每次登录都查询数据库
+    size_t auth_cache_capacity = 10000;
+    int auth_cache_ttl_ms = 60000;            // 已存在用户的缓存时间
+    int auth_cache_negative_ttl_ms = 2000;    // 不存在的用户名的缓存时间
+
+    // 用户名 Bloom 过滤器：预期用户数为 0 时关闭（默认关闭）
+    size_t bloom_expected_users = 0;
+    double bloom_false_positive_rate = 0.01;
+};
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <cstdint>
+
+// 时间轮上的定时器节点，嵌入在拥有者对象中（侵入式链表），登记/刷新/取消都不分配内存
+struct TimerNode {
+    TimerNode* prev = nullptr;
+    TimerNode* next = nullptr;
+    uint64_t expires = 0;  // 到期 tick
+    uint64_t placed = 0;   // 放入当前槽位时依据的到期 tick
+    void* owner = nullptr;
+
+    bool linked() const { return next != nullptr; }
+};
+
+// 分层时间轮（LEVELS 层，每层 SLOTS 个槽），时间单位为 tick，非线程安全。
+//   - schedule 为 O(1)：到期时间不早于当前槽位时只更新 expires，节点留在原槽位，
+//     处理到该槽位时发现未到期再重新放置（频繁刷新的连接每个超时周期最多移动一次）；
+//   - advance 推进到指定 tick，逐 tick 处理第 0 层槽位，第 0 层转一圈时把上层槽位下放。
+// 可表示的最长超时为 SLOTS^LEVELS 个 tick，更长的按上限处理
+class TimingWheel {
+public:
+    static constexpr unsigned SLOT_BITS = 6;
+    static constexpr unsigned SLOTS = 1u << SLOT_BITS;
+    static constexpr unsigned LEVELS = 4;
+    static constexpr uint64_t MAX_TICKS = (uint64_t{1} << (SLOT_BITS * LEVELS)) - 1;
+
+    explicit TimingWheel(uint64_t now = 0) : now_(now) {
+        for (auto& level : slots_) {
+            for (TimerNode& head : level) {
+                head.prev = head.next = &head;
+            }
+        }
+    }
+
+    TimingWheel(const TimingWheel&) = delete;
+    TimingWheel& operator=(const TimingWheel&) = delete;
+
+    uint64_t now() const { return now_; }
+
+    // ticks 个 tick 后到期（至少 1 个 tick），已登记的节点改为新的到期时间
+    void schedule(TimerNode& node, uint64_t ticks) {
+        if (ticks == 0) ticks = 1;
+        if (ticks > MAX_TICKS) ticks = MAX_TICKS;
+        node.expires = now_ + ticks;
+        if (node.linked()) {
+            if (node.expires >= node.placed) {
+                return;  // 延后：留在原槽位，处理时再重新放置
+            }
+            unlink(node);
+        }
+        place(node);
+    }
+
+    void cancel(TimerNode& node) {
+        if (node.linked()) {
+            unlink(node);
+        }
+    }
+
+    // 推进到 tick now，到期的节点从时间轮移除后交给 on_expire(TimerNode&)
+    template <typename F>
+    void advance(uint64_t now, F&& on_expire) {
+        while (now_ < now) {
+            ++now_;
+            // 第 0 层转完一圈时，依次把上层当前槽位的节点下放
+            for (unsigned level = 1; level < LEVELS; ++level) {
+                if ((now_ & ((uint64_t{1} << (SLOT_BITS * level)) - 1)) != 0) break;
+                cascade(slots_[level][(now_ >> (SLOT_BITS * level)) & (SLOTS - 1)]);
+            }
+
+            TimerNode pending;
+            take(slots_[0][now_ & (SLOTS - 1)], pending);
+            while (pending.next != &pending) {
+                TimerNode& node = *pending.next;
+                unlink(node);
+                if (node.expires > now_) {
+                    place(node);  // 期间被刷新过，按新的到期时间放置
+                } else {
+                    on_expire(node);
+                }
+            }
+        }
+    }
+
+private:
+    void place(TimerNode& node) {
+        node.placed = node.expires;
+        const uint64_t delta = node.expires > now_ ? node.expires - now_ : 0;
+        unsigned level = 0;
+        while (level + 1 < LEVELS && delta >= (uint64_t{1} << (SLOT_BITS * (level + 1)))) {
+            ++level;
+        }
+        // 到期时间不晚于当前 tick（下放时）放入当前槽位，本 tick 内处理
+        const uint64_t at = delta == 0 ? now_ : node.expires;
+        link(slots_[level][(at >> (SLOT_BITS * level)) & (SLOTS - 1)], node);
+    }
+
+    void cascade(TimerNode& head) {
+        TimerNode pending;
+        take(head, pending);
+        while (pending.next != &pending) {
+            TimerNode& node = *pending.next;
+            unlink(node);
+            place(node);
+        }
+    }
+
+    // 把槽位链表整体移到 out（空的哨兵节点）
+    static void take(TimerNode& head, TimerNode& out) {
+        if (head.next == &head) {
+            out.prev = out.next = &out;
+            return;
+        }
+        out.next = head.next;
+        out.prev = head.prev;
+        out.next->prev = &out;
+        out.prev->next = &out;
+        head.prev = head.next = &head;
+    }
+
+    static void link(TimerNode& head, TimerNode& node) {
+        node.prev = head.prev;
+        node.next = &head;
+        head.prev->next = &node;
+        head.prev = &node;
+    }
+
+    static void unlink(TimerNode& node) {
+        node.prev->next = node.next;
+        node.next->prev = node.prev;
+        node.prev = node.next = nullptr;
+    }
+
+    uint64_t now_;
+    TimerNode slots_[LEVELS][SLOTS];
+};
+
+#endif
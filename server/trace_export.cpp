@@ -0,0 +1,80 @@
+#include "trace_export.hpp"
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include "request_trace.hpp"
+#include "spdlog/spdlog.h"
+
+namespace trace_export {
+
+namespace {
+
+const char* role_name(ThreadRole role) {
+    switch (role) {
+        case ThreadRole::NETWORK: return "network";
+        case ThreadRole::DB: return "db";
+        default: return "other";
+    }
+}
+
+// 一个异步事件的起点或终点
+struct Edge {
+    uint64_t ts_ns;
+    bool begin;
+    uint64_t dur_ns;
+    uint32_t tid;
+    const TraceEvent* event;
+};
+
+}  // namespace
+
+void write_chrome_trace(std::string& out) {
+    std::vector<TraceEvent> events;
+    std::vector<std::pair<size_t, const TraceBuffer*>> ranges;  // 各线程事件的结束下标
+    for (const TraceBuffer* buffer : RequestTracer::GetInstance()->buffers()) {
+        buffer->snapshot(events);
+        ranges.emplace_back(events.size(), buffer);
+    }
+
+    std::vector<Edge> edges;
+    edges.reserve(events.size() * 2);
+    size_t first = 0;
+    for (const auto& range : ranges) {
+        for (size_t i = first; i < range.first; ++i) {
+            const TraceEvent& event = events[i];
+            if (!event.name || event.end_ns < event.start_ns) continue;
+            const uint64_t dur = event.end_ns - event.start_ns;
+            edges.push_back(Edge{event.start_ns, true, dur, range.second->tid(), &event});
+            edges.push_back(Edge{event.end_ns, false, dur, range.second->tid(), &event});
+        }
+        first = range.first;
+    }
+    // 导入方按时间戳逐个配对嵌套的 b/e：同一时刻先结束再开始，
+    // 同时开始的长阶段在前（外层），同时结束的短阶段在前（内层）
+    std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) {
+        if (a.ts_ns != b.ts_ns) return a.ts_ns < b.ts_ns;
+        if (a.begin != b.begin) return !a.begin;
+        return a.begin ? a.dur_ns > b.dur_ns : a.dur_ns < b.dur_ns;
+    });
+
+    auto it = std::back_inserter(out);
+    out += "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool comma = false;
+    for (const auto& range : ranges) {
+        const TraceBuffer* buffer = range.second;
+        fmt::format_to(it, "{}{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},"
+                           "\"args\":{{\"name\":\"{}-{}\"}}}}",
+                       comma ? "," : "", buffer->tid(), role_name(buffer->role()), buffer->tid());
+        comma = true;
+    }
+    for (const Edge& edge : edges) {
+        fmt::format_to(it, "{}{{\"name\":\"{}\",\"cat\":\"request\",\"ph\":\"{}\",\"id\":\"0x{:x}\","
+                           "\"pid\":1,\"tid\":{},\"ts\":{}.{:03}}}",
+                       comma ? "," : "", edge.event->name, edge.begin ? 'b' : 'e', edge.event->trace_id,
+                       edge.tid, edge.ts_ns / 1000, edge.ts_ns % 1000);
+        comma = true;
+    }
+    out += "]}\n";
+}
+
+}  // namespace trace_export
@@ -0,0 +1,19 @@
+#ifndef TRACE_EXPORT_H
+#define TRACE_EXPORT_H
+
+#include <string>
+#include <string_view>
+
+// 把各线程追踪缓冲区中的事件导出为 Chrome Trace Event 格式（JSON，可在 Perfetto /
+// chrome://tracing 中打开）：每个阶段是一对嵌套的异步事件（"b"/"e"），同一请求的阶段
+// 以追踪 ID 关联到一条轨道上，其中 "request" 覆盖请求的全程
+namespace trace_export {
+
+constexpr std::string_view CONTENT_TYPE = "application/json";
+
+// 追加 {"traceEvents":[...]} 到 out
+void write_chrome_trace(std::string& out);
+
+}  // namespace trace_export
+
+#endif
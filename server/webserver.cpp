@@ -1,81 +1,235 @@
 #include <thread>
+#include <algorithm>
+#include <pthread.h>
+#include <sys/sendfile.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
 #include "webserver.hpp"
+#include "db_cluster.hpp"
+#include "thread_role.hpp"
+#include "request_log.hpp"
+#include "trace_export.hpp"
 #include "spdlog/spdlog.h"
 
 using asio::ip::tcp;
 
 // ======================== WebServer ========================
 
-WebServer::WebServer(asio::io_context& io_context, int thread_num, const std::string& root)
+namespace {
+
+std::unique_ptr<UserService> make_user_service(const ServerOptions& options) {
+    if (options.user_backend == UserBackend::MEMORY) {
+        MemoryUserOptions memory_options;
+        memory_options.path = options.memory_users_path;
+        memory_options.expected_users = options.memory_users_expected;
+        memory_options.compact_log_bytes = options.memory_users_compact_bytes;
+        memory_options.sync_log = options.memory_users_sync;
+        auto service = std::make_unique<MemoryUserService>(memory_options);
+        if (!service->load()) {
+            throw std::runtime_error("loading the memory user store failed");
+        }
+        return service;
+    }
+    if (options.user_backend == UserBackend::FAKE_DB) {
+        spdlog::warn("Using the fake database backend: {}", options.fake_db_query.describe());
+        return std::make_unique<FakeDbUserService>(*connection_pool::GetInstance(), options.fake_db_query);
+    }
+    return std::make_unique<UserServiceMain>();
+}
+
+// 内存后端的查询本身就很快，组提交、认证缓存和 Bloom 过滤器只会增加开销
+ServerOptions effective_options(ServerOptions options) {
+    if (options.user_backend == UserBackend::MEMORY) {
+        options.register_batch_max_rows = 0;
+        options.auth_cache_capacity = 0;
+        options.bloom_expected_users = 0;
+    }
+    return options;
+}
+
+}  // namespace
+
+WebServer::WebServer(asio::io_context& io_context, const ServerOptions& options)
+    : WebServer(io_context, options, make_user_service(options)) {}
+
+WebServer::WebServer(asio::io_context& io_context, const ServerOptions& options, std::unique_ptr<UserService> service)
     : io_context_(io_context),
       acceptor_(io_context_),
-      thread_num_(thread_num),
+      options_(effective_options(options)),
       signals_(io_context, SIGINT, SIGTERM),
-      root_(root),
-      m_service(),
-      m_controller(m_service),
-      m_router(m_controller) {
+      stats_timer_(io_context),
+      shared_stats_(std::make_shared<ShardStats>()),
+      m_service(std::move(service)),
+      m_memory_users(dynamic_cast<MemoryUserService*>(m_service.get())),
+      m_fake_db(dynamic_cast<FakeDbUserService*>(m_service.get())),
+      m_batcher(*m_service, RegisterBatchOptions{options_.register_batch_max_rows, options_.register_batch_window_us,
+                                                 options_.register_batch_threads}),
+      m_auth_cache(batch_layer(), AuthCacheOptions{options_.auth_cache_capacity, options_.auth_cache_ttl_ms,
+                                               options_.auth_cache_negative_ttl_ms}),
+      m_bloom(cache_layer(), BloomOptions{options_.bloom_expected_users, options_.bloom_false_positive_rate}),
+      m_controller(front_layer()),
+      m_router(m_controller),
+      db_executor_(static_cast<size_t>(std::max(1, options_.db_threads)), options_.db_queue_capacity) {
+
+    // 探针路由：编排系统据此判断何时可以转发流量
+    m_router.register_route(HttpRequest::METHOD::GET, "/healthz",
+                            RouteHandler::bind<&WebServer::handle_healthz>(this));
+    m_router.register_route(HttpRequest::METHOD::GET, "/readyz",
+                            RouteHandler::bind<&WebServer::handle_readyz>(this));
+    if (!options_.metrics_path.empty()) {
+        m_router.register_route(HttpRequest::METHOD::GET, options_.metrics_path,
+                                RouteHandler::bind<&WebServer::handle_metrics>(this));
+    }
+    RequestTracer::GetInstance()->configure(options_.trace_sample_rate, options_.trace_buffer_events);
+    if (options_.trace_sample_rate > 0 && !options_.trace_path.empty()) {
+        // 导出要复制并排序所有缓冲区，放到 DB 执行器上，不占用网络线程
+        m_router.register_route(HttpRequest::METHOD::GET, options_.trace_path,
+                                RouteHandler::bind<&WebServer::handle_trace>(this).offload());
+    }
+
+    if (options_.bloom_expected_users > 0) {
+        m_bloom.start_loading();
+    }
+
+    StaticFileCache::GetInstance()->init(options_.static_cache_bytes,
+                                         options_.static_cache_max_file,
+                                         options_.static_cache_revalidate_ms);
+
+    if (options_.sharded) {
+        for (int i = 0; i < options_.thread_num; ++i) {
+            shards_.push_back(std::make_unique<Shard>(i, options_));
+            shards_.back()->timers->start();
+        }
+    } else {
+        for (int i = 0; i < std::max(1, options_.thread_num); ++i) {
+            shared_timers_.push_back(std::make_shared<ConnectionTimers>(io_context_.get_executor(), options_));
+            shared_timers_.back()->start();
+        }
+    }
 
     // 捕获 SIGINT/SIGTERM，优雅关闭
     signals_.async_wait([this](std::error_code ec, int) {
         if (!ec) {
             spdlog::info("Signal received, stopping io_context");
-            io_context_.stop();
+            stop();
         }
     });
 }
 
-bool WebServer::listen(const std::string& ip, const std::string& port) {
+bool WebServer::open_acceptor(tcp::acceptor& acceptor, const tcp::endpoint& endpoint, bool reuse_port) {
     asio::error_code ec;
 
-    tcp::resolver resolver(io_context_);
-    auto results = resolver.resolve(ip, port, ec);
-    if (ec || results.begin() == results.end()) {
-        spdlog::error("Resolve {}:{} failed: {}", ip, port, ec.message());
-        return false;
-    }
-
-    const tcp::endpoint endpoint = results.begin()->endpoint();
-
-    acceptor_.open(endpoint.protocol(), ec);
+    acceptor.open(endpoint.protocol(), ec);
     if (ec) {
         spdlog::error("Open acceptor failed: {}", ec.message());
         return false;
     }
 
     // 可复用地址
-    acceptor_.set_option(tcp::acceptor::reuse_address(true), ec);
+    acceptor.set_option(tcp::acceptor::reuse_address(true), ec);
     if (ec) {
         spdlog::error("Set reuse_address failed: {}", ec.message());
         return false;
     }
 
-    acceptor_.bind(endpoint, ec);
+    // 多个监听套接字绑定同一端口，由内核在分片间分发新连接
+    if (reuse_port) {
+        using reuse_port_option = asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+        acceptor.set_option(reuse_port_option(true), ec);
+        if (ec) {
+            spdlog::error("Set reuse_port failed: {}", ec.message());
+            return false;
+        }
+    }
+
+    acceptor.bind(endpoint, ec);
     if (ec) {
         spdlog::error("Bind {}:{} failed: {}", endpoint.address().to_string(), endpoint.port(), ec.message());
         return false;
     }
 
-    acceptor_.listen(asio::socket_base::max_listen_connections, ec);
+    acceptor.listen(asio::socket_base::max_listen_connections, ec);
     if (ec) {
         spdlog::error("Listen failed: {}", ec.message());
         return false;
     }
+    return true;
+}
+
+bool WebServer::listen(const std::string& ip, const std::string& port) {
+    asio::error_code ec;
+
+    tcp::resolver resolver(io_context_);
+    auto results = resolver.resolve(ip, port, ec);
+    if (ec || results.begin() == results.end()) {
+        spdlog::error("Resolve {}:{} failed: {}", ip, port, ec.message());
+        return false;
+    }
+
+    const tcp::endpoint endpoint = results.begin()->endpoint();
+
+    if (options_.sharded) {
+        for (auto& shard : shards_) {
+            if (!open_acceptor(shard->acceptor, endpoint, true)) {
+                return false;
+            }
+            accept(shard->acceptor, shard->stats, shard.get()); // 每个分片各自的 accept 循环
+        }
+        spdlog::info("Listening on {}:{} with {} SO_REUSEPORT shards",
+                     endpoint.address().to_string(), endpoint.port(), shards_.size());
+    } else {
+        if (!open_acceptor(acceptor_, endpoint, false)) {
+            return false;
+        }
+        spdlog::info("Listening on {}:{}", endpoint.address().to_string(), endpoint.port());
+        accept(acceptor_, shared_stats_, nullptr); // 启动 accept 循环
+    }
 
-    spdlog::info("Listening on {}:{}", endpoint.address().to_string(), endpoint.port());
-    accept(); // 启动 accept 循环
+    if (options_.stats_report_interval > 0) {
+        last_requests_.assign(std::max<size_t>(shards_.size(), 1), 0);
+        report_stats();
+    }
     return true;
 }
 
 void WebServer::run() {
-    // 多线程跑 io_context
     std::vector<std::thread> threads;
-    threads.reserve(static_cast<size_t>(thread_num_));
 
-    for (int i = 0; i < thread_num_; ++i) {
-        threads.emplace_back([this]() {
-            io_context_.run();
-        });
+    if (options_.sharded) {
+        // 每个分片一个线程，各自运行独立的 io_context
+        threads.reserve(shards_.size());
+        const unsigned cpu_count = std::max(1u, std::thread::hardware_concurrency());
+        for (auto& shard : shards_) {
+            Shard* s = shard.get();
+            threads.emplace_back([s]() {
+                set_thread_role(ThreadRole::NETWORK);
+                s->io_context.run();
+            });
+
+            if (options_.pin_threads) {
+                cpu_set_t cpus;
+                CPU_ZERO(&cpus);
+                CPU_SET(static_cast<unsigned>(s->id) % cpu_count, &cpus);
+                if (pthread_setaffinity_np(threads.back().native_handle(), sizeof(cpus), &cpus) != 0) {
+                    spdlog::warn("Pin shard {} to cpu failed", s->id);
+                }
+            }
+        }
+
+        // 主线程只处理信号和统计
+        set_thread_role(ThreadRole::NETWORK);
+        io_context_.run();
+    } else {
+        // 多线程跑 io_context
+        threads.reserve(static_cast<size_t>(options_.thread_num));
+
+        for (int i = 0; i < options_.thread_num; ++i) {
+            threads.emplace_back([this]() {
+                set_thread_role(ThreadRole::NETWORK);
+                io_context_.run();
+            });
+        }
     }
 
     for (auto& t : threads) {
@@ -83,15 +237,38 @@ void WebServer::run() {
     }
 }
 
-void WebServer::accept() {
+void WebServer::stop() {
+    asio::error_code ec;
+    stats_timer_.cancel(ec);
+    for (auto& timers : shared_timers_) {
+        timers->stop();
+    }
+    for (auto& shard : shards_) {
+        shard->timers->stop();
+        shard->io_context.stop();
+    }
+    io_context_.stop();
+    db_executor_.stop();
+}
+
+void WebServer::accept(tcp::acceptor& acceptor, const std::shared_ptr<ShardStats>& stats, Shard* shard) {
     // 若 acceptor 已关闭，不再递归
-    if (!acceptor_.is_open()) return;
+    if (!acceptor.is_open()) return;
+
+    // 共享模式下多个线程运行同一个 io_context，连接的回调（读写、定时器、DB 结果）
+    // 统一在连接自己的 strand 上串行执行；分片模式单线程，无需 strand
+    asio::any_io_executor executor = acceptor.get_executor();
+    if (!options_.sharded) {
+        executor = asio::make_strand(executor);
+    }
 
-    acceptor_.async_accept([this](std::error_code ec, tcp::socket socket) {
+    acceptor.async_accept(executor, [this, &acceptor, stats, shard](std::error_code ec, tcp::socket socket) {
         if (!ec) {
-            auto rep = socket.remote_endpoint(ec);
-            if (!ec) spdlog::info("New client connection from {}:{}", rep.address().to_string(), rep.port());
-            std::make_shared<Connection>(std::move(socket), root_, m_router)->start();
+            // 同一监听套接字的 accept 回调不会并发执行
+            std::shared_ptr<ConnectionTimers> timers =
+                shard ? shard->timers : shared_timers_[next_timers_++ % shared_timers_.size()];
+            std::make_shared<Connection>(std::move(socket), options_.root, m_router, db_executor_, stats,
+                                         std::move(timers), options_.use_sendfile, options_.max_body_bytes)->start();
         } 
         else {
             if (ec == asio::error::operation_aborted) {
@@ -100,25 +277,359 @@ void WebServer::accept() {
             spdlog::error("Accept failed: {}", ec.message());
         }
 
-        accept();
+        accept(acceptor, stats, shard);
+    });
+}
+
+void WebServer::report_stats() {
+    stats_timer_.expires_after(std::chrono::seconds(options_.stats_report_interval));
+    stats_timer_.async_wait([this](std::error_code ec) {
+        if (ec) return;
+
+        const double interval = static_cast<double>(options_.stats_report_interval);
+        auto report = [&](const std::string& name, const ShardStats& stats, uint64_t& last_requests) {
+            const uint64_t requests = stats.requests.load(std::memory_order_relaxed);
+            spdlog::info("[{}] accepted={} active={} requests={} ({:.1f} req/s) in={}B out={}B timeouts={}",
+                         name,
+                         stats.accepted.load(std::memory_order_relaxed),
+                         stats.active.load(std::memory_order_relaxed),
+                         requests,
+                         static_cast<double>(requests - last_requests) / interval,
+                         stats.bytes_in.load(std::memory_order_relaxed),
+                         stats.bytes_out.load(std::memory_order_relaxed),
+                         stats.timeouts.load(std::memory_order_relaxed));
+            last_requests = requests;
+        };
+
+        if (options_.sharded) {
+            for (size_t i = 0; i < shards_.size(); ++i) {
+                report("shard " + std::to_string(i), *shards_[i]->stats, last_requests_[i]);
+            }
+        } else {
+            report("shared", *shared_stats_, last_requests_[0]);
+        }
+
+        if (m_memory_users) {
+            const MemoryUserStats users = m_memory_users->GetStats();
+            spdlog::info("[memory users] users={} log={}B compactions={} log_failures={} "
+                         "db executor inflight={}/{} rejected={} exec p99={}us",
+                         users.users, users.log_bytes, users.compactions, users.log_failures,
+                         db_executor_.inflight(), db_executor_.capacity(), db_executor_.rejected(),
+                         db_executor_.exec_us().percentile(99));
+            report_stats();
+            return;
+        }
+
+        // DB 执行器排队/执行耗时，以及各类线程等待数据库连接的耗时（微秒）
+        connection_pool* db_pool = connection_pool::GetInstance();
+        const LatencyHistogram& network_wait = db_pool->GetWaitHistogram(true);
+        const LatencyHistogram& worker_wait = db_pool->GetWaitHistogram(false);
+        spdlog::info("[db] inflight={}/{} rejected={} queue p50={}us p99={}us exec p50={}us p99={}us "
+                     "pool wait: network threads n={} total={}us max={}us, db threads n={} p99={}us",
+                     db_executor_.inflight(), db_executor_.capacity(), db_executor_.rejected(),
+                     db_executor_.queue_wait_us().percentile(50), db_executor_.queue_wait_us().percentile(99),
+                     db_executor_.exec_us().percentile(50), db_executor_.exec_us().percentile(99),
+                     network_wait.count(), network_wait.sum(), network_wait.max(),
+                     worker_wait.count(), worker_wait.percentile(99));
+
+        const PoolStats pool = db_pool->GetStats();
+        spdlog::info("[db pool] total={} in_use={} idle={} waiters={} created={} shrunk={} replaced={} timeouts={}",
+                     pool.total, pool.in_use, pool.idle, pool.waiters,
+                     pool.created, pool.shrunk, pool.replaced, pool.timeouts);
+        if (m_fake_db) {
+            const FakeDbStats fake = m_fake_db->GetStats();
+            spdlog::info("[fake db] queries={} failures={} busy={}", fake.queries, fake.failures, fake.busy);
+        }
+
+        DbCluster* cluster = DbCluster::GetInstance();
+        for (const ReplicaStats& replica : cluster->GetReplicaStats()) {
+            spdlog::info("[db replica] {}:{} {} outstanding={} reads={} failures={}",
+                         replica.host, replica.port, replica.down ? "down" : "up",
+                         replica.outstanding, replica.reads, replica.failures);
+        }
+        if (cluster->GetReplicaCount() > 0) {
+            spdlog::info("[db replica] primary fallbacks={}", cluster->GetFallbacks());
+        }
+
+        if (m_batcher.enabled()) {
+            const RegisterBatchStats batches = m_batcher.GetStats();
+            spdlog::info("[register batch] batches={} rows={} full={} rows/batch p50={} p99={} max={}",
+                         batches.batches, batches.rows, batches.full,
+                         batches.batch_rows->percentile(50), batches.batch_rows->percentile(99),
+                         batches.batch_rows->max());
+        }
+
+        if (options_.auth_cache_capacity > 0) {
+            const AuthCacheStats cache = m_auth_cache.GetStats();
+            spdlog::info("[auth cache] size={} hits={} negative_hits={} misses={} evictions={} invalidations={}",
+                         cache.size, cache.hits, cache.negative_hits, cache.misses,
+                         cache.evictions, cache.invalidations);
+        }
+
+        if (options_.bloom_expected_users > 0) {
+            // 观测误判率：不存在的用户名中通过了过滤器的比例
+            const BloomStats bloom = m_bloom.GetStats();
+            const uint64_t absent = bloom.definite_negatives + bloom.false_positives;
+            spdlog::info("[bloom] {} users={} memory={}KiB k={} estimated_fp={:.4f}% "
+                         "definite_negatives={} false_positives={} missed={} observed_fp={:.4f}%",
+                         bloom.ready ? "ready" : "loading", bloom.items, bloom.memory_bytes / 1024, bloom.hashes,
+                         bloom.estimated_fp_rate * 100, bloom.definite_negatives, bloom.false_positives, bloom.missed,
+                         absent ? 100.0 * static_cast<double>(bloom.false_positives) / static_cast<double>(absent) : 0.0);
+        }
+
+        report_stats();
+    });
+}
+
+HTTP_CODE WebServer::handle_healthz(HttpRequest& req, HttpResponse& res) {
+    (void)req;
+    res.set_body("ok\n");
+    return HTTP_CODE::CONTENT_REQUEST;
+}
+
+HTTP_CODE WebServer::handle_readyz(HttpRequest& req, HttpResponse& res) {
+    (void)req;
+    if (m_memory_users) {
+        // 内存后端在构造时已载入完毕
+        res.set_body(fmt::format("ready users={}\n", m_memory_users->GetStats().users));
+        return HTTP_CODE::CONTENT_REQUEST;
+    }
+    const connection_pool* db_pool = connection_pool::GetInstance();
+    const bool ready = db_pool->IsReady();
+    res.set_status(ready ? 200 : 503);
+    res.set_body(fmt::format("{} db_connections={}/{}\n", ready ? "ready" : "not ready",
+                             db_pool->GetEstablished(), db_pool->GetReadyThreshold()));
+    return HTTP_CODE::CONTENT_REQUEST;
+}
+
+HTTP_CODE WebServer::handle_metrics(HttpRequest& req, HttpResponse& res) {
+    (void)req;
+    std::string& body = res.get_body();
+    MetricsRegistry::GetInstance()->render(body, m_router.route_names());
+
+    PrometheusWriter writer(body);
+    std::vector<std::pair<std::string, const ShardStats*>> stats;
+    if (options_.sharded) {
+        for (const auto& shard : shards_) {
+            stats.emplace_back("shard=\"" + std::to_string(shard->id) + "\"", shard->stats.get());
+        }
+    } else {
+        stats.emplace_back("shard=\"shared\"", shared_stats_.get());
+    }
+    auto shard_metric = [&](const char* name, const char* type, const char* help,
+                            const std::atomic<uint64_t> ShardStats::*field) {
+        writer.declare(name, type, help);
+        for (const auto& entry : stats) {
+            writer.sample(name, entry.first, (entry.second->*field).load(std::memory_order_relaxed));
+        }
+    };
+    shard_metric("http_connections_active", "gauge", "Open client connections.", &ShardStats::active);
+    shard_metric("http_connections_accepted_total", "counter", "Accepted client connections.", &ShardStats::accepted);
+    shard_metric("http_connection_timeouts_total", "counter", "Connections closed by a timeout.", &ShardStats::timeouts);
+    shard_metric("http_received_bytes_total", "counter", "Bytes read from clients.", &ShardStats::bytes_in);
+    shard_metric("http_sent_bytes_total", "counter", "Bytes written to clients.", &ShardStats::bytes_out);
+
+    writer.declare("db_executor_inflight", "gauge", "Blocking requests queued or running on the DB executor.");
+    writer.sample("db_executor_inflight", "", static_cast<uint64_t>(db_executor_.inflight()));
+    writer.declare("db_executor_rejected_total", "counter", "Blocking requests rejected with 503 (executor full).");
+    writer.sample("db_executor_rejected_total", "", static_cast<uint64_t>(db_executor_.rejected()));
+    HistogramSnapshot snapshot;
+    snapshot.add(db_executor_.queue_wait_us());
+    writer.declare("db_executor_queue_seconds", "histogram", "Time blocking requests wait for a DB executor thread.");
+    writer.histogram("db_executor_queue_seconds", "", snapshot, LATENCY_BOUNDS_US, 1e6);
+    snapshot = HistogramSnapshot();
+    snapshot.add(db_executor_.exec_us());
+    writer.declare("db_executor_exec_seconds", "histogram", "Time to run blocking request handlers.");
+    writer.histogram("db_executor_exec_seconds", "", snapshot, LATENCY_BOUNDS_US, 1e6);
+
+    if (m_memory_users) {
+        const MemoryUserStats users = m_memory_users->GetStats();
+        writer.declare("memory_users", "gauge", "Users held by the in-memory user store.");
+        writer.sample("memory_users", "", users.users);
+        writer.declare("memory_users_log_bytes", "gauge", "Size of the user store append log.");
+        writer.sample("memory_users_log_bytes", "", users.log_bytes);
+        writer.declare("memory_users_compactions_total", "counter", "Snapshots written by the user store.");
+        writer.sample("memory_users_compactions_total", "", users.compactions);
+        writer.declare("memory_users_log_failures_total", "counter", "Registrations rejected because the log write failed.");
+        writer.sample("memory_users_log_failures_total", "", users.log_failures);
+        res.set_content_type(PrometheusWriter::CONTENT_TYPE);
+        return HTTP_CODE::CONTENT_REQUEST;
+    }
+
+    connection_pool* db_pool = connection_pool::GetInstance();
+    writer.declare("db_pool_wait_seconds", "histogram", "Time spent waiting for a pooled DB connection.");
+    for (bool network : {true, false}) {
+        snapshot = HistogramSnapshot();
+        snapshot.add(db_pool->GetWaitHistogram(network));
+        writer.histogram("db_pool_wait_seconds", network ? "thread=\"network\"" : "thread=\"db\"", snapshot,
+                         LATENCY_BOUNDS_US, 1e6);
+    }
+    const PoolStats pool = db_pool->GetStats();
+    writer.declare("db_pool_connections", "gauge", "Pooled DB connections by state.");
+    writer.sample("db_pool_connections", "state=\"in_use\"", static_cast<uint64_t>(pool.in_use));
+    writer.sample("db_pool_connections", "state=\"idle\"", static_cast<uint64_t>(pool.idle));
+    writer.declare("db_pool_waiters", "gauge", "Threads waiting for a pooled DB connection.");
+    writer.sample("db_pool_waiters", "", static_cast<uint64_t>(pool.waiters));
+    writer.declare("db_pool_acquire_timeouts_total", "counter", "Pooled connection requests that timed out.");
+    writer.sample("db_pool_acquire_timeouts_total", "", static_cast<uint64_t>(pool.timeouts));
+    if (m_fake_db) {
+        const FakeDbStats fake = m_fake_db->GetStats();
+        writer.declare("fake_db_queries_total", "counter", "Queries run by the simulated database.");
+        writer.sample("fake_db_queries_total", "", fake.queries);
+        writer.declare("fake_db_failures_total", "counter", "Simulated query failures.");
+        writer.sample("fake_db_failures_total", "", fake.failures);
+    }
+
+    res.set_content_type(PrometheusWriter::CONTENT_TYPE);
+    return HTTP_CODE::CONTENT_REQUEST;
+}
+
+HTTP_CODE WebServer::handle_trace(HttpRequest& req, HttpResponse& res) {
+    (void)req;
+    trace_export::write_chrome_trace(res.get_body());
+    res.set_content_type(trace_export::CONTENT_TYPE);
+    return HTTP_CODE::CONTENT_REQUEST;
+}
+
+UserService& WebServer::batch_layer() {
+    if (m_batcher.enabled()) {
+        return m_batcher;
+    }
+    return *m_service;
+}
+
+UserService& WebServer::cache_layer() {
+    if (options_.auth_cache_capacity > 0) {
+        return m_auth_cache;
+    }
+    return batch_layer();
+}
+
+UserService& WebServer::front_layer() {
+    if (options_.bloom_expected_users > 0) {
+        return m_bloom;
+    }
+    return cache_layer();
+}
+
+// ======================== ConnectionTimers ========================
+
+namespace {
+
+uint64_t to_ticks(int timeout_ms, std::chrono::milliseconds tick) {
+    // 向上取整，超时不会早于配置值（最多晚一个 tick）
+    const int64_t ticks = (static_cast<int64_t>(timeout_ms) + tick.count() - 1) / tick.count();
+    return static_cast<uint64_t>(std::max<int64_t>(1, ticks));
+}
+
+}  // namespace
+
+ConnectionTimers::ConnectionTimers(const asio::any_io_executor& executor, const ServerOptions& options)
+    : timer_(executor),
+      tick_(std::max(1, options.timer_tick_ms)),
+      idle_ticks_(to_ticks(options.idle_timeout_ms, tick_)),
+      header_ticks_(to_ticks(options.header_timeout_ms, tick_)),
+      body_ticks_(to_ticks(options.body_timeout_ms, tick_)),
+      wheel_(now_ticks()) {}
+
+uint64_t ConnectionTimers::now_ticks() const {
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch() / tick_);
+}
+
+void ConnectionTimers::start() {
+    tick();
+}
+
+void ConnectionTimers::stop() {
+    asio::error_code ec;
+    timer_.cancel(ec);
+}
+
+void ConnectionTimers::schedule(Connection& conn, TimerNode& node, http_conn::ReadPhase phase) {
+    const uint64_t ticks = phase == http_conn::ReadPhase::HEADER ? header_ticks_
+                         : phase == http_conn::ReadPhase::BODY   ? body_ticks_
+                                                                 : idle_ticks_;
+    std::lock_guard<std::mutex> lock(mutex_);
+    node.owner = &conn;
+    wheel_.schedule(node, ticks);
+}
+
+void ConnectionTimers::cancel(TimerNode& node) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    wheel_.cancel(node);
+}
+
+bool ConnectionTimers::scheduled(const TimerNode& node) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return node.linked();
+}
+
+void ConnectionTimers::tick() {
+    timer_.expires_after(tick_);
+    auto self = shared_from_this();
+    timer_.async_wait([this, self](std::error_code ec) {
+        if (ec) return;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            wheel_.advance(now_ticks(), [this](TimerNode& node) {
+                // 连接正在析构时拿不到引用，析构函数会自己把节点移出（此时在等待本锁）
+                if (auto conn = static_cast<Connection*>(node.owner)->weak_from_this().lock()) {
+                    expired_.push_back(std::move(conn));
+                }
+            });
+        }
+        // 在锁外通知并释放引用（最后一个引用释放时连接析构，需要再次加锁）
+        for (auto& conn : expired_) {
+            conn->on_timeout();
+        }
+        expired_.clear();
+        tick();
     });
 }
 
 // ======================== Connection ========================
 
-Connection::Connection(tcp::socket socket, const std::string& root, Router& router)
+Connection::Connection(tcp::socket socket, const std::string& root, Router& router, DbExecutor& db_executor,
+                       std::shared_ptr<ShardStats> stats, std::shared_ptr<ConnectionTimers> timers, bool use_sendfile,
+                       size_t max_body)
     : socket_(std::move(socket)),
-      timer_(socket_.get_executor()),
+      timers_(std::move(timers)),
       http_(nullptr, socket_.remote_endpoint(), root),
       m_root(root),
-      router(router) {}
+      router(router),
+      db_executor_(db_executor),
+      stats_(std::move(stats)),
+      use_sendfile_(use_sendfile),
+      max_body_(max_body),
+      log_sampled_(request_log::sample()),
+      trace_id_(RequestTracer::GetInstance()->sample()) {
+    stats_->accepted.fetch_add(1, std::memory_order_relaxed);
+    stats_->active.fetch_add(1, std::memory_order_relaxed);
+}
+
+Connection::~Connection() {
+    timers_->cancel(timer_node_);
+    stats_->active.fetch_sub(1, std::memory_order_relaxed);
+}
 
 void Connection::start() {
     // 初始化 HTTP 处理器
     const asio::ip::tcp::endpoint remote_ep = socket_.remote_endpoint();
+    REQUEST_LOG(log_sampled_, "New client connection from {}:{}", remote_ep.address().to_string(), remote_ep.port());
     http_.init(&socket_, remote_ep, m_root, router);
+    http_.set_sendfile(use_sendfile_);
+    http_.set_max_body(max_body_);
+    if (use_sendfile_) {
+        // sendfile 直接作用于原生套接字，必须保证其为非阻塞
+        asio::error_code ec;
+        socket_.native_non_blocking(true, ec);
+        if (ec) {
+            http_.set_sendfile(false);
+        }
+    }
 
-    reset_timer();
+    arm_timer();
     do_read();
 }
 
@@ -133,7 +644,7 @@ void Connection::do_read() {
             if (ec) {
                 if (ec == asio::error::operation_aborted) return;
                 if (ec == asio::error::eof || ec == asio::error::connection_reset) {
-                    spdlog::info("Client closed connection");
+                    REQUEST_LOG(log_sampled_, "Client closed connection");
                 } else {
                     spdlog::error("Read error: {}", ec.message());
                 }
@@ -141,50 +652,133 @@ void Connection::do_read() {
                 return;
             }
 
+            stats_->bytes_in.fetch_add(length, std::memory_order_relaxed);
+            last_read_ = std::chrono::steady_clock::now();
+            if (http_.read_phase() == http_conn::ReadPhase::IDLE) {
+                request_start_ = last_read_;  // 新请求的第一个字节
+            }
+
             // 累积解析
             http_.append_read_data(buffer_, length);
-            HTTP_CODE read_ret = http_.process_read();
+            process_requests();
+        }
+    );
+}
 
-            if (read_ret == HTTP_CODE::NO_REQUEST) {
-                // 继续读更多数据
-                reset_timer();
-                do_read();
-                return;
-            }
+void Connection::process_requests() {
+    // 依次解析缓冲区中所有完整的（流水线）请求，响应按顺序排队
+    while (http_.pending_count() < MAX_PIPELINE_DEPTH) {
+        const uint64_t trace_start = trace_id_ ? RequestTracer::now_ns() : 0;
+        HTTP_CODE read_ret = http_.process_read();
+        if (read_ret == HTTP_CODE::NO_REQUEST) {
+            break;
+        }
+        if (trace_id_) {
+            trace_request_read(trace_start);
+        }
 
-            // 生成响应
-            const bool write_ok = http_.process_write(read_ret);
-            if (!write_ok) {
-                spdlog::error("Response generation failed");
-                close();
+        if (read_ret == HTTP_CODE::BLOCKING_REQUEST) {
+            // 暂停处理，结果回到本连接的 strand 后从 on_offload_complete 继续；
+            // 请求已收完，执行期间按空闲超时计时
+            timer_phase_ = http_conn::ReadPhase::IDLE;
+            timers_->schedule(*this, timer_node_, timer_phase_);
+            if (offload_request()) {
                 return;
             }
+            read_ret = HTTP_CODE::SERVICE_UNAVAILABLE;
+        }
 
-            spdlog::info("Response ready, start sending");
-            reset_timer();
-            do_write();
+        if (!queue_response(read_ret)) {
+            break;
         }
-    );
+    }
+
+    if (closed) return;
+    flush_responses();
 }
 
-void Connection::do_write() {
-    auto self = shared_from_this();
+bool Connection::queue_response(HTTP_CODE ret) {
+    // 生成响应
+    const bool write_ok = http_.process_write(ret);
+    if (!write_ok) {
+        spdlog::error("Response generation failed");
+        close();
+        return false;
+    }
 
-    // 按顺序发送响应头 + 可选的响应体
-    std::vector<asio::const_buffer> buffers;
-    buffers.reserve(2);
+    MetricsRegistry::local().parse_ns.record(http_.get_parse_ns());
+    const size_t index = http_.pending_count() - 1;
+    if (index < response_meta_.size()) {
+        response_meta_[index] = ResponseMeta{request_start_, http_.get_request().get_route_id(),
+                                             http_.get_last_status(), trace_id_};
+    }
+    // 缓冲区中流水线的下一个请求不晚于最近一次读到达
+    request_start_ = last_read_;
+    trace_id_ = RequestTracer::GetInstance()->sample();
 
-    // 响应头
-    buffers.push_back(asio::buffer(http_.get_write_buffers()));
+    // 非长连接或请求格式错误（无法定位下一个请求）时，发送完已排队的响应后关闭
+    if (!http_.is_keep_alive() || ret == HTTP_CODE::BAD_REQUEST || ret == HTTP_CODE::PAYLOAD_TOO_LARGE) {
+        close_after_write_ = true;
+        return false;
+    }
+    http_.next_request();
+    return true;
+}
 
-    // 响应体
-    if (http_.has_attachment()) {
-        buffers.push_back(asio::buffer(http_.get_attachment_data(),
-                                       http_.get_attachment_size()));
+void Connection::flush_responses() {
+    arm_timer();
+    if (http_.has_pending_response()) {
+        REQUEST_LOG(log_sampled_, "{} response(s) ready, start sending", http_.pending_count());
+        write_start_ = std::chrono::steady_clock::now();
+        do_write();
+    } else {
+        // 继续读更多数据
+        http_.compact_read_buf();
+        do_read();
     }
+}
 
-    asio::async_write(socket_, buffers,
-        [this, self](std::error_code ec, std::size_t) {
+bool Connection::offload_request() {
+    auto self = shared_from_this();
+    // 执行期间连接不发起读写，请求数据（读缓冲区）保持不变
+    const uint64_t trace_id = trace_id_;
+    const uint64_t posted = trace_id ? RequestTracer::now_ns() : 0;
+    return db_executor_.try_post([this, self, trace_id, posted]() {
+        RequestTracer* tracer = RequestTracer::GetInstance();
+        const uint64_t begin = trace_id ? RequestTracer::now_ns() : 0;
+        tracer->record("db_queue", trace_id, posted, begin);
+        HTTP_CODE ret;
+        {
+            // 连接池等待、SQL 执行等记录点通过当前追踪 ID 归属到本请求
+            TraceScope scope(trace_id);
+            ret = http_.run_blocking_handler();
+        }
+        if (trace_id) {
+            tracer->record("handler", trace_id, begin, RequestTracer::now_ns());
+        }
+        asio::post(socket_.get_executor(), [this, self, ret]() {
+            on_offload_complete(ret);
+        });
+    });
+}
+
+void Connection::on_offload_complete(HTTP_CODE ret) {
+    if (closed) return;
+
+    if (!queue_response(http_.complete_request(ret))) {
+        if (closed) return;
+        flush_responses();
+        return;
+    }
+    process_requests();
+}
+
+void Connection::do_write() {
+    auto self = shared_from_this();
+
+    // 排队响应（响应头 + mmap 响应体）聚合写出，遇到 sendfile 响应体时先写到其响应头为止
+    asio::async_write(socket_, http_.get_write_buffers(),
+        [this, self](std::error_code ec, std::size_t length) {
             if (closed) return;
 
             if (ec) {
@@ -194,35 +788,153 @@ void Connection::do_write() {
                 return;
             }
 
-            // 释放 mmap 等资源
-            http_.unmap();
+            stats_->bytes_out.fetch_add(length, std::memory_order_relaxed);
 
-            if (http_.is_keep_alive()) {
-                http_.reset_connection();
-                reset_timer();
-                do_read();
+            if (http_.get_sendfile_response()) {
+                do_sendfile();
             } else {
-                close();
+                on_write_complete();
             }
         }
     );
 }
 
-void Connection::reset_timer() {
-    asio::error_code ec;
-    timer_.cancel(ec);
+void Connection::do_sendfile() {
+    http_conn::PendingResponse* res = http_.get_sendfile_response();
 
-    timer_.expires_after(std::chrono::seconds(60));
-    auto self = shared_from_this();
-    timer_.async_wait([this, self](std::error_code ec2) {
-        if (closed) return;
-        if (ec2 == asio::error::operation_aborted) return; 
-        if (!ec2) {
-            spdlog::info("Client connection timeout, closing");
-            close();
-        } else {
-            spdlog::debug("Timer wait error: {}", ec2.message());
+    // 非阻塞 sendfile，直到套接字发送缓冲区写满
+    while (static_cast<size_t>(res->file_offset) < res->file_size) {
+        const size_t remaining = res->file_size - static_cast<size_t>(res->file_offset);
+        const ssize_t sent = ::sendfile(socket_.native_handle(), res->file_fd, &res->file_offset, remaining);
+        if (sent > 0) {
+            stats_->bytes_out.fetch_add(static_cast<uint64_t>(sent), std::memory_order_relaxed);
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // 等待套接字可写后继续发送
+            auto self = shared_from_this();
+            socket_.async_wait(tcp::socket::wait_write, [this, self](std::error_code ec) {
+                if (closed) return;
+                if (ec) {
+                    if (ec == asio::error::operation_aborted) return;
+                    spdlog::error("Sendfile wait error: {}", ec.message());
+                    close();
+                    return;
+                }
+                do_sendfile();
+            });
+            return;
+        }
+
+        if (sent < 0 && (errno == EINVAL || errno == ENOSYS)) {
+            // 该文件/套接字不支持 sendfile，退回 mmap + async_write
+            asio::const_buffer body;
+            if (!http_.fallback_to_mmap(body)) {
+                spdlog::error("Sendfile fallback to mmap failed");
+                close();
+                return;
+            }
+            auto self = shared_from_this();
+            asio::async_write(socket_, body, [this, self](std::error_code ec, std::size_t length) {
+                if (closed) return;
+                if (ec) {
+                    if (ec == asio::error::operation_aborted) return;
+                    spdlog::error("Send error: {}", ec.message());
+                    close();
+                    return;
+                }
+                stats_->bytes_out.fetch_add(length, std::memory_order_relaxed);
+                on_write_complete();
+            });
+            return;
+        }
+
+        // 文件被截断（sent == 0）或发送出错
+        spdlog::error("Sendfile failed: {}", sent < 0 ? strerror(errno) : "unexpected end of file");
+        close();
+        return;
+    }
+
+    on_write_complete();
+}
+
+void Connection::on_write_complete() {
+    // 还有 sendfile 响应之后的响应未发送
+    if (http_.has_unsent_response()) {
+        do_write();
+        return;
+    }
+
+    stats_->requests.fetch_add(http_.pending_count(), std::memory_order_relaxed);
+    record_responses();
+
+    // 释放 mmap/文件描述符等资源
+    http_.clear_pending();
+
+    if (close_after_write_) {
+        close();
+        return;
+    }
+
+    // 缓冲区中可能还有超出流水线深度而未处理的请求
+    http_.compact_read_buf();
+    process_requests();
+}
+
+void Connection::record_responses() {
+    const auto now = std::chrono::steady_clock::now();
+    ThreadMetrics& metrics = MetricsRegistry::local();
+    metrics.write_us.record(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(now - write_start_).count()));
+    const size_t count = std::min(http_.pending_count(), response_meta_.size());
+    for (size_t i = 0; i < count; ++i) {
+        const ResponseMeta& meta = response_meta_[i];
+        const size_t route = ThreadMetrics::route_slot(meta.route);
+        metrics.requests[route][ThreadMetrics::status_slot(meta.status)].add();
+        metrics.request_us[route].record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(now - meta.start).count()));
+        if (meta.trace_id) {
+            RequestTracer* tracer = RequestTracer::GetInstance();
+            tracer->record("write", meta.trace_id, RequestTracer::to_ns(write_start_), RequestTracer::to_ns(now));
+            tracer->record("request", meta.trace_id, RequestTracer::to_ns(meta.start), RequestTracer::to_ns(now));
         }
+    }
+}
+
+void Connection::trace_request_read(uint64_t t0) {
+    // 解析耗时是本请求所有读操作的累计，不超过本次 process_read 的部分算作这次解析，
+    // 其余为路由分发和（非阻塞）处理函数
+    RequestTracer* tracer = RequestTracer::GetInstance();
+    const uint64_t t1 = RequestTracer::now_ns();
+    const uint64_t parsed = t0 + std::min(http_.get_parse_ns(), t1 - t0);
+    tracer->record("receive", trace_id_, RequestTracer::to_ns(request_start_), t0);
+    tracer->record("parse", trace_id_, t0, parsed);
+    tracer->record("dispatch", trace_id_, parsed, t1);
+}
+
+void Connection::arm_timer() {
+    const http_conn::ReadPhase phase =
+        http_.has_pending_response() ? http_conn::ReadPhase::IDLE : http_.read_phase();
+    if (phase == http_conn::ReadPhase::HEADER && timer_phase_ == phase) {
+        return;
+    }
+    timer_phase_ = phase;
+    timers_->schedule(*this, timer_node_, phase);
+}
+
+void Connection::on_timeout() {
+    auto self = shared_from_this();
+    asio::dispatch(socket_.get_executor(), [this, self]() {
+        // 到期后、关闭前连接又有活动（重新登记了超时）时不关闭
+        if (closed || timers_->scheduled(timer_node_)) return;
+        static constexpr const char* phase_names[] = {"idle", "header", "body"};
+        REQUEST_LOG(log_sampled_, "Client connection {} timeout, closing", phase_names[static_cast<int>(timer_phase_)]);
+        stats_->timeouts.fetch_add(1, std::memory_order_relaxed);
+        close();
     });
 }
 
@@ -230,14 +942,14 @@ void Connection::close() {
     if (closed) return;
     closed = true;
 
+    timers_->cancel(timer_node_);
     asio::error_code ec;
-    timer_.cancel(ec);
     socket_.cancel(ec);
 
     if (socket_.is_open()) {
         socket_.close(ec);
         if (!ec) {
-            spdlog::info("Client socket closed");
+            REQUEST_LOG(log_sampled_, "Client socket closed");
         } else {
             spdlog::error("Close client socket error: {}", ec.message());
         }
@@ -2,74 +2,241 @@
 #define WEBSERVER_H
 
 #include "asio.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
 #include "http_conn.hpp"
 #include "user_service.hpp"
+#include "register_batcher.hpp"
+#include "auth_cache.hpp"
+#include "bloom_user_service.hpp"
+#include "memory_user_service.hpp"
+#include "fake_db_user_service.hpp"
 #include "router.hpp"
 #include "user_controller.hpp"
+#include "server_options.hpp"
+#include "db_executor.hpp"
+#include "timing_wheel.hpp"
+#include "metrics.hpp"
+#include "request_trace.hpp"
 
 using asio::ip::tcp;
 
+// 分片运行统计（由本分片线程写入，统计线程读取）
+struct ShardStats {
+    std::atomic<uint64_t> accepted{0};   // 累计接受连接数
+    std::atomic<uint64_t> active{0};     // 当前活跃连接数
+    std::atomic<uint64_t> requests{0};   // 累计完成请求数
+    std::atomic<uint64_t> bytes_in{0};   // 累计读取字节数
+    std::atomic<uint64_t> bytes_out{0};  // 累计发送字节数
+    std::atomic<uint64_t> timeouts{0};   // 因超时关闭的连接数
+};
+
+class Connection;
+
+// 连接超时的时间轮：分片模式每个分片一个，共享模式按工作线程数分成几份、连接轮流分配。
+// 每 tick 批量取出到期的连接交给各自的执行器关闭；连接登记/刷新超时只在锁内改几个指针，
+// 不分配内存、不投递异步操作（分片模式下锁没有竞争）
+class ConnectionTimers : public std::enable_shared_from_this<ConnectionTimers> {
+public:
+    ConnectionTimers(const asio::any_io_executor& executor, const ServerOptions& options);
+
+    // 启动/停止 tick 定时器
+    void start();
+    void stop();
+
+    // 按读取阶段登记（或刷新）连接的超时
+    void schedule(Connection& conn, TimerNode& node, http_conn::ReadPhase phase);
+    void cancel(TimerNode& node);
+    // 节点仍在时间轮上（到期后又被刷新过）
+    bool scheduled(const TimerNode& node);
+
+private:
+    uint64_t now_ticks() const;
+    void tick();
+
+private:
+    asio::steady_timer timer_;
+    std::chrono::milliseconds tick_;
+    uint64_t idle_ticks_;
+    uint64_t header_ticks_;
+    uint64_t body_ticks_;
+    std::mutex mutex_;
+    TimingWheel wheel_;
+    std::vector<std::shared_ptr<Connection>> expired_;  // 每个 tick 复用
+};
+
+// 分片：独立的事件循环 + 监听套接字
+struct Shard {
+    Shard(int shard_id, const ServerOptions& options)
+        : id(shard_id), stats(std::make_shared<ShardStats>()), io_context(1), acceptor(io_context),
+          timers(std::make_shared<ConnectionTimers>(io_context.get_executor(), options)) {}
+
+    int id;
+    std::shared_ptr<ShardStats> stats;  // 连接持有引用，保证晚于未执行的回调释放
+    asio::io_context io_context;
+    tcp::acceptor acceptor;
+    std::shared_ptr<ConnectionTimers> timers;  // 本分片连接的超时（连接同样持有引用）
+};
+
 class WebServer {
 public:
-    // 初始化服务器核心参数
-    WebServer(asio::io_context& io_context,  
-              int thread_num,
-              const std::string& root);
+    // 初始化服务器核心参数，按 options.user_backend 创建用户服务（内存后端载入失败时抛出 std::runtime_error）
+    WebServer(asio::io_context& io_context, const ServerOptions& options);
+
+    // 使用调用方提供的用户服务（如压测用的模拟后端），options.user_backend 不起作用
+    WebServer(asio::io_context& io_context, const ServerOptions& options, std::unique_ptr<UserService> service);
 
     // 绑定IP和端口并开始监听
     bool listen(const std::string& ip, const std::string& port);
-    
+
     // 启动服务器：运行事件循环线程池
     void run();
 
     ~WebServer() = default;
 
 private:
+    // 打开监听套接字（分片模式下开启 SO_REUSEPORT）
+    bool open_acceptor(tcp::acceptor& acceptor, const tcp::endpoint& endpoint, bool reuse_port);
+
     // 异步接受新连接
-    void accept();
+    void accept(tcp::acceptor& acceptor, const std::shared_ptr<ShardStats>& stats, Shard* shard);
+
+    // 停止所有事件循环
+    void stop();
+
+    // 周期输出各分片的连接/吞吐统计
+    void report_stats();
+
+    // 存活探针：进程能处理请求即返回 200
+    HTTP_CODE handle_healthz(HttpRequest& req, HttpResponse& res);
+
+    // 就绪探针：数据库连接池就绪（建立了足够的连接）后返回 200，否则 503
+    HTTP_CODE handle_readyz(HttpRequest& req, HttpResponse& res);
+
+    // Prometheus 指标：请求指标（各线程汇总）+ 连接、DB 执行器和连接池状态
+    HTTP_CODE handle_metrics(HttpRequest& req, HttpResponse& res);
+
+    // 请求阶段追踪：导出各线程缓冲区中的事件（Chrome Trace 格式）
+    HTTP_CODE handle_trace(HttpRequest& req, HttpResponse& res);
+
+    // 用户服务装饰链：Bloom 过滤器 -> 认证缓存 -> 注册组提交 -> 数据库，关闭的层跳过
+    UserService& batch_layer();
+    UserService& cache_layer();
+    UserService& front_layer();
 
 private:
     asio::io_context& io_context_;  // Asio事件循环上下文
     tcp::acceptor acceptor_;        // TCP连接监听器
-    int thread_num_;                // 线程池大小
+    ServerOptions options_;         // 运行参数
     asio::signal_set signals_;      // 信号处理器（处理终止信号）
-    std::string root_;              // 网页根目录
-    UserServiceMain m_service;
+    asio::steady_timer stats_timer_;   // 统计输出定时器
+    std::vector<std::unique_ptr<Shard>> shards_;  // 分片（仅分片模式）
+    std::shared_ptr<ShardStats> shared_stats_;  // 共享模式下的统计
+    std::vector<std::shared_ptr<ConnectionTimers>> shared_timers_;  // 共享模式下的超时时间轮
+    size_t next_timers_ = 0;                    // 共享模式下新连接分配到的时间轮
+    std::vector<uint64_t> last_requests_;  // 上次统计时各分片的请求数
+    std::unique_ptr<UserService> m_service;  // 用户数据后端
+    MemoryUserService* m_memory_users = nullptr;  // 后端为内存存储时指向 m_service（统计用）
+    FakeDbUserService* m_fake_db = nullptr;       // 后端为假数据库时指向 m_service（统计用）
+    RegisterBatcher m_batcher;        // 装饰 m_service，max_rows 不超过 1 时不使用
+    CachingUserService m_auth_cache;  // 装饰 batch_layer()，容量为 0 时不使用
+    BloomUserService m_bloom;         // 装饰 cache_layer()，预期用户数为 0 时不使用
     UserController m_controller;
     Router m_router;
+    DbExecutor db_executor_;  // 阻塞路由的执行器（最后声明：先于路由和分片析构，等待任务结束）
 };
 
+// 单个连接一次最多排队的流水线响应数
+constexpr size_t MAX_PIPELINE_DEPTH = 32;
+
 // 客户端连接
 class Connection : public std::enable_shared_from_this<Connection> {
 public:
-    Connection(tcp::socket socket, const std::string& root, Router& router);
+    Connection(tcp::socket socket, const std::string& root, Router& router, DbExecutor& db_executor,
+               std::shared_ptr<ShardStats> stats, std::shared_ptr<ConnectionTimers> timers, bool use_sendfile,
+               size_t max_body);
+    ~Connection();
 
     void start();
 
+    // 时间轮报告超时（在时间轮的线程上调用），转到连接自己的执行器上关闭
+    void on_timeout();
+
 private:
     // 异步读取HTTP请求数据
     void do_read();
 
+    // 处理缓冲区中所有完整的请求，有响应则发送，否则继续读取
+    void process_requests();
+
+    // 把响应加入发送队列，返回 false 表示不再处理后续请求（连接将关闭）
+    bool queue_response(HTTP_CODE ret);
+
+    // 发送已排队的响应，没有则继续读取
+    void flush_responses();
+
+    // 把阻塞的处理函数投递到 DB 执行器，执行器已满时返回 false
+    bool offload_request();
+
+    // 阻塞的处理函数执行完毕（在本连接的 strand 上执行），继续处理后续请求
+    void on_offload_complete(HTTP_CODE ret);
+
     // 异步发送HTTP响应数据
     void do_write();
 
-    // 重置超时定时器（延长超时时间）
-    void reset_timer();
+    // 使用 sendfile 发送文件响应体（套接字不可写时挂起等待）
+    void do_sendfile();
+
+    // 一批响应发送完成：释放资源，继续处理后续请求
+    void on_write_complete();
+
+    // 记录这批响应的请求数、请求耗时和发送耗时
+    void record_responses();
+
+    // 被追踪的请求解析完成（process_read 返回）：记录接收、解析和分发阶段，t0 为 process_read 开始的时间
+    void trace_request_read(uint64_t t0);
+
+    // 按当前读取阶段登记超时：发送响应和两个请求之间为空闲超时，
+    // 请求头从第一个字节起计时（不因后续数据延长），请求体每次读取后刷新
+    void arm_timer();
 
     // 关闭连接（释放资源）
     void close();
 
 private:
     tcp::socket socket_;            // 客户端TCP套接字
-    asio::steady_timer timer_;      // 连接超时定时器
+    std::shared_ptr<ConnectionTimers> timers_;  // 所属的超时时间轮
+    TimerNode timer_node_;          // 在时间轮上的节点
+    http_conn::ReadPhase timer_phase_ = http_conn::ReadPhase::IDLE;  // 当前超时对应的读取阶段
     http_conn http_;                // HTTP请求处理对象
     char buffer_[4096];             // 数据读取缓冲区
     std::string m_root;
-    bool closed = false;            
-    Router router;
+    bool closed = false;
+    bool close_after_write_ = false;  // 响应发送完毕后关闭连接
+    Router& router;
+    DbExecutor& db_executor_;        // 阻塞处理函数的执行器
+    std::shared_ptr<ShardStats> stats_;  // 所属分片的统计
+    bool use_sendfile_;             // 文件响应体使用 sendfile 发送
+    size_t max_body_;               // 请求体上限
+    const bool log_sampled_;        // 本连接的请求日志是否被采样记录
+
+    // 已排队响应的指标信息，下标与 http_ 中排队的响应一致
+    struct ResponseMeta {
+        std::chrono::steady_clock::time_point start;
+        uint16_t route;
+        int status;
+        uint64_t trace_id;  // 未被追踪时为 0
+    };
+    std::array<ResponseMeta, MAX_PIPELINE_DEPTH> response_meta_{};
+    std::chrono::steady_clock::time_point last_read_;      // 最近一次读到数据的时间
+    std::chrono::steady_clock::time_point request_start_;  // 当前请求第一个字节到达的时间（按所在的读操作计）
+    std::chrono::steady_clock::time_point write_start_;    // 当前这批响应开始发送的时间
+    uint64_t trace_id_ = 0;  // 当前（下一个）请求的追踪 ID，未被采样时为 0
 };
 
 #endif
@@ -0,0 +1,29 @@
+#ifndef TESTS_CHECK_H
+#define TESTS_CHECK_H
+
+#include <cstdio>
+
+// 单元测试用的最小断言：失败时打印位置并计数，不中断后续检查；
+// main 返回 check_result()，ctest 按非 0 退出码判定失败
+inline int& check_failures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond)                                                               \
+    do {                                                                          \
+        if (!(cond)) {                                                            \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            ++check_failures();                                                   \
+        }                                                                         \
+    } while (0)
+
+inline int check_result() {
+    if (check_failures() != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", check_failures());
+        return 1;
+    }
+    return 0;
+}
+
+#endif
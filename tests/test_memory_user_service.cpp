@@ -0,0 +1,193 @@
+// MemoryUserService 单元测试：重放末尾不完整的日志，快照和日志中重复的用户，损坏的快照
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unistd.h>
+#include "check.hpp"
+#include "memory_user_service.hpp"
+
+namespace {
+
+namespace fs = std::filesystem;
+
+std::string read_all(const fs::path& file) {
+    std::ifstream in(file, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void write_all(const fs::path& file, const std::string& data) {
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+// 每个用例一个临时目录，析构时删除
+struct TempDir {
+    fs::path dir;
+
+    explicit TempDir(const char* name) {
+        dir = fs::temp_directory_path() / ("memory_user_test_" + std::string(name) + "_" + std::to_string(::getpid()));
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+    }
+    ~TempDir() {
+        std::error_code ec;
+        fs::remove_all(dir, ec);
+    }
+
+    MemoryUserOptions options() const {
+        MemoryUserOptions options;
+        options.path = (dir / "users").string();
+        options.expected_users = 16;
+        options.compact_log_bytes = 0;  // 压缩由用例显式调用
+        return options;
+    }
+    fs::path log() const { return dir / "users.log"; }
+    fs::path snapshot() const { return dir / "users.snap"; }
+};
+
+bool registered(MemoryUserService& service, const std::string& username, const std::string& password) {
+    return service.registerUser(registerRequest{username, password}).success;
+}
+
+bool can_login(MemoryUserService& service, const std::string& username, const std::string& password) {
+    return service.login(loginRequest{username, password}).success;
+}
+
+void test_log_replay() {
+    TempDir tmp("replay");
+    {
+        MemoryUserService service(tmp.options());
+        CHECK(service.load());
+        CHECK(registered(service, "alice", "pw1"));
+        CHECK(registered(service, "bob", "pw2"));
+        CHECK(!registered(service, "alice", "other"));
+        CHECK(service.GetStats().users == 2);
+    }
+    MemoryUserService service(tmp.options());
+    CHECK(service.load());
+    CHECK(service.GetStats().users == 2);
+    CHECK(can_login(service, "alice", "pw1"));
+    CHECK(can_login(service, "bob", "pw2"));
+    CHECK(!can_login(service, "alice", "pw2"));
+    CHECK(!registered(service, "bob", "again"));
+}
+
+// 写日志到一半时崩溃：截断在最后一条记录中间，重放保留之前的记录并截掉残片，之后的注册可以正常追加
+void test_torn_log_tail() {
+    TempDir tmp("torn");
+    size_t first_record = 0;
+    {
+        MemoryUserService service(tmp.options());
+        CHECK(service.load());
+        CHECK(registered(service, "alice", "pw1"));
+        first_record = static_cast<size_t>(fs::file_size(tmp.log()));
+        CHECK(registered(service, "bob", "pw2"));
+    }
+    const std::string log = read_all(tmp.log());
+    CHECK(log.size() > first_record + 3);
+    write_all(tmp.log(), log.substr(0, log.size() - 3));
+    {
+        MemoryUserService service(tmp.options());
+        CHECK(service.load());
+        CHECK(service.GetStats().users == 1);
+        CHECK(service.GetStats().log_bytes == first_record);
+        CHECK(can_login(service, "alice", "pw1"));
+        CHECK(!can_login(service, "bob", "pw2"));
+        CHECK(registered(service, "carol", "pw3"));
+    }
+    // 末尾是校验和不匹配的垃圾数据：同样截掉
+    {
+        std::ofstream out(tmp.log(), std::ios::binary | std::ios::app);
+        out.write("\x05\x00\x03\x00garbage-bytes", 17);
+    }
+    MemoryUserService service(tmp.options());
+    CHECK(service.load());
+    CHECK(service.GetStats().users == 2);
+    CHECK(can_login(service, "alice", "pw1"));
+    CHECK(can_login(service, "carol", "pw3"));
+    CHECK(registered(service, "dave", "pw4"));
+    CHECK(can_login(service, "dave", "pw4"));
+}
+
+// 写完快照、去掉日志前缀之前崩溃：同一用户同时在快照和日志中，只计一次，以快照为准
+void test_duplicates_in_snapshot_and_log() {
+    TempDir tmp("dup");
+    std::string old_log;
+    {
+        MemoryUserService service(tmp.options());
+        CHECK(service.load());
+        CHECK(registered(service, "alice", "pw1"));
+        CHECK(registered(service, "bob", "pw2"));
+        old_log = read_all(tmp.log());
+        CHECK(service.compact());
+        CHECK(service.GetStats().log_bytes == 0);
+        CHECK(registered(service, "carol", "pw3"));
+    }
+    // 把压缩前的日志放回快照之后的日志前面
+    write_all(tmp.log(), old_log + read_all(tmp.log()));
+    {
+        MemoryUserService service(tmp.options());
+        CHECK(service.load());
+        CHECK(service.GetStats().users == 3);
+        CHECK(can_login(service, "alice", "pw1"));
+        CHECK(can_login(service, "bob", "pw2"));
+        CHECK(can_login(service, "carol", "pw3"));
+        CHECK(!registered(service, "alice", "pw1"));
+
+        size_t names = 0;
+        CHECK(service.scanUsernames([&names](std::string_view) { ++names; }));
+        CHECK(names == 3);
+
+        // 再次压缩后重复记录消失
+        CHECK(service.compact());
+    }
+    MemoryUserService service(tmp.options());
+    CHECK(service.load());
+    CHECK(service.GetStats().users == 3);
+    CHECK(service.GetStats().log_bytes == 0);
+}
+
+// 快照损坏（头部用户数超出文件能容纳的记录数、记录被截断）时拒绝启动，而不是丢掉用户继续运行
+void test_corrupted_snapshot() {
+    TempDir tmp("corrupt");
+    {
+        MemoryUserService service(tmp.options());
+        CHECK(service.load());
+        CHECK(registered(service, "alice", "pw1"));
+        CHECK(service.compact());
+    }
+    const std::string snapshot = read_all(tmp.snapshot());
+
+    std::string huge_count = snapshot;
+    const uint64_t count = ~uint64_t{0};
+    huge_count.replace(8, sizeof(count), reinterpret_cast<const char*>(&count), sizeof(count));
+    write_all(tmp.snapshot(), huge_count);
+    {
+        MemoryUserService service(tmp.options());
+        CHECK(!service.load());
+    }
+
+    write_all(tmp.snapshot(), snapshot.substr(0, snapshot.size() - 1));
+    {
+        MemoryUserService service(tmp.options());
+        CHECK(!service.load());
+    }
+
+    write_all(tmp.snapshot(), snapshot);
+    MemoryUserService service(tmp.options());
+    CHECK(service.load());
+    CHECK(can_login(service, "alice", "pw1"));
+}
+
+}  // namespace
+
+int main() {
+    test_log_replay();
+    test_torn_log_tail();
+    test_duplicates_in_snapshot_and_log();
+    test_corrupted_snapshot();
+    return check_result();
+}
@@ -0,0 +1,131 @@
+// HttpParser 单元测试：流水线请求、分多次到达的请求头、超限和回绕的 Content-Length
+#include <string>
+#include <string_view>
+#include "check.hpp"
+#include "http_parser.hpp"
+
+namespace {
+
+// 一个连接上的解析状态，与 http_conn 的 next_request 一致：成功后从 start_line 继续解析下一个请求
+struct ParseState {
+    HttpRequest req;
+    CHECK_STATE state = CHECK_STATE::CHECK_STATE_REQUESTLINE;
+    size_t checked_idx = 0;
+    size_t start_line = 0;
+
+    PARSE_STATUS parse(std::string_view buf, size_t max_content_length = HttpParser::DEFAULT_MAX_CONTENT_LENGTH) {
+        return HttpParser::parse(buf, req, state, checked_idx, start_line, max_content_length);
+    }
+
+    void next() {
+        req = HttpRequest();
+        state = CHECK_STATE::CHECK_STATE_REQUESTLINE;
+        checked_idx = start_line;
+    }
+};
+
+void test_single_get() {
+    const std::string buf = "GET /index.html HTTP/1.1\r\nHost: example.com\r\nConnection: keep-alive\r\n\r\n";
+    ParseState p;
+    CHECK(p.parse(buf) == PARSE_STATUS::SUCCESS);
+    CHECK(p.req.get_method() == HttpRequest::METHOD::GET);
+    CHECK(p.req.get_url() == "/index.html");
+    CHECK(p.req.get_version() == "HTTP/1.1");
+    CHECK(p.req.find_header("host") == "example.com");
+    CHECK(p.req.is_keep_alive());
+    CHECK(p.start_line == buf.size());
+}
+
+// 一次读到三个请求（其中一个带报文体），依次解析，报文体不能被当成下一个请求
+void test_pipelined() {
+    const std::string first = "GET /a HTTP/1.1\r\nHost: x\r\n\r\n";
+    const std::string second = "POST /b HTTP/1.1\r\nHost: x\r\nContent-Length: 11\r\n\r\nGET /c HTTP";
+    const std::string third = "GET /d HTTP/1.1\r\nHost: x\r\n\r\n";
+    const std::string buf = first + second + third;
+
+    ParseState p;
+    CHECK(p.parse(buf) == PARSE_STATUS::SUCCESS);
+    CHECK(p.req.get_url() == "/a");
+    CHECK(p.start_line == first.size());
+
+    p.next();
+    CHECK(p.parse(buf) == PARSE_STATUS::SUCCESS);
+    CHECK(p.req.get_method() == HttpRequest::METHOD::POST);
+    CHECK(p.req.get_url() == "/b");
+    CHECK(p.req.get_content() == "GET /c HTTP");
+    CHECK(p.start_line == first.size() + second.size());
+
+    p.next();
+    CHECK(p.parse(buf) == PARSE_STATUS::SUCCESS);
+    CHECK(p.req.get_url() == "/d");
+    CHECK(p.start_line == buf.size());
+
+    // 缓冲区已耗尽：下一个请求尚未到达
+    p.next();
+    CHECK(p.parse(buf) == PARSE_STATUS::INCOMPLETE);
+}
+
+// 请求按字节逐次到达（"\r\n" 被拆在两次读取之间），之前都是 INCOMPLETE，最后一次的结果与一次读完相同
+void test_split_headers() {
+    const std::string buf =
+        "POST /welcome HTTP/1.1\r\nHost: x\r\nContent-Type: application/x-www-form-urlencoded\r\n"
+        "Content-Length: 9\r\n\r\nuser=a&pw";
+    ParseState p;
+    for (size_t len = 1; len < buf.size(); ++len) {
+        CHECK(p.parse(std::string_view(buf).substr(0, len)) == PARSE_STATUS::INCOMPLETE);
+    }
+    CHECK(p.parse(buf) == PARSE_STATUS::SUCCESS);
+    CHECK(p.req.get_url() == "/welcome");
+    CHECK(p.req.get_header_count() == 3);
+    CHECK(p.req.find_header("Content-Type") == "application/x-www-form-urlencoded");
+    CHECK(p.req.get_content() == "user=a&pw");
+    CHECK(p.start_line == buf.size());
+}
+
+void test_content_length_limit() {
+    const std::string head = "POST /upload HTTP/1.1\r\nHost: x\r\nContent-Length: ";
+
+    // 超过上限：不等待报文体，直接 TOO_LARGE
+    {
+        ParseState p;
+        CHECK(p.parse(head + "101\r\n\r\n", 100) == PARSE_STATUS::TOO_LARGE);
+    }
+    // 恰好等于上限：正常等待报文体
+    {
+        ParseState p;
+        CHECK(p.parse(head + "100\r\n\r\n", 100) == PARSE_STATUS::INCOMPLETE);
+        CHECK(p.parse(head + "100\r\n\r\n" + std::string(100, 'a'), 100) == PARSE_STATUS::SUCCESS);
+        CHECK(p.req.get_content().size() == 100);
+    }
+    // body_start + 长度会回绕：必须拒绝，而不是把请求当成已完整、把 start_line 指回缓冲区开头
+    {
+        ParseState p;
+        CHECK(p.parse(head + "18446744073709551615\r\n\r\n") == PARSE_STATUS::TOO_LARGE);
+        CHECK(p.start_line == 0);
+    }
+    // 超出 size_t 范围和非数字的长度是格式错误
+    {
+        ParseState p;
+        CHECK(p.parse(head + "99999999999999999999999\r\n\r\n") == PARSE_STATUS::ERROR);
+    }
+    {
+        ParseState p;
+        CHECK(p.parse(head + "12abc\r\n\r\n") == PARSE_STATUS::ERROR);
+    }
+}
+
+void test_malformed() {
+    ParseState p;
+    CHECK(p.parse("GET\r\n\r\n") == PARSE_STATUS::ERROR);
+}
+
+}  // namespace
+
+int main() {
+    test_single_get();
+    test_pipelined();
+    test_split_headers();
+    test_content_length_limit();
+    test_malformed();
+    return check_result();
+}
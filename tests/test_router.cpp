@@ -0,0 +1,183 @@
+// Router 单元测试：静态、参数和通配路由的匹配与优先级，方法不匹配时的 405 和 Allow
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "check.hpp"
+#include "router.hpp"
+
+namespace {
+
+using METHOD = HttpRequest::METHOD;
+
+// 处理函数把自己的编号写入响应体，用来区分匹配到的路由
+template <int Id>
+HTTP_CODE mark(void*, HttpRequest&, HttpResponse& res) {
+    res.set_body(std::to_string(Id));
+    return HTTP_CODE::CONTENT_REQUEST;
+}
+
+template <int Id>
+RouteHandler handler() {
+    return RouteHandler{&mark<Id>, nullptr};
+}
+
+struct Result {
+    HTTP_CODE code;
+    std::string body;
+};
+
+Result dispatch(const Router& router, HttpRequest& req, METHOD method, std::string_view url) {
+    req = HttpRequest();
+    req.set_method(method);
+    req.set_url(url);
+    HttpResponse res;
+    const HTTP_CODE code = router.dispatch(req, res);
+    return Result{code, res.get_body()};
+}
+
+void test_static_routes() {
+    Router router;
+    router.register_route(METHOD::GET, "/", handler<1>());
+    router.register_route(METHOD::GET, "/users", handler<2>());
+    router.register_route(METHOD::GET, "/user", handler<3>());        // 与 "/users" 共享前缀，拆分节点
+    router.register_route(METHOD::GET, "/about/team", handler<4>());
+
+    HttpRequest req;
+    CHECK(dispatch(router, req, METHOD::GET, "/").body == "1");
+    CHECK(dispatch(router, req, METHOD::GET, "/users").body == "2");
+    CHECK(dispatch(router, req, METHOD::GET, "/user").body == "3");
+    CHECK(dispatch(router, req, METHOD::GET, "/about/team?x=1").body == "4");  // 查询串不参与匹配
+    CHECK(dispatch(router, req, METHOD::GET, "/use").code == HTTP_CODE::NO_RESOURCE);
+    CHECK(dispatch(router, req, METHOD::GET, "/users/1").code == HTTP_CODE::NO_RESOURCE);
+    CHECK(dispatch(router, req, METHOD::GET, "/about").code == HTTP_CODE::NO_RESOURCE);
+
+    // 路由编号从 1 开始按注册顺序分配
+    dispatch(router, req, METHOD::GET, "/user");
+    CHECK(req.get_route_id() == 3);
+    CHECK(router.route_names()[3] == "GET /user");
+}
+
+void test_param_routes() {
+    Router router;
+    router.register_route(METHOD::GET, "/users/:id", handler<1>());
+    router.register_route(METHOD::GET, "/users/:id/posts/:post", handler<2>());
+    router.register_route(METHOD::GET, "/users/me", handler<3>());
+
+    HttpRequest req;
+    Result r = dispatch(router, req, METHOD::GET, "/users/42");
+    CHECK(r.body == "1");
+    CHECK(req.find_param("id") == "42");
+
+    r = dispatch(router, req, METHOD::GET, "/users/7/posts/hello");
+    CHECK(r.body == "2");
+    CHECK(req.get_param_count() == 2);
+    CHECK(req.find_param("id") == "7");
+    CHECK(req.find_param("post") == "hello");
+
+    // 静态片段优先于参数段
+    r = dispatch(router, req, METHOD::GET, "/users/me");
+    CHECK(r.body == "3");
+    CHECK(req.get_param_count() == 0);
+
+    // "/users/me/posts/1" 在静态分支匹配失败，回溯到参数段，参数不残留
+    r = dispatch(router, req, METHOD::GET, "/users/me/posts/1");
+    CHECK(r.body == "2");
+    CHECK(req.get_param_count() == 2);
+    CHECK(req.find_param("id") == "me");
+
+    CHECK(dispatch(router, req, METHOD::GET, "/users/").code == HTTP_CODE::NO_RESOURCE);  // 参数段不能为空
+    CHECK(dispatch(router, req, METHOD::GET, "/users/1/posts").code == HTTP_CODE::NO_RESOURCE);
+}
+
+void test_wildcard_routes() {
+    Router router;
+    router.register_route(METHOD::GET, "/static/*path", handler<1>());
+    router.register_route(METHOD::GET, "/static/index.html", handler<2>());
+    router.register_route(METHOD::GET, "/files/:name", handler<3>());
+    router.register_route(METHOD::GET, "/files/*rest", handler<4>());
+
+    HttpRequest req;
+    Result r = dispatch(router, req, METHOD::GET, "/static/css/site.css");
+    CHECK(r.body == "1");
+    CHECK(req.find_param("path") == "css/site.css");
+
+    CHECK(dispatch(router, req, METHOD::GET, "/static/index.html").body == "2");  // 静态优先于通配
+
+    r = dispatch(router, req, METHOD::GET, "/static/");
+    CHECK(r.body == "1");
+    CHECK(req.get_param_count() == 1);
+    CHECK(req.find_param("path").empty());
+
+    // 参数段优先于通配，多段路径落到通配
+    r = dispatch(router, req, METHOD::GET, "/files/a.txt");
+    CHECK(r.body == "3");
+    CHECK(req.find_param("name") == "a.txt");
+    r = dispatch(router, req, METHOD::GET, "/files/a/b.txt");
+    CHECK(r.body == "4");
+    CHECK(req.get_param_count() == 1);
+    CHECK(req.find_param("rest") == "a/b.txt");
+}
+
+void test_method_not_allowed() {
+    Router router;
+    router.register_route(METHOD::GET, "/items/:id", handler<1>());
+    router.register_route(METHOD::DELETE, "/items/:id", handler<2>());
+    router.register_route(METHOD::POST, "/items", handler<3>());
+    router.register_route("/any", handler<4>());
+
+    HttpRequest req;
+    CHECK(dispatch(router, req, METHOD::GET, "/items/1").body == "1");
+    CHECK(dispatch(router, req, METHOD::DELETE, "/items/1").body == "2");
+
+    CHECK(dispatch(router, req, METHOD::PUT, "/items/1").code == HTTP_CODE::METHOD_NOT_ALLOWED);
+    CHECK(req.get_allowed_methods() == "GET, DELETE");
+    CHECK(dispatch(router, req, METHOD::GET, "/items").code == HTTP_CODE::METHOD_NOT_ALLOWED);
+    CHECK(req.get_allowed_methods() == "POST");
+
+    // 不限方法的路由匹配任意方法
+    CHECK(dispatch(router, req, METHOD::POST, "/any").body == "4");
+    CHECK(dispatch(router, req, METHOD::HEAD, "/any").body == "4");
+
+    // 路径不存在仍是 404
+    CHECK(dispatch(router, req, METHOD::PUT, "/nothing").code == HTTP_CODE::NO_RESOURCE);
+}
+
+void test_invalid_routes() {
+    Router router;
+    router.register_route(METHOD::GET, "/a/:id", handler<1>());
+
+    bool threw = false;
+    try {
+        router.register_route(METHOD::GET, "/a/:name/x", handler<2>());
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    threw = false;
+    try {
+        router.register_route(METHOD::GET, "/b/*rest/x", handler<2>());
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    threw = false;
+    try {
+        router.register_route(METHOD::GET, "no-slash", handler<2>());
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+}  // namespace
+
+int main() {
+    test_static_routes();
+    test_param_routes();
+    test_wildcard_routes();
+    test_method_not_allowed();
+    test_invalid_routes();
+    return check_result();
+}
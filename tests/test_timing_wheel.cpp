@@ -0,0 +1,181 @@
+// TimingWheel 单元测试：登记、刷新、取消，以及跨层下放后按时到期
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "check.hpp"
+#include "timing_wheel.hpp"
+
+namespace {
+
+struct Timer {
+    TimerNode node;
+    uint64_t fired_at = 0;
+    int fired = 0;
+};
+
+// 推进到 tick now，记录每个定时器的到期 tick
+void advance(TimingWheel& wheel, uint64_t now) {
+    wheel.advance(now, [&wheel](TimerNode& node) {
+        Timer* timer = static_cast<Timer*>(node.owner);
+        timer->fired_at = wheel.now();
+        ++timer->fired;
+    });
+}
+
+void test_schedule() {
+    TimingWheel wheel;
+    Timer a, b, c;
+    a.node.owner = &a;
+    b.node.owner = &b;
+    c.node.owner = &c;
+    wheel.schedule(a.node, 1);
+    wheel.schedule(b.node, 10);
+    wheel.schedule(c.node, 0);  // 0 按 1 个 tick 处理
+    CHECK(a.node.linked());
+
+    advance(wheel, 1);
+    CHECK(a.fired == 1 && a.fired_at == 1);
+    CHECK(c.fired == 1 && c.fired_at == 1);
+    CHECK(!a.node.linked());
+    CHECK(b.fired == 0);
+
+    advance(wheel, 9);
+    CHECK(b.fired == 0);
+    advance(wheel, 10);
+    CHECK(b.fired == 1 && b.fired_at == 10);
+
+    // 已到期的节点不会再次触发
+    advance(wheel, 100);
+    CHECK(a.fired == 1 && b.fired == 1 && c.fired == 1);
+}
+
+void test_refresh() {
+    TimingWheel wheel;
+    Timer t;
+    t.node.owner = &t;
+
+    // 延后：节点留在原槽位，到原时间时重新放置，在新时间到期
+    wheel.schedule(t.node, 5);
+    advance(wheel, 3);
+    wheel.schedule(t.node, 5);  // 到期时间改为 8
+    advance(wheel, 7);
+    CHECK(t.fired == 0);
+    CHECK(t.node.linked());
+    advance(wheel, 8);
+    CHECK(t.fired == 1 && t.fired_at == 8);
+
+    // 提前：从原槽位移出并按新时间放置
+    wheel.schedule(t.node, 1000);
+    wheel.schedule(t.node, 2);
+    advance(wheel, 10);
+    CHECK(t.fired == 2 && t.fired_at == 10);
+    advance(wheel, 2000);
+    CHECK(t.fired == 2);
+}
+
+void test_cancel() {
+    TimingWheel wheel;
+    Timer a, b;
+    a.node.owner = &a;
+    b.node.owner = &b;
+    wheel.schedule(a.node, 3);
+    wheel.schedule(b.node, 3);
+    wheel.cancel(a.node);
+    CHECK(!a.node.linked());
+    wheel.cancel(a.node);  // 重复取消无影响
+
+    advance(wheel, 10);
+    CHECK(a.fired == 0);
+    CHECK(b.fired == 1 && b.fired_at == 3);
+
+    // 取消后可以重新登记
+    wheel.schedule(a.node, 4);
+    advance(wheel, 14);
+    CHECK(a.fired == 1 && a.fired_at == 14);
+}
+
+// 超过一层范围的定时器经上层槽位逐层下放，仍在准确的 tick 到期
+void test_cascade() {
+    const uint64_t start = 12345;  // 不从槽位边界开始
+    TimingWheel wheel(start);
+    const uint64_t delays[] = {
+        TimingWheel::SLOTS - 1,
+        TimingWheel::SLOTS,
+        TimingWheel::SLOTS + 1,
+        uint64_t{TimingWheel::SLOTS} * TimingWheel::SLOTS - 1,
+        uint64_t{TimingWheel::SLOTS} * TimingWheel::SLOTS,
+        uint64_t{TimingWheel::SLOTS} * TimingWheel::SLOTS * 3 + 17,
+        TimingWheel::MAX_TICKS,
+    };
+    std::vector<Timer> timers(sizeof(delays) / sizeof(delays[0]));
+    for (size_t i = 0; i < timers.size(); ++i) {
+        timers[i].node.owner = &timers[i];
+        wheel.schedule(timers[i].node, delays[i]);
+    }
+    // 超过上限的超时按上限处理
+    Timer capped;
+    capped.node.owner = &capped;
+    wheel.schedule(capped.node, TimingWheel::MAX_TICKS * 2);
+
+    advance(wheel, start + TimingWheel::MAX_TICKS);
+    for (size_t i = 0; i < timers.size(); ++i) {
+        CHECK(timers[i].fired == 1);
+        CHECK(timers[i].fired_at == start + delays[i]);
+    }
+    CHECK(capped.fired == 1 && capped.fired_at == start + TimingWheel::MAX_TICKS);
+}
+
+// 随机登记/刷新/取消，与逐个记录到期时间的参照结果对比
+void test_random() {
+    std::mt19937_64 rng(42);
+    TimingWheel wheel;
+    std::vector<Timer> timers(500);
+    std::vector<uint64_t> expected(timers.size(), 0);  // 0 为未登记
+    for (Timer& t : timers) {
+        t.node.owner = &t;
+    }
+
+    bool ok = true;
+    for (uint64_t step = 0; step < 20000; ++step) {
+        const size_t i = rng() % timers.size();
+        switch (rng() % 4) {
+            case 0:
+            case 1: {
+                const uint64_t ticks = 1 + rng() % (rng() % 2 ? 100 : 20000);
+                wheel.schedule(timers[i].node, ticks);
+                expected[i] = wheel.now() + ticks;
+                break;
+            }
+            case 2:
+                wheel.cancel(timers[i].node);
+                expected[i] = 0;
+                break;
+            default:
+                break;
+        }
+
+        const uint64_t now = wheel.now() + 1 + rng() % 8;
+        wheel.advance(now, [&](TimerNode& node) {
+            Timer* timer = static_cast<Timer*>(node.owner);
+            const size_t idx = static_cast<size_t>(timer - timers.data());
+            if (expected[idx] != wheel.now()) ok = false;
+            expected[idx] = 0;
+        });
+        for (size_t k = 0; k < timers.size(); ++k) {
+            if (expected[k] != 0 && expected[k] <= now) ok = false;  // 到期未触发
+            if ((expected[k] != 0) != timers[k].node.linked()) ok = false;
+        }
+    }
+    CHECK(ok);
+}
+
+}  // namespace
+
+int main() {
+    test_schedule();
+    test_refresh();
+    test_cancel();
+    test_cascade();
+    test_random();
+    return check_result();
+}
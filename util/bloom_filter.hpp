@@ -0,0 +1,91 @@
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string_view>
+
+// 并发 Bloom 过滤器：位数组由原子字组成，add 为 fetch_or、查询为普通原子读，不加锁。
+// 按预期元素数和目标误判率确定位数 m 与哈希函数个数 k；k 个位置由一个 64 位哈希
+// 双重散列得到（h1 + i * h2）。只能判断"一定不存在"或"可能存在"，不支持删除
+class BloomFilter {
+public:
+    BloomFilter(size_t expected_items, double false_positive_rate) {
+        const double n = static_cast<double>(expected_items > 0 ? expected_items : 1);
+        const double p = false_positive_rate > 0 && false_positive_rate < 1 ? false_positive_rate : 0.01;
+        const double ln2 = std::log(2.0);
+        const double bits = std::ceil(-n * std::log(p) / (ln2 * ln2));
+        words_ = (static_cast<size_t>(bits) + 63) / 64;
+        bits_ = words_ * 64;
+        hashes_ = static_cast<unsigned>(std::max(1.0, std::round(static_cast<double>(bits_) / n * ln2)));
+        data_ = std::make_unique<std::atomic<uint64_t>[]>(words_);
+        for (size_t i = 0; i < words_; ++i) {
+            data_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // 加入一个元素；有新置位时计入元素数（重复加入不计数，用于估算误判率）
+    void add(std::string_view key) {
+        uint64_t h1, h2;
+        hash(key, h1, h2);
+        bool added = false;
+        for (unsigned i = 0; i < hashes_; ++i) {
+            const size_t bit = static_cast<size_t>((h1 + i * h2) % bits_);
+            const uint64_t mask = uint64_t{1} << (bit % 64);
+            if (!(data_[bit / 64].fetch_or(mask, std::memory_order_relaxed) & mask)) {
+                added = true;
+            }
+        }
+        if (added) {
+            items_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // false 表示一定不存在
+    bool maybe_contains(std::string_view key) const {
+        uint64_t h1, h2;
+        hash(key, h1, h2);
+        for (unsigned i = 0; i < hashes_; ++i) {
+            const size_t bit = static_cast<size_t>((h1 + i * h2) % bits_);
+            if (!(data_[bit / 64].load(std::memory_order_relaxed) & (uint64_t{1} << (bit % 64)))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t memory_bytes() const { return words_ * sizeof(uint64_t); }
+    size_t bit_count() const { return bits_; }
+    unsigned hash_count() const { return hashes_; }
+    uint64_t item_count() const { return items_.load(std::memory_order_relaxed); }
+
+    // 按当前元素数估算的误判率：(1 - e^(-kn/m))^k
+    double estimated_false_positive_rate() const {
+        const double k = static_cast<double>(hashes_);
+        const double n = static_cast<double>(item_count());
+        return std::pow(1.0 - std::exp(-k * n / static_cast<double>(bits_)), k);
+    }
+
+private:
+    static void hash(std::string_view key, uint64_t& h1, uint64_t& h2) {
+        h1 = std::hash<std::string_view>{}(key);
+        // splitmix64 终结函数得到第二个独立的哈希，奇数保证遍历不退化
+        uint64_t x = h1 + 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        h2 = (x ^ (x >> 31)) | 1;
+    }
+
+    size_t words_;
+    size_t bits_;
+    unsigned hashes_;
+    std::unique_ptr<std::atomic<uint64_t>[]> data_;
+    std::atomic<uint64_t> items_{0};
+};
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef DB_LATENCY_H
+#define DB_LATENCY_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+
+// 模拟数据库操作的耗时分布（微秒）和失败率，供假数据库后端和基准使用
+struct DbLatency {
+    enum class Kind {
+        FIXED,      // 固定耗时 median_us
+        LOGNORMAL,  // 对数正态：中位数 median_us，对数标准差 sigma（0.5 时 p99 约为中位数的 3.2 倍）
+        SPIKE       // 平时固定 median_us，以 spike_rate 的概率耗时 spike_us（锁等待、刷盘、GC 等长尾）
+    };
+
+    Kind kind = Kind::FIXED;
+    double median_us = 0;
+    double sigma = 0;
+    double spike_rate = 0;
+    double spike_us = 0;
+    double failure_rate = 0;  // 操作失败的概率（失败前同样耗费采样到的时间）
+
+    static DbLatency fixed(double us) {
+        DbLatency latency;
+        latency.median_us = us;
+        return latency;
+    }
+
+    static DbLatency lognormal(double median_us, double sigma) {
+        DbLatency latency;
+        latency.kind = Kind::LOGNORMAL;
+        latency.median_us = median_us;
+        latency.sigma = sigma;
+        return latency;
+    }
+
+    static DbLatency spikes(double base_us, double rate, double spike_us) {
+        DbLatency latency;
+        latency.kind = Kind::SPIKE;
+        latency.median_us = base_us;
+        latency.spike_rate = rate;
+        latency.spike_us = spike_us;
+        return latency;
+    }
+
+    DbLatency& with_failures(double rate) {
+        failure_rate = rate;
+        return *this;
+    }
+
+    // 采样一次耗时
+    template <typename Rng>
+    uint64_t sample_us(Rng& rng) const {
+        double us = median_us;
+        if (kind == Kind::LOGNORMAL && sigma > 0) {
+            std::lognormal_distribution<double> dist(std::log(median_us > 0 ? median_us : 1.0), sigma);
+            us = dist(rng);
+        }
+        else if (kind == Kind::SPIKE && spike_rate > 0 && std::bernoulli_distribution(spike_rate)(rng)) {
+            us = spike_us;
+        }
+        return us > 0 ? static_cast<uint64_t>(us) : 0;
+    }
+
+    // 采样一次是否失败
+    template <typename Rng>
+    bool sample_failure(Rng& rng) const {
+        return failure_rate > 0 && std::bernoulli_distribution(failure_rate)(rng);
+    }
+
+    // 简短描述，用于日志和基准输出
+    std::string describe() const {
+        char buf[96];
+        switch (kind) {
+        case Kind::LOGNORMAL:
+            std::snprintf(buf, sizeof(buf), "lognormal(%.0fus,%.2f)", median_us, sigma);
+            break;
+        case Kind::SPIKE:
+            std::snprintf(buf, sizeof(buf), "spike(%.0fus,%g%%@%.0fus)", median_us, spike_rate * 100, spike_us);
+            break;
+        default:
+            std::snprintf(buf, sizeof(buf), "fixed(%.0fus)", median_us);
+            break;
+        }
+        std::string text = buf;
+        if (failure_rate > 0) {
+            std::snprintf(buf, sizeof(buf), "+fail(%g%%)", failure_rate * 100);
+            text += buf;
+        }
+        return text;
+    }
+};
+
+#endif
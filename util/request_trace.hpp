@@ -0,0 +1,199 @@
+#ifndef REQUEST_TRACE_H
+#define REQUEST_TRACE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "thread_role.hpp"
+
+// 请求阶段追踪：按采样率选中的请求在各阶段记录 [开始, 结束)（steady_clock 纳秒），
+// 事件写入当前线程自己的环形缓冲区（写满后覆盖最旧的），导出时读取所有线程的缓冲区。
+// 未被采样的请求追踪 ID 为 0，各记录点只做一次判断
+
+struct TraceEvent {
+    const char* name;   // 阶段名（静态字符串）
+    uint64_t trace_id;
+    uint64_t start_ns;
+    uint64_t end_ns;
+};
+
+// 单个线程的事件缓冲区：只由所属线程写入，导出线程随时读取。
+// 写入前先推进 claimed，读取方据此丢弃复制期间可能被覆盖的槽位
+class TraceBuffer {
+public:
+    TraceBuffer(size_t capacity, uint32_t tid, ThreadRole role) : m_tid(tid), m_role(role) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        m_slots.reset(new Slot[size]);
+        m_mask = size - 1;
+    }
+
+    void record(const char* name, uint64_t trace_id, uint64_t start_ns, uint64_t end_ns) {
+        const uint64_t index = m_written.load(std::memory_order_relaxed);
+        m_claimed.store(index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        Slot& slot = m_slots[index & m_mask];
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.trace_id.store(trace_id, std::memory_order_relaxed);
+        slot.start_ns.store(start_ns, std::memory_order_relaxed);
+        slot.end_ns.store(end_ns, std::memory_order_relaxed);
+        m_written.store(index + 1, std::memory_order_release);
+    }
+
+    // 追加缓冲区中现存的事件
+    void snapshot(std::vector<TraceEvent>& out) const {
+        const uint64_t written = m_written.load(std::memory_order_acquire);
+        const uint64_t capacity = m_mask + 1;
+        const uint64_t first = written > capacity ? written - capacity : 0;
+        const size_t base = out.size();
+        for (uint64_t i = first; i < written; ++i) {
+            const Slot& slot = m_slots[i & m_mask];
+            out.push_back(TraceEvent{slot.name.load(std::memory_order_relaxed),
+                                     slot.trace_id.load(std::memory_order_relaxed),
+                                     slot.start_ns.load(std::memory_order_relaxed),
+                                     slot.end_ns.load(std::memory_order_relaxed)});
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // 复制期间写入方占用过的槽位内容不可信，丢弃
+        const uint64_t claimed = m_claimed.load(std::memory_order_relaxed);
+        const uint64_t valid_from = claimed > capacity ? claimed - capacity : 0;
+        if (valid_from > first) {
+            const size_t drop = static_cast<size_t>(std::min(valid_from - first, written - first));
+            out.erase(out.begin() + static_cast<std::ptrdiff_t>(base),
+                      out.begin() + static_cast<std::ptrdiff_t>(base + drop));
+        }
+    }
+
+    uint32_t tid() const { return m_tid; }
+    ThreadRole role() const { return m_role; }
+
+private:
+    struct Slot {
+        std::atomic<const char*> name{nullptr};
+        std::atomic<uint64_t> trace_id{0};
+        std::atomic<uint64_t> start_ns{0};
+        std::atomic<uint64_t> end_ns{0};
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    size_t m_mask;
+    std::atomic<uint64_t> m_written{0};
+    std::atomic<uint64_t> m_claimed{0};
+    const uint32_t m_tid;
+    const ThreadRole m_role;
+};
+
+class RequestTracer {
+public:
+    static RequestTracer* GetInstance() {
+        static RequestTracer tracer;
+        return &tracer;
+    }
+
+    // sample_rate：每 N 个请求追踪一个，0 为关闭；buffer_events：每个线程保留的事件数
+    void configure(uint32_t sample_rate, size_t buffer_events) {
+        m_buffer_events.store(std::max<size_t>(2, buffer_events), std::memory_order_relaxed);
+        m_sample_rate.store(sample_rate, std::memory_order_relaxed);
+    }
+
+    bool enabled() const { return m_sample_rate.load(std::memory_order_relaxed) > 0; }
+
+    // 新请求是否追踪：返回追踪 ID，不追踪时返回 0（每个线程各自计数）
+    uint64_t sample() {
+        const uint32_t rate = m_sample_rate.load(std::memory_order_relaxed);
+        if (rate == 0) return 0;
+        static thread_local uint32_t counter = 0;
+        if (counter++ % rate != 0) return 0;
+        return m_next_id.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void record(const char* name, uint64_t trace_id, uint64_t start_ns, uint64_t end_ns) {
+        if (trace_id == 0) return;
+        local().record(name, trace_id, start_ns, end_ns);
+    }
+
+    // 所有线程的缓冲区（线程退出后缓冲区保留）
+    std::vector<const TraceBuffer*> buffers() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<const TraceBuffer*> result;
+        for (const auto& buffer : m_buffers) {
+            result.push_back(buffer.get());
+        }
+        return result;
+    }
+
+    static uint64_t now_ns() { return to_ns(std::chrono::steady_clock::now()); }
+    static uint64_t to_ns(std::chrono::steady_clock::time_point t) {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count());
+    }
+
+private:
+    RequestTracer() = default;
+
+    TraceBuffer& local() {
+        static thread_local TraceBuffer* buffer = nullptr;
+        if (!buffer) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_buffers.push_back(std::make_unique<TraceBuffer>(m_buffer_events.load(std::memory_order_relaxed),
+                                                              static_cast<uint32_t>(m_buffers.size() + 1),
+                                                              current_thread_role()));
+            buffer = m_buffers.back().get();
+        }
+        return *buffer;
+    }
+
+private:
+    std::atomic<uint32_t> m_sample_rate{0};
+    std::atomic<size_t> m_buffer_events{65536};
+    std::atomic<uint64_t> m_next_id{1};
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<TraceBuffer>> m_buffers;
+};
+
+// 当前线程正在处理的请求的追踪 ID（DB 线程执行处理函数期间设置，供连接池等记录点使用）
+inline uint64_t& current_trace_id() {
+    static thread_local uint64_t id = 0;
+    return id;
+}
+
+// 在作用域内设置当前追踪 ID
+class TraceScope {
+public:
+    explicit TraceScope(uint64_t trace_id) : m_saved(current_trace_id()) { current_trace_id() = trace_id; }
+    ~TraceScope() { current_trace_id() = m_saved; }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    uint64_t m_saved;
+};
+
+// 记录作用域的耗时，属于当前追踪 ID（为 0 时不读时钟）
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name)
+        : m_name(name), m_trace_id(current_trace_id()), m_start(m_trace_id ? RequestTracer::now_ns() : 0) {}
+    ~TraceSpan() {
+        if (m_trace_id) {
+            RequestTracer::GetInstance()->record(m_name, m_trace_id, m_start, RequestTracer::now_ns());
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* m_name;
+    uint64_t m_trace_id;
+    uint64_t m_start;
+};
+
+#endif
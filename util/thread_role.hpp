@@ -0,0 +1,19 @@
+#ifndef THREAD_ROLE_H
+#define THREAD_ROLE_H
+
+// 当前线程的角色，用于统计网络线程在阻塞操作上花费的时间
+enum class ThreadRole {
+    OTHER,     // 主线程等
+    NETWORK,   // 运行 io_context 的网络线程
+    DB         // 执行阻塞数据库操作的工作线程
+};
+
+inline ThreadRole& current_thread_role() {
+    static thread_local ThreadRole role = ThreadRole::OTHER;
+    return role;
+}
+
+inline void set_thread_role(ThreadRole role) { current_thread_role() = role; }
+inline bool is_network_thread() { return current_thread_role() == ThreadRole::NETWORK; }
+
+#endif